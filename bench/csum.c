@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include <csum.h>
+
+// Lengths to benchmark (bytes).
+static const unsigned lengths[] = { 20, 40, 64, 128, 256, 512, 1024, 1500, 4096, 9000 };
+
+#define LENGTH_CNT (sizeof(lengths) / sizeof(lengths[0]))
+
+// Cold runs walk this much memory so buffers come from DRAM instead of cache.
+#define COLD_POOL_SIZE (256ULL * 1024 * 1024)
+
+// Minimum amount of bytes to process per measurement.
+#define MIN_BYTES (64ULL * 1024 * 1024)
+
+// Packets handed to the batch checksums per call.
+#define BURST (CSUM_BATCH_LANES * 4)
+
+typedef struct bench_kernel
+{
+    const char *name;
+    unsigned (*run)(unsigned char *dst, const unsigned char *src, unsigned len);
+    unsigned min_len;
+    unsigned max_len;
+
+    // Packets of len bytes laid out back to back in dst per call (0 => 1).
+    unsigned burst;
+
+    // Writes the headers each packet in dst needs before timing starts (optional).
+    void (*setup)(unsigned char *pkt, unsigned len);
+} bench_kernel_t;
+
+static csum_kernel_fn cur_kernel;
+
+static unsigned run_do_csum(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    (void)dst;
+
+    return cur_kernel(src, len);
+}
+
+static unsigned run_csum_partial(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    (void)dst;
+
+    return csum_partial(src, len, 0);
+}
+
+static unsigned run_csum_partial_copy(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    return csum_partial_copy(dst, src, len, 0);
+}
+
+static unsigned run_csum_partial_copy_nt(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    return csum_partial_copy_nt(dst, src, len, 0);
+}
+
+static unsigned run_ip_fast_csum(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    (void)dst;
+    (void)len;
+
+    return ip_fast_csum(src, 5);
+}
+
+static unsigned run_tcp_checksum(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    (void)dst;
+
+    u32 saddr = 0x0100000a;
+    u32 daddr = 0x0200000a;
+
+    return tcp_checksum(src, len, &saddr, &daddr);
+}
+
+static unsigned run_csum_flow_l4(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    (void)dst;
+
+    static struct csum_flow flow;
+
+    if (flow.proto == 0)
+    {
+        csum_flow_init(&flow, 0x0100000a, 0x0200000a, IPPROTO_UDP);
+    }
+
+    return csum_flow_l4(&flow, src, len);
+}
+
+static unsigned run_icmp_csum(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    (void)dst;
+
+    return icmp_csum((u16 *)src, len);
+}
+
+static unsigned run_udp_checksum(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    u32 saddr = 0x0100000a;
+    u32 daddr = 0x0200000a;
+
+    (void)dst;
+
+    return udp_checksum(src, len, &saddr, &daddr);
+}
+
+static unsigned run_csum_ipv6_magic(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    static const struct in6_addr saddr = { { { 0x20, 0x01, 0x0d, 0xb8, [15] = 1 } } };
+    static const struct in6_addr daddr = { { { 0x20, 0x01, 0x0d, 0xb8, [15] = 2 } } };
+
+    (void)dst;
+
+    return csum_ipv6_magic(&saddr, &daddr, len, IPPROTO_UDP, csum_partial(src, len, 0));
+}
+
+/**
+ * Writes an option-less IPv4 header with a valid checksum followed by a zeroed layer-4 header.
+ *
+ * @param pkt The packet.
+ * @param len The packet length.
+ * @param proto The layer-4 protocol.
+ *
+ * @return Void
+**/
+static void setup_ipv4(unsigned char *pkt, unsigned len, u8 proto)
+{
+    struct iphdr *iph = (struct iphdr *)pkt;
+
+    memset(pkt, 0, len < 40 ? len : 40);
+
+    iph->version = 4;
+    iph->ihl = 5;
+    iph->ttl = 64;
+    iph->protocol = proto;
+    iph->tot_len = htons(len);
+    iph->saddr = 0x0100000a;
+    iph->daddr = 0x0200000a;
+
+    update_iph_checksum(iph);
+
+    // Patching leaves UDP packets whose checksum is disabled (zero) alone.
+    if (proto == IPPROTO_UDP && len >= 28)
+    {
+        pkt[20 + CSUM_UDP_CHECK_OFF] = 0xff;
+    }
+}
+
+static void setup_tcp(unsigned char *pkt, unsigned len)
+{
+    setup_ipv4(pkt, len, IPPROTO_TCP);
+}
+
+static void setup_udp(unsigned char *pkt, unsigned len)
+{
+    setup_ipv4(pkt, len, IPPROTO_UDP);
+}
+
+static void setup_icmp(unsigned char *pkt, unsigned len)
+{
+    setup_ipv4(pkt, len, IPPROTO_ICMP);
+}
+
+/**
+ * Points hdrs at the BURST packets of len bytes laid out back to back at pkts.
+ *
+ * @param pkts The first packet.
+ * @param len The packet length.
+ * @param hdrs The headers to fill in.
+ *
+ * @return Void
+**/
+static inline void burst_hdrs(unsigned char *pkts, unsigned len, struct iphdr **hdrs)
+{
+    for (int i = 0; i < BURST; i++)
+    {
+        hdrs[i] = (struct iphdr *)(pkts + (u64)i * len);
+    }
+}
+
+static unsigned run_csum_batch_ipv4_hdr(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    struct iphdr *hdrs[BURST];
+
+    (void)src;
+
+    burst_hdrs(dst, len, hdrs);
+    csum_batch_ipv4_hdr(hdrs, BURST);
+
+    return hdrs[BURST - 1]->check;
+}
+
+static unsigned run_csum_batch_tcp(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    struct iphdr *hdrs[BURST];
+
+    (void)src;
+
+    burst_hdrs(dst, len, hdrs);
+    csum_batch_tcp(hdrs, BURST);
+
+    return dst[20 + CSUM_TCP_CHECK_OFF];
+}
+
+static unsigned run_csum_batch_udp(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    struct iphdr *hdrs[BURST];
+
+    (void)src;
+
+    burst_hdrs(dst, len, hdrs);
+    csum_batch_udp(hdrs, BURST);
+
+    return dst[20 + CSUM_UDP_CHECK_OFF];
+}
+
+static unsigned run_csum_batch_icmp(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    struct iphdr *hdrs[BURST];
+
+    (void)src;
+
+    burst_hdrs(dst, len, hdrs);
+    csum_batch_icmp(hdrs, BURST);
+
+    return dst[20 + CSUM_ICMP_CHECK_OFF];
+}
+
+static unsigned run_csum_patch_ipv4_l3(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    static u16 id;
+    struct iphdr *iph = (struct iphdr *)dst;
+
+    (void)src;
+    (void)len;
+
+    // Rewrite the ID like a sender stamping consecutive packets.
+    struct csum_patch patch = { CSUM_PATCH_OFF_IP_ID, 2, htons(++id) };
+
+    csum_patch_ipv4(iph, &patch, 1, CSUM_PATCH_L3);
+
+    return iph->check;
+}
+
+static unsigned run_csum_patch_ipv4_l4(unsigned char *dst, const unsigned char *src, unsigned len)
+{
+    static u32 n;
+    struct iphdr *iph = (struct iphdr *)dst;
+
+    (void)src;
+    (void)len;
+
+    // Rewrite the source address and port like a source range or NAT would.
+    n++;
+
+    struct csum_patch patches[] =
+    {
+        { CSUM_PATCH_OFF_IP_SADDR, 4, htonl(0x0a000000 | (n & 0xffffff)) },
+        { CSUM_PATCH_OFF_L4_SPORT(5), 2, htons((u16)n) },
+    };
+
+    csum_patch_ipv4(iph, patches, 2, CSUM_PATCH_L3 | CSUM_PATCH_L4);
+
+    return iph->check;
+}
+
+static const char *kernel_names[CSUM_KERNEL_MAX] = { "auto", "generic", "x86", "avx2", "avx512" };
+
+static inline u64 read_cycles()
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static inline u64 read_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Runs a single kernel over one length/alignment/cache combination and prints a result row.
+ *
+ * @param k The kernel to run.
+ * @param pool The source pool.
+ * @param dst_pool The destination pool (used by copy kernels).
+ * @param len The buffer length.
+ * @param align The offset added to each buffer's address.
+ * @param cold Whether to walk the whole pool (cold) or reuse one buffer (hot).
+ *
+ * @return Void
+**/
+static void bench_one(const bench_kernel_t *k, unsigned char *pool, unsigned char *dst_pool, unsigned len, unsigned align, int cold)
+{
+    unsigned burst = k->burst ? k->burst : 1;
+    u64 call_len = (u64)len * burst;
+
+    // Keep buffers on separate cache lines (and pages for larger ones) when cold.
+    u64 stride = (call_len + align + 4095) & ~4095ULL;
+    u64 slots = cold ? COLD_POOL_SIZE / stride : 1;
+    u64 iters = MIN_BYTES / call_len;
+
+    if (iters < 1000)
+    {
+        iters = 1000;
+    }
+
+    if (k->setup != NULL)
+    {
+        for (u64 slot = 0; slot < slots; slot++)
+        {
+            for (unsigned i = 0; i < burst; i++)
+            {
+                k->setup(dst_pool + slot * stride + align + (u64)i * len, len);
+            }
+        }
+    }
+
+    volatile unsigned sink = 0;
+    u64 slot = 0;
+
+    // Warm up.
+    for (u64 i = 0; i < 1000; i++)
+    {
+        sink += k->run(dst_pool + align, pool + align, len);
+    }
+
+    u64 start_ns = read_ns();
+    u64 start_cycles = read_cycles();
+
+    for (u64 i = 0; i < iters; i++)
+    {
+        u64 off = slot * stride + align;
+
+        sink += k->run(dst_pool + off, pool + off, len);
+
+        if (++slot == slots)
+        {
+            slot = 0;
+        }
+    }
+
+    u64 cycles = read_cycles() - start_cycles;
+    u64 ns = read_ns() - start_ns;
+
+    double bytes = (double)iters * call_len;
+
+    fprintf(stdout, "%-24s %6u %5s %4s %10.3f %10.2f %10.1f\n", k->name, len, align ? "odd" : "align", cold ? "cold" : "hot", cycles / bytes, bytes / ns, (double)ns / iters);
+
+    (void)sink;
+}
+
+int main(int argc, char *argv[])
+{
+    // Optional filter on kernel names.
+    const char *filter = argc > 1 ? argv[1] : NULL;
+
+    unsigned char *pool = aligned_alloc(4096, COLD_POOL_SIZE);
+    unsigned char *dst_pool = aligned_alloc(4096, COLD_POOL_SIZE);
+
+    if (pool == NULL || dst_pool == NULL)
+    {
+        fprintf(stderr, "Failed to allocate benchmark pools.\n");
+
+        return EXIT_FAILURE;
+    }
+
+    for (u64 i = 0; i < COLD_POOL_SIZE; i++)
+    {
+        pool[i] = (unsigned char) rand();
+    }
+
+    memset(dst_pool, 0, COLD_POOL_SIZE);
+
+    bench_kernel_t kernels[] =
+    {
+        {"do_csum (generic)", run_do_csum, 0, 0, 0, NULL},
+        {"do_csum (x86)", run_do_csum, 0, 0, 0, NULL},
+        {"do_csum (avx2)", run_do_csum, 0, 0, 0, NULL},
+        {"do_csum (avx512)", run_do_csum, 0, 0, 0, NULL},
+        {"csum_partial", run_csum_partial, 0, 0, 0, NULL},
+        {"csum_partial_copy", run_csum_partial_copy, 0, 0, 0, NULL},
+        {"csum_partial_copy_nt", run_csum_partial_copy_nt, 0, 0, 0, NULL},
+        {"ip_fast_csum", run_ip_fast_csum, 20, 20, 0, NULL},
+        {"tcp_checksum", run_tcp_checksum, 0, 0, 0, NULL},
+        {"csum_flow_l4 (udp)", run_csum_flow_l4, 0, 0, 0, NULL},
+        {"icmp_csum", run_icmp_csum, 0, 0, 0, NULL},
+        {"udp_checksum", run_udp_checksum, 0, 0, 0, NULL},
+        {"csum_ipv6_magic", run_csum_ipv6_magic, 0, 0, 0, NULL},
+        {"csum_batch_ipv4_hdr", run_csum_batch_ipv4_hdr, 20, 20, BURST, setup_udp},
+        {"csum_batch_tcp", run_csum_batch_tcp, 40, 0, BURST, setup_tcp},
+        {"csum_batch_udp", run_csum_batch_udp, 28, 0, BURST, setup_udp},
+        {"csum_batch_icmp", run_csum_batch_icmp, 28, 0, BURST, setup_icmp},
+        {"csum_patch_ipv4 (l3)", run_csum_patch_ipv4_l3, 40, 40, 0, setup_tcp},
+        {"csum_patch_ipv4 (l4)", run_csum_patch_ipv4_l4, 40, 40, 0, setup_tcp},
+    };
+
+    fprintf(stdout, "%-24s %6s %5s %4s %10s %10s %10s\n", "Kernel", "Len", "Align", "Mem", "Cyc/Byte", "GB/s", "ns/call");
+
+    for (unsigned i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++)
+    {
+        bench_kernel_t *k = &kernels[i];
+
+        if (filter && strstr(k->name, filter) == NULL)
+        {
+            continue;
+        }
+
+        // The do_csum() rows each pin a specific kernel.
+        if (k->run == run_do_csum)
+        {
+            for (int kern = CSUM_KERNEL_GENERIC; kern < CSUM_KERNEL_MAX; kern++)
+            {
+                if (strstr(k->name, kernel_names[kern]) != NULL)
+                {
+                    cur_kernel = csum_kernel_get(kern);
+                }
+            }
+
+            if (cur_kernel == NULL)
+            {
+                fprintf(stdout, "%-24s (not supported on this CPU/build)\n", k->name);
+
+                continue;
+            }
+        }
+
+        for (unsigned j = 0; j < LENGTH_CNT; j++)
+        {
+            unsigned len = lengths[j];
+
+            if ((k->min_len && len < k->min_len) || (k->max_len && len > k->max_len))
+            {
+                continue;
+            }
+
+            for (int cold = 0; cold < 2; cold++)
+            {
+                for (unsigned align = 0; align < 2; align++)
+                {
+                    bench_one(k, pool, dst_pool, len, align, cold);
+                }
+            }
+        }
+
+        cur_kernel = NULL;
+
+        fprintf(stdout, "\n");
+    }
+
+    free(pool);
+    free(dst_pool);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/**
+ * Allocates memory from an arena. Memory is only released all at once with arena_free().
+ * 
+ * @param arena A pointer to the arena.
+ * @param size The amount of bytes to allocate.
+ * @param align The alignment (a power of two up to 64).
+ * 
+ * @return A pointer to the memory or NULL on failure.
+**/
+void *arena_alloc(arena_t *arena, size_t size, size_t align)
+{
+    arena_chunk_t *chunk = arena->head;
+
+    if (chunk != NULL)
+    {
+        size_t off = (chunk->used + align - 1) & ~(align - 1);
+
+        if (off + size <= chunk->size)
+        {
+            chunk->used = off + size;
+
+            return chunk->data + off;
+        }
+    }
+
+    size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+
+    // Chunk data starts on a cache line, so offsets within a chunk are aligned the same as addresses.
+    chunk = aligned_alloc(64, (sizeof(arena_chunk_t) + chunk_size + 63) & ~(size_t)63);
+
+    if (chunk == NULL)
+    {
+        return NULL;
+    }
+
+    chunk->size = chunk_size;
+    chunk->used = 0;
+
+    // Keep allocating from whichever chunk has more room left.
+    if (arena->head != NULL && arena->head->size - arena->head->used > chunk_size - size)
+    {
+        chunk->next = arena->head->next;
+        arena->head->next = chunk;
+    }
+    else
+    {
+        chunk->next = arena->head;
+        arena->head = chunk;
+    }
+
+    chunk->used = size;
+
+    return chunk->data;
+}
+
+/**
+ * Allocates zeroed memory for an array from an arena.
+ * 
+ * @param arena A pointer to the arena.
+ * @param count The amount of elements.
+ * @param size The size of each element.
+ * 
+ * @return A pointer to the memory or NULL on failure (including overflow).
+**/
+void *arena_calloc(arena_t *arena, size_t count, size_t size)
+{
+    if (size != 0 && count > (size_t)-1 / size)
+    {
+        return NULL;
+    }
+
+    void *mem = arena_alloc(arena, count * size, 16);
+
+    if (mem != NULL)
+    {
+        memset(mem, 0, count * size);
+    }
+
+    return mem;
+}
+
+/**
+ * Copies a string into an arena.
+ * 
+ * @param arena A pointer to the arena.
+ * @param str The string (may be NULL).
+ * 
+ * @return A pointer to the copy or NULL if the string is NULL or on failure.
+**/
+char *arena_strdup(arena_t *arena, const char *str)
+{
+    if (str == NULL)
+    {
+        return NULL;
+    }
+
+    size_t len = strlen(str) + 1;
+    char *copy = arena_alloc(arena, len, 1);
+
+    if (copy != NULL)
+    {
+        memcpy(copy, str, len);
+    }
+
+    return copy;
+}
+
+/**
+ * Frees everything allocated from an arena. The arena can be reused afterwards.
+ * 
+ * @param arena A pointer to the arena.
+ * 
+ * @return Void
+**/
+void arena_free(arena_t *arena)
+{
+    arena_chunk_t *chunk = arena->head;
+
+    while (chunk != NULL)
+    {
+        arena_chunk_t *next = chunk->next;
+
+        free(chunk);
+
+        chunk = next;
+    }
+
+    arena->head = NULL;
+}
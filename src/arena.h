@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "simple_types.h"
+
+// Default size of each arena chunk (larger allocations get a chunk of their own).
+#define ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct arena_chunk
+{
+    struct arena_chunk *next;
+    size_t size;
+    size_t used;
+    u8 data[] __attribute__((aligned(64)));
+} arena_chunk_t;
+
+typedef struct arena
+{
+    arena_chunk_t *head;
+} arena_t;
+
+void *arena_alloc(arena_t *arena, size_t size, size_t align);
+void *arena_calloc(arena_t *arena, size_t count, size_t size);
+char *arena_strdup(arena_t *arena, const char *str);
+void arena_free(arena_t *arena);
@@ -0,0 +1,632 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cfg_cache.h"
+#include "hash.h"
+
+typedef struct cc_buf
+{
+    u8 *data;
+    size_t len;
+    size_t cap;
+
+    u64 *relocs;
+    size_t reloc_cnt;
+    size_t reloc_cap;
+
+    int failed;
+} cc_buf_t;
+
+/**
+ * Computes the fingerprint of the struct layouts stored in a cache.
+ * 
+ * @return The fingerprint.
+**/
+static u64 cc_abi()
+{
+    const u64 sizes[] =
+    {
+        sizeof(void *), sizeof(sequence_t), sizeof(payload_opt_t), sizeof(ip_opt_t), sizeof(ip_range_t), sizeof(range_table_t),
+        offsetof(sequence_t, ip), offsetof(sequence_t, pls), offsetof(ip_opt_t, range_tbl), offsetof(payload_opt_t, data)
+    };
+
+    return hash64(sizes, sizeof(sizes), CFG_CACHE_VERSION);
+}
+
+/**
+ * Appends data to a cache buffer.
+ * 
+ * @param buf A pointer to the buffer.
+ * @param src The data (NULL = zeroes).
+ * @param len The data length.
+ * @param align The alignment of the data within the file.
+ * 
+ * @return The data's offset or 0 on failure.
+**/
+static u64 cc_put(cc_buf_t *buf, const void *src, size_t len, size_t align)
+{
+    size_t off = (buf->len + align - 1) & ~(align - 1);
+
+    if (off + len > buf->cap)
+    {
+        size_t cap = buf->cap ? buf->cap : 65536;
+
+        while (cap < off + len)
+        {
+            cap *= 2;
+        }
+
+        u8 *data = realloc(buf->data, cap);
+
+        if (data == NULL)
+        {
+            buf->failed = 1;
+
+            return 0;
+        }
+
+        buf->data = data;
+        buf->cap = cap;
+    }
+
+    memset(buf->data + buf->len, 0, off - buf->len);
+
+    if (src != NULL)
+    {
+        memcpy(buf->data + off, src, len);
+    }
+    else
+    {
+        memset(buf->data + off, 0, len);
+    }
+
+    buf->len = off + len;
+
+    return off;
+}
+
+/**
+ * Stores an offset in a pointer field and records the field for relocation.
+ * 
+ * @param buf A pointer to the buffer.
+ * @param field The field's offset.
+ * @param target The target's offset (0 = NULL).
+ * 
+ * @return Void
+**/
+static void cc_ptr(cc_buf_t *buf, u64 field, u64 target)
+{
+    memcpy(buf->data + field, &target, sizeof(target));
+
+    if (target == 0)
+    {
+        return;
+    }
+
+    if (buf->reloc_cnt >= buf->reloc_cap)
+    {
+        size_t cap = buf->reloc_cap ? buf->reloc_cap * 2 : 1024;
+        u64 *relocs = realloc(buf->relocs, sizeof(u64) * cap);
+
+        if (relocs == NULL)
+        {
+            buf->failed = 1;
+
+            return;
+        }
+
+        buf->relocs = relocs;
+        buf->reloc_cap = cap;
+    }
+
+    buf->relocs[buf->reloc_cnt++] = field;
+}
+
+/**
+ * Appends a string and points a field at it.
+ * 
+ * @param buf A pointer to the buffer.
+ * @param field The pointer field's offset.
+ * @param str The string (may be NULL).
+ * 
+ * @return Void
+**/
+static void cc_str(cc_buf_t *buf, u64 field, const char *str)
+{
+    cc_ptr(buf, field, str ? cc_put(buf, str, strlen(str) + 1, 1) : 0);
+}
+
+/**
+ * Appends an array of strings and points a field at it.
+ * 
+ * @param buf A pointer to the buffer.
+ * @param field The pointer field's offset.
+ * @param strs The strings (may be NULL).
+ * @param cnt The amount of strings.
+ * 
+ * @return Void
+**/
+static void cc_strs(cc_buf_t *buf, u64 field, char **strs, int cnt)
+{
+    if (strs == NULL || cnt < 1)
+    {
+        cc_ptr(buf, field, 0);
+
+        return;
+    }
+
+    u64 arr = cc_put(buf, NULL, sizeof(char *) * cnt, sizeof(char *));
+
+    cc_ptr(buf, field, arr);
+
+    for (int i = 0; i < cnt && !buf->failed; i++)
+    {
+        cc_str(buf, arr + sizeof(char *) * i, strs[i]);
+    }
+}
+
+/**
+ * Appends a sequence's arrays and strings and relocates its pointers.
+ * 
+ * @param buf A pointer to the buffer.
+ * @param base The sequence's offset.
+ * @param seq A pointer to the original sequence.
+ * 
+ * @return Void
+**/
+static void cc_sequence(cc_buf_t *buf, u64 base, const sequence_t *seq)
+{
+    cc_str(buf, base + offsetof(sequence_t, interface), seq->interface);
+    cc_str(buf, base + offsetof(sequence_t, cpus), seq->cpus);
+    cc_strs(buf, base + offsetof(sequence_t, includes), seq->includes, seq->include_count);
+
+    cc_str(buf, base + offsetof(sequence_t, eth.src_mac), seq->eth.src_mac);
+    cc_str(buf, base + offsetof(sequence_t, eth.dst_mac), seq->eth.dst_mac);
+
+    cc_str(buf, base + offsetof(sequence_t, ip.protocol), seq->ip.protocol);
+    cc_str(buf, base + offsetof(sequence_t, ip.src_ip), seq->ip.src_ip);
+    cc_str(buf, base + offsetof(sequence_t, ip.dst_ip), seq->ip.dst_ip);
+    cc_strs(buf, base + offsetof(sequence_t, ip.ranges), seq->ip.ranges, seq->ip.range_count);
+
+    u64 weights = seq->ip.range_weights && seq->ip.range_count ? cc_put(buf, seq->ip.range_weights, sizeof(u32) * seq->ip.range_count, sizeof(u32)) : 0;
+    cc_ptr(buf, base + offsetof(sequence_t, ip.range_weights), weights);
+
+    u64 entries = seq->ip.range_tbl.entries && seq->ip.range_tbl.count ? cc_put(buf, seq->ip.range_tbl.entries, sizeof(ip_range_t) * seq->ip.range_tbl.count, 64) : 0;
+    cc_ptr(buf, base + offsetof(sequence_t, ip.range_tbl.entries), entries);
+
+    if (seq->pls == NULL || seq->pl_cnt < 1)
+    {
+        cc_ptr(buf, base + offsetof(sequence_t, pls), 0);
+
+        return;
+    }
+
+    u64 pls = cc_put(buf, seq->pls, sizeof(payload_opt_t) * seq->pl_cnt, 64);
+
+    cc_ptr(buf, base + offsetof(sequence_t, pls), pls);
+
+    for (int i = 0; i < seq->pl_cnt && !buf->failed; i++)
+    {
+        const payload_opt_t *pl = &seq->pls[i];
+        u64 pl_off = pls + sizeof(payload_opt_t) * i;
+
+        cc_str(buf, pl_off + offsetof(payload_opt_t, exact), pl->exact);
+
+        // Decoded payloads start on a cache line.
+        cc_ptr(buf, pl_off + offsetof(payload_opt_t, data), pl->data ? cc_put(buf, pl->data, pl->data_len, 64) : 0);
+    }
+}
+
+/**
+ * Chains a dependency's contents into a cache key. Missing files hash to a fixed marker so a cache goes stale once they appear.
+ * 
+ * @param path The file's path.
+ * @param hash A pointer to the running hash.
+ * 
+ * @return 0 on success or -1 if the file exists but can't be read.
+**/
+static int cc_hash_dep(const char *path, u64 *hash)
+{
+    if (hash_file(path, *hash, hash) == 0)
+    {
+        return 0;
+    }
+
+    if (errno != ENOENT)
+    {
+        return -1;
+    }
+
+    *hash = hash_mix(*hash ^ HASH_K0);
+
+    return 0;
+}
+
+/**
+ * Collects the files a config was built from (the config itself, includes, and payload files).
+ * 
+ * @param file_name The config file.
+ * @param cfg A pointer to the config structure.
+ * @param seq_cnt The amount of sequences.
+ * @param buf A pointer to the buffer to append the NUL-separated paths to.
+ * @param hash A pointer to store the content hash of the files in.
+ * 
+ * @return The amount of files or -1 if one can't be read.
+**/
+static int cc_deps(const char *file_name, config_t *cfg, int seq_cnt, cc_buf_t *buf, u64 *hash)
+{
+    int cnt = 0;
+
+    *hash = CFG_CACHE_VERSION;
+
+    for (int i = -1; i < seq_cnt; i++)
+    {
+        const sequence_t *seq = i >= 0 ? &cfg->seq[i] : NULL;
+        int n = i < 0 ? 1 : seq->include_count + seq->pl_cnt;
+
+        for (int j = 0; j < n; j++)
+        {
+            const char *path;
+
+            if (seq == NULL)
+            {
+                path = file_name;
+            }
+            else if (j < seq->include_count)
+            {
+                path = seq->includes[j];
+            }
+            else
+            {
+                const payload_opt_t *pl = &seq->pls[j - seq->include_count];
+
+                if (!pl->is_static || !pl->is_file || pl->exact == NULL)
+                {
+                    continue;
+                }
+
+                path = pl->exact;
+            }
+
+            if (cc_hash_dep(path, hash) != 0)
+            {
+                fprintf(stderr, "Failed to read '%s' for the config cache.\n", path);
+
+                return -1;
+            }
+
+            cc_put(buf, path, strlen(path) + 1, 1);
+            cnt++;
+        }
+    }
+
+    return cnt;
+}
+
+/**
+ * Builds the default cache path for a config file.
+ * 
+ * @param file_name The config file.
+ * @param path A buffer to store the path in.
+ * @param len The buffer's size.
+ * 
+ * @return 0 on success or -1 if the buffer is too small.
+**/
+int config_cache_path(const char *file_name, char *path, size_t len)
+{
+    int ret = snprintf(path, len, "%s" CFG_CACHE_EXT, file_name);
+
+    return ret < 0 || (size_t)ret >= len ? -1 : 0;
+}
+
+/**
+ * Writes a parsed config to a binary cache. Later runs map the cache instead of parsing (see load_config_cache()).
+ * 
+ * @param path The cache file to write (replaced atomically).
+ * @param file_name The config file the config was parsed from.
+ * @param cfg A pointer to the parsed config.
+ * @param seq_cnt The amount of sequences.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int save_config_cache(const char *path, const char *file_name, config_t *cfg, int seq_cnt)
+{
+    cc_buf_t buf = {0};
+    cfg_cache_hdr_t hdr = {0};
+    int ret = -1;
+
+    if (seq_cnt > cfg->seq_cap)
+    {
+        seq_cnt = cfg->seq_cap;
+    }
+
+    memcpy(hdr.magic, CFG_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = CFG_CACHE_VERSION;
+    hdr.seq_cnt = seq_cnt;
+    hdr.abi = cc_abi();
+
+    cc_put(&buf, NULL, sizeof(hdr), 64);
+
+    if (cfg->interface != NULL)
+    {
+        hdr.interface_off = cc_put(&buf, cfg->interface, strlen(cfg->interface) + 1, 1);
+    }
+
+    if (seq_cnt > 0)
+    {
+        hdr.seq_off = cc_put(&buf, cfg->seq, sizeof(sequence_t) * seq_cnt, 64);
+    }
+
+    for (int i = 0; i < seq_cnt && !buf.failed; i++)
+    {
+        u64 base = hdr.seq_off + sizeof(sequence_t) * i;
+
+        cc_sequence(&buf, base, &cfg->seq[i]);
+
+        // Ownership flags are set again on load.
+        buf.data[base + offsetof(sequence_t, ip.range_tbl.mapped)] = 0;
+    }
+
+    hdr.deps_off = buf.len;
+
+    int deps = cc_deps(file_name, cfg, seq_cnt, &buf, &hdr.hash);
+
+    if (deps < 0)
+    {
+        goto out;
+    }
+
+    hdr.dep_cnt = deps;
+    hdr.deps_len = buf.len - hdr.deps_off;
+
+    hdr.reloc_cnt = buf.reloc_cnt;
+    hdr.reloc_off = cc_put(&buf, buf.relocs, sizeof(u64) * buf.reloc_cnt, sizeof(u64));
+
+    hdr.size = buf.len;
+
+    if (buf.failed)
+    {
+        fprintf(stderr, "Failed to allocate memory for the config cache.\n");
+
+        goto out;
+    }
+
+    memcpy(buf.data, &hdr, sizeof(hdr));
+
+    // Write to a temporary file first so concurrent runs never map a partial cache.
+    char tmp[4096];
+    int tmp_len = snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+
+    if (tmp_len < 0 || (size_t)tmp_len >= sizeof(tmp))
+    {
+        fprintf(stderr, "Config cache path '%s' is too long.\n", path);
+
+        goto out;
+    }
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "Failed to create config cache '%s'.\n", tmp);
+
+        goto out;
+    }
+
+    size_t written = 0;
+
+    while (written < buf.len)
+    {
+        ssize_t n = write(fd, buf.data + written, buf.len - written);
+
+        if (n <= 0)
+        {
+            break;
+        }
+
+        written += n;
+    }
+
+    close(fd);
+
+    if (written != buf.len || rename(tmp, path) != 0)
+    {
+        fprintf(stderr, "Failed to write config cache '%s'.\n", path);
+
+        unlink(tmp);
+
+        goto out;
+    }
+
+    ret = 0;
+
+out:
+    free(buf.data);
+    free(buf.relocs);
+
+    return ret;
+}
+
+/**
+ * Maps a binary config cache into an empty config. Pointers are relocated in place (copy-on-write), so payload data and ranges are shared with the page cache and nothing is parsed.
+ * 
+ * @param path The cache file.
+ * @param file_name The config file the cache must have been built from.
+ * @param cfg A pointer to an empty config (see init_config()).
+ * @param seq_num A pointer to store the amount of sequences in.
+ * 
+ * @return 0 on success or 1 if the cache is missing, stale (any of its files changed), or unusable.
+**/
+int load_config_cache(const char *path, const char *file_name, config_t *cfg, int *seq_num)
+{
+    if (cfg->seq_cap > 0)
+    {
+        return 1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(cfg_cache_hdr_t))
+    {
+        close(fd);
+
+        return 1;
+    }
+
+    u8 *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (map == MAP_FAILED)
+    {
+        return 1;
+    }
+
+    cfg_cache_hdr_t *hdr = (cfg_cache_hdr_t *)map;
+    u64 size = st.st_size;
+
+    // Validate the header and every region before touching anything.
+    if (memcmp(hdr->magic, CFG_CACHE_MAGIC, sizeof(hdr->magic)) != 0 || hdr->version != CFG_CACHE_VERSION || hdr->abi != cc_abi() || hdr->size != size ||
+        hdr->seq_off + (u64)sizeof(sequence_t) * hdr->seq_cnt > size || hdr->interface_off >= size ||
+        hdr->reloc_off > size || hdr->reloc_cnt > (size - hdr->reloc_off) / sizeof(u64) ||
+        hdr->deps_off > size || hdr->deps_len > size - hdr->deps_off || hdr->deps_len < 1 || map[hdr->deps_off + hdr->deps_len - 1] != '\0')
+    {
+        goto stale;
+    }
+
+    // The cache must belong to this config and none of its files may have changed.
+    const char *dep = (const char *)map + hdr->deps_off;
+    u64 hash = CFG_CACHE_VERSION;
+
+    if (strcmp(dep, file_name) != 0)
+    {
+        goto stale;
+    }
+
+    for (u32 i = 0; i < hdr->dep_cnt; i++)
+    {
+        if (dep >= (const char *)map + hdr->deps_off + hdr->deps_len || cc_hash_dep(dep, &hash) != 0)
+        {
+            goto stale;
+        }
+
+        dep += strlen(dep) + 1;
+    }
+
+    if (hash != hdr->hash)
+    {
+        goto stale;
+    }
+
+    // Relocate pointers.
+    const u64 *relocs = (const u64 *)(map + hdr->reloc_off);
+
+    for (u64 i = 0; i < hdr->reloc_cnt; i++)
+    {
+        u64 val;
+
+        if (relocs[i] > size - sizeof(u64))
+        {
+            goto stale;
+        }
+
+        memcpy(&val, map + relocs[i], sizeof(val));
+
+        if (val >= size)
+        {
+            goto stale;
+        }
+
+        val += (u64)(uintptr_t)map;
+        memcpy(map + relocs[i], &val, sizeof(val));
+    }
+
+    sequence_t *seqs = (sequence_t *)(map + hdr->seq_off);
+
+    for (u32 i = 0; i < hdr->seq_cnt; i++)
+    {
+        seqs[i].ip.range_tbl.mapped = 1;
+    }
+
+    cfg->seq = hdr->seq_cnt > 0 ? seqs : NULL;
+    cfg->seq_cap = hdr->seq_cnt;
+    cfg->interface = hdr->interface_off ? (char *)map + hdr->interface_off : NULL;
+    cfg->map = map;
+    cfg->map_len = size;
+
+    *seq_num = hdr->seq_cnt;
+
+    return 0;
+
+stale:
+    munmap(map, st.st_size);
+
+    return 1;
+}
+
+/**
+ * Loads a config, from its binary cache when it's up to date and from JSON otherwise.
+ * 
+ * @param file_name The JSON config file.
+ * @param cache The cache file (NULL = the config path with CFG_CACHE_EXT appended).
+ * @param compile Whether to parse the JSON and (re)write the cache instead of loading it.
+ * @param cfg A pointer to an empty config (see init_config()).
+ * @param seq_num A pointer to store the amount of sequences in.
+ * @param log Whether to log parse details.
+ * 
+ * @return 0 on success or 1 on failure.
+**/
+int load_config(const char *file_name, const char *cache, int compile, config_t *cfg, int *seq_num, u8 log)
+{
+    char path[4096];
+
+    if (cache == NULL)
+    {
+        if (config_cache_path(file_name, path, sizeof(path)) != 0)
+        {
+            return parse_config(file_name, cfg, 0, seq_num, log);
+        }
+
+        cache = path;
+    }
+
+    if (!compile && load_config_cache(cache, file_name, cfg, seq_num) == 0)
+    {
+        return 0;
+    }
+
+    int ret = parse_config(file_name, cfg, 0, seq_num, log);
+
+    if (ret != 0 || !compile)
+    {
+        return ret;
+    }
+
+    if (save_config_cache(cache, file_name, cfg, *seq_num) != 0)
+    {
+        return 1;
+    }
+
+    if (log)
+    {
+        fprintf(stdout, "Compiled config '%s' into '%s'.\n", file_name, cache);
+    }
+
+    return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "simple_types.h"
+#include "config.h"
+
+#define CFG_CACHE_MAGIC "PBCFGC\0"
+#define CFG_CACHE_VERSION 1
+
+// Default cache path is the config path with this appended.
+#define CFG_CACHE_EXT ".pbc"
+
+typedef struct cfg_cache_hdr
+{
+    char magic[8];
+    u32 version;
+    u32 seq_cnt;
+
+    // Struct layout fingerprint and content hash of every file the config was built from.
+    u64 abi;
+    u64 hash;
+
+    // Total file size and offsets from the start of the file (0 = none).
+    u64 size;
+    u64 seq_off;
+    u64 interface_off;
+
+    // Offsets of every pointer in the file (stored as offsets, relocated on load).
+    u64 reloc_off;
+    u64 reloc_cnt;
+
+    // Paths of the files hashed into the key (NUL-separated, config file first).
+    u64 deps_off;
+    u64 deps_len;
+    u32 dep_cnt;
+} cfg_cache_hdr_t;
+
+int config_cache_path(const char *file_name, char *path, size_t len);
+int save_config_cache(const char *path, const char *file_name, config_t *cfg, int seq_cnt);
+int load_config_cache(const char *path, const char *file_name, config_t *cfg, int *seq_num);
+int load_config(const char *file_name, const char *cache, int compile, config_t *cfg, int *seq_num, u8 log);
@@ -0,0 +1,526 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include "cfg_loader.h"
+#include "hash.h"
+
+/**
+ * Resolves an include's path relative to the file that includes it.
+ * 
+ * @param base The including file's path.
+ * @param name The include as written (absolute or relative).
+ * @param out A buffer to store the path in.
+ * @param len The buffer's size.
+ * 
+ * @return 0 on success or -1 if the buffer is too small.
+**/
+int cfg_resolve_path(const char *base, const char *name, char *out, size_t len)
+{
+    const char *slash = base ? strrchr(base, '/') : NULL;
+    int ret;
+
+    if (name[0] == '/' || slash == NULL)
+    {
+        ret = snprintf(out, len, "%s", name);
+    }
+    else
+    {
+        ret = snprintf(out, len, "%.*s/%s", (int)(slash - base), base, name);
+    }
+
+    return ret < 0 || (size_t)ret >= len ? -1 : 0;
+}
+
+/**
+ * Initializes a config loader.
+ * 
+ * @param ld A pointer to the loader.
+ * 
+ * @return Void
+**/
+void cfg_loader_init(cfg_loader_t *ld)
+{
+    memset(ld, 0, sizeof(*ld));
+
+    ld->tail = &ld->head;
+
+    pthread_mutex_init(&ld->lock, NULL);
+    pthread_cond_init(&ld->cond, NULL);
+}
+
+/**
+ * Retrieves the slot of a path in the loader's table.
+ * 
+ * @param ld A pointer to the loader.
+ * @param path The path.
+ * 
+ * @return A pointer to the slot (empty if the path isn't known).
+ * 
+ * @note The lock must be held and the table must not be full.
+**/
+static cfg_doc_t **cfg_loader_slot(cfg_loader_t *ld, const char *path)
+{
+    u32 mask = ld->slot_cnt - 1;
+    u32 idx = hash64(path, strlen(path), 0) & mask;
+
+    while (ld->slots[idx] != NULL && strcmp(ld->slots[idx]->path, path) != 0)
+    {
+        idx = (idx + 1) & mask;
+    }
+
+    return &ld->slots[idx];
+}
+
+/**
+ * Queues a file unless it's already known.
+ * 
+ * @param ld A pointer to the loader.
+ * @param path The resolved path.
+ * 
+ * @return 0 on success or -1 on failure (allocation failure).
+ * 
+ * @note The lock must be held.
+**/
+static int cfg_loader_add(cfg_loader_t *ld, const char *path)
+{
+    // Keep the table at most half full.
+    if ((ld->doc_cnt + 1) * 2 > ld->slot_cnt)
+    {
+        u32 cnt = ld->slot_cnt ? ld->slot_cnt * 2 : 64;
+        cfg_doc_t **slots = calloc(cnt, sizeof(cfg_doc_t *));
+
+        if (slots == NULL)
+        {
+            return -1;
+        }
+
+        free(ld->slots);
+
+        ld->slots = slots;
+        ld->slot_cnt = cnt;
+
+        for (cfg_doc_t *doc = ld->head; doc != NULL; doc = doc->next)
+        {
+            *cfg_loader_slot(ld, doc->path) = doc;
+        }
+    }
+
+    cfg_doc_t **slot = cfg_loader_slot(ld, path);
+
+    if (*slot != NULL)
+    {
+        return 0;
+    }
+
+    if (ld->queue_len >= ld->queue_cap)
+    {
+        u32 cap = ld->queue_cap ? ld->queue_cap * 2 : 64;
+        cfg_doc_t **queue = realloc(ld->queue, sizeof(cfg_doc_t *) * cap);
+
+        if (queue == NULL)
+        {
+            return -1;
+        }
+
+        ld->queue = queue;
+        ld->queue_cap = cap;
+    }
+
+    cfg_doc_t *doc = calloc(1, sizeof(*doc));
+
+    if (doc == NULL || (doc->path = strdup(path)) == NULL)
+    {
+        free(doc);
+
+        return -1;
+    }
+
+    *slot = doc;
+    *ld->tail = doc;
+    ld->tail = &doc->next;
+    ld->doc_cnt++;
+
+    ld->queue[ld->queue_len++] = doc;
+
+    pthread_cond_signal(&ld->cond);
+
+    return 0;
+}
+
+/**
+ * Queues the files a document includes (fragment includes at its root and each sequence's includes).
+ * 
+ * @param ld A pointer to the loader.
+ * @param doc A pointer to the including file.
+ * @param root The file's document.
+ * 
+ * @return 0 on success or -1 on failure (allocation failure).
+ * 
+ * @note The lock must be held.
+**/
+static int cfg_loader_scan(cfg_loader_t *ld, const cfg_doc_t *doc, json_object *root)
+{
+    json_object *lists[2] = { NULL, NULL };
+    json_object *seqs;
+
+    json_object_object_get_ex(root, "includes", &lists[0]);
+
+    int seq_len = json_object_object_get_ex(root, "sequences", &seqs) && json_object_get_type(seqs) == json_type_array ? json_object_array_length(seqs) : 0;
+
+    for (int i = -1; i < seq_len; i++)
+    {
+        json_object *list = lists[0];
+
+        if (i >= 0)
+        {
+            json_object *seq_obj = json_object_array_get_idx(seqs, i);
+
+            if (json_object_get_type(seq_obj) != json_type_object || !json_object_object_get_ex(seq_obj, "includes", &list))
+            {
+                continue;
+            }
+        }
+
+        if (list == NULL || json_object_get_type(list) != json_type_array)
+        {
+            continue;
+        }
+
+        int len = json_object_array_length(list);
+
+        for (int j = 0; j < len; j++)
+        {
+            json_object *inc_obj = json_object_array_get_idx(list, j);
+            char path[PATH_MAX];
+
+            if (json_object_get_type(inc_obj) != json_type_string || cfg_resolve_path(doc->path, json_object_get_string(inc_obj), path, sizeof(path)) != 0)
+            {
+                continue;
+            }
+
+            if (cfg_loader_add(ld, path) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Reads a file into a NUL-terminated buffer.
+ * 
+ * @param path The file's path.
+ * @param len A pointer to store the file's length in.
+ * 
+ * @return The buffer (free() it) or NULL on failure.
+**/
+static char *cfg_loader_read(const char *path, size_t *len)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    char *buf = NULL;
+
+    if (fstat(fd, &st) != 0 || (buf = malloc(st.st_size + 1)) == NULL)
+    {
+        close(fd);
+
+        return NULL;
+    }
+
+    size_t done = 0;
+
+    while (done < (size_t)st.st_size)
+    {
+        ssize_t n = read(fd, buf + done, st.st_size - done);
+
+        if (n <= 0)
+        {
+            break;
+        }
+
+        done += n;
+    }
+
+    close(fd);
+
+    buf[done] = '\0';
+    *len = done;
+
+    return buf;
+}
+
+/**
+ * Loads one file: reads and hashes it, parses it unless a file with the same content already was, and queues its includes.
+ * 
+ * @param ld A pointer to the loader.
+ * @param doc A pointer to the file (LOADING).
+ * 
+ * @return Void
+ * 
+ * @note Called without the lock held and returns with it held.
+**/
+static void cfg_loader_process(cfg_loader_t *ld, cfg_doc_t *doc)
+{
+    size_t len = 0;
+    char *buf = cfg_loader_read(doc->path, &len);
+    u64 hash = buf ? hash64(buf, len, 0) : 0;
+
+    pthread_mutex_lock(&ld->lock);
+
+    if (buf == NULL)
+    {
+        doc->state = CFG_DOC_FAILED;
+
+        pthread_cond_broadcast(&ld->cond);
+
+        return;
+    }
+
+    doc->hash = hash;
+    doc->len = len;
+
+    // Identical content is parsed once no matter how many paths lead to it.
+    for (cfg_doc_t *other = ld->head; other != NULL; other = other->next)
+    {
+        if (other != doc && other->same == NULL && other->state != CFG_DOC_QUEUED && other->hash == hash && other->len == len)
+        {
+            doc->same = other;
+
+            break;
+        }
+    }
+
+    json_object *root;
+
+    if (doc->same != NULL)
+    {
+        free(buf);
+
+        while (doc->same->state == CFG_DOC_LOADING)
+        {
+            pthread_cond_wait(&ld->cond, &ld->lock);
+        }
+
+        root = doc->same->root;
+    }
+    else
+    {
+        pthread_mutex_unlock(&ld->lock);
+
+        root = json_tokener_parse(buf);
+
+        free(buf);
+
+        pthread_mutex_lock(&ld->lock);
+
+        doc->root = root;
+    }
+
+    if (root == NULL || json_object_get_type(root) != json_type_object)
+    {
+        doc->state = CFG_DOC_FAILED;
+    }
+    else
+    {
+        doc->state = CFG_DOC_READY;
+
+        // Relative includes resolve against this path even when the document is shared.
+        if (cfg_loader_scan(ld, doc, root) != 0)
+        {
+            ld->failed = 1;
+        }
+    }
+
+    pthread_cond_broadcast(&ld->cond);
+}
+
+/**
+ * Loader thread. Takes queued files until none are queued or being loaded.
+ * 
+ * @param arg A pointer to the loader.
+ * 
+ * @return NULL
+**/
+static void *cfg_loader_work(void *arg)
+{
+    cfg_loader_t *ld = arg;
+
+    pthread_mutex_lock(&ld->lock);
+
+    for (;;)
+    {
+        while (ld->queue_len == 0 && ld->busy > 0)
+        {
+            pthread_cond_wait(&ld->cond, &ld->lock);
+        }
+
+        if (ld->queue_len == 0)
+        {
+            break;
+        }
+
+        cfg_doc_t *doc = ld->queue[--ld->queue_len];
+
+        doc->state = CFG_DOC_LOADING;
+        ld->busy++;
+
+        pthread_mutex_unlock(&ld->lock);
+
+        cfg_loader_process(ld, doc);
+
+        ld->busy--;
+    }
+
+    pthread_cond_broadcast(&ld->cond);
+    pthread_mutex_unlock(&ld->lock);
+
+    return NULL;
+}
+
+/**
+ * Loads a config file along with every file it includes (transitively). Includes are read and parsed by a thread pool, each path once and each distinct content once.
+ * 
+ * @param ld A pointer to the loader (see cfg_loader_init()).
+ * @param file_name The config file.
+ * 
+ * @return The config file's document (owned by the loader) or NULL on failure.
+**/
+json_object *cfg_loader_run(cfg_loader_t *ld, const char *file_name)
+{
+    pthread_mutex_lock(&ld->lock);
+
+    int ret = cfg_loader_add(ld, file_name);
+    cfg_doc_t *main_doc = ld->head;
+
+    if (ret != 0 || main_doc == NULL)
+    {
+        pthread_mutex_unlock(&ld->lock);
+
+        return NULL;
+    }
+
+    // The config file is loaded inline; threads are only started when it has includes.
+    ld->queue_len--;
+    main_doc->state = CFG_DOC_LOADING;
+
+    pthread_mutex_unlock(&ld->lock);
+
+    cfg_loader_process(ld, main_doc);
+
+    u32 queued = ld->queue_len;
+
+    pthread_mutex_unlock(&ld->lock);
+
+    if (queued > 0)
+    {
+        pthread_t threads[CFG_LOADER_MAX_THREADS];
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int cnt = 0;
+
+        for (int i = 1; i < CFG_LOADER_MAX_THREADS && i < cpus; i++)
+        {
+            if (pthread_create(&threads[cnt], NULL, cfg_loader_work, ld) == 0)
+            {
+                cnt++;
+            }
+        }
+
+        // The calling thread works too.
+        cfg_loader_work(ld);
+
+        for (int i = 0; i < cnt; i++)
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    if (ld->failed)
+    {
+        fprintf(stderr, "Failed to allocate memory while loading includes of '%s'.\n", file_name);
+
+        return NULL;
+    }
+
+    return cfg_doc_root(main_doc);
+}
+
+/**
+ * Retrieves a loaded file by its resolved path.
+ * 
+ * @param ld A pointer to the loader.
+ * @param path The resolved path (see cfg_resolve_path()).
+ * 
+ * @return A pointer to the file or NULL if it wasn't loaded.
+**/
+cfg_doc_t *cfg_loader_find(cfg_loader_t *ld, const char *path)
+{
+    if (ld->slot_cnt == 0)
+    {
+        return NULL;
+    }
+
+    return *cfg_loader_slot(ld, path);
+}
+
+/**
+ * Retrieves a file's parsed document.
+ * 
+ * @param doc A pointer to the file.
+ * 
+ * @return The document or NULL if the file failed to load.
+**/
+json_object *cfg_doc_root(cfg_doc_t *doc)
+{
+    if (doc == NULL || doc->state != CFG_DOC_READY)
+    {
+        return NULL;
+    }
+
+    return doc->same ? doc->same->root : doc->root;
+}
+
+/**
+ * Frees a loader and every document it parsed.
+ * 
+ * @param ld A pointer to the loader.
+ * 
+ * @return Void
+**/
+void cfg_loader_free(cfg_loader_t *ld)
+{
+    cfg_doc_t *doc = ld->head;
+
+    while (doc != NULL)
+    {
+        cfg_doc_t *next = doc->next;
+
+        json_object_put(doc->root);
+
+        free(doc->path);
+        free(doc);
+
+        doc = next;
+    }
+
+    free(ld->slots);
+    free(ld->queue);
+
+    pthread_mutex_destroy(&ld->lock);
+    pthread_cond_destroy(&ld->cond);
+
+    memset(ld, 0, sizeof(*ld));
+}
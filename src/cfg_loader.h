@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include <json-c/json.h>
+
+#include "simple_types.h"
+
+// Maximum amount of loader threads.
+#define CFG_LOADER_MAX_THREADS 8
+
+// Maximum nesting of included fragments.
+#define CFG_LOADER_MAX_DEPTH 16
+
+enum cfg_doc_state
+{
+    CFG_DOC_QUEUED,
+    CFG_DOC_LOADING,
+    CFG_DOC_READY,
+    CFG_DOC_FAILED
+};
+
+typedef struct cfg_doc
+{
+    // Path as resolved from the including file (lookup key).
+    char *path;
+
+    // Content hash and length.
+    u64 hash;
+    size_t len;
+
+    // Parsed document (NULL when `same` is set or the file failed to load).
+    json_object *root;
+
+    // Earlier file with identical content whose document is shared.
+    struct cfg_doc *same;
+
+    u8 state;
+
+    // Set once the file's sequences were appended to a config.
+    u8 appended;
+
+    struct cfg_doc *next;
+} cfg_doc_t;
+
+typedef struct cfg_loader
+{
+    // Files by path (open addressing) and in load order.
+    cfg_doc_t **slots;
+    u32 slot_cnt;
+    cfg_doc_t *head;
+    cfg_doc_t **tail;
+    u32 doc_cnt;
+
+    // Work queue (files still QUEUED).
+    cfg_doc_t **queue;
+    u32 queue_len;
+    u32 queue_cap;
+    u32 busy;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    int failed;
+} cfg_loader_t;
+
+int cfg_resolve_path(const char *base, const char *name, char *out, size_t len);
+void cfg_loader_init(cfg_loader_t *ld);
+json_object *cfg_loader_run(cfg_loader_t *ld, const char *file_name);
+cfg_doc_t *cfg_loader_find(cfg_loader_t *ld, const char *path);
+json_object *cfg_doc_root(cfg_doc_t *doc);
+void cfg_loader_free(cfg_loader_t *ld);
@@ -5,6 +5,9 @@
 
 #include "cmd_line.h"
 #include "config.h"
+#include "payload.h"
+#include "utils.h"
+#include "topology.h"
 
 static struct option long_opts[] =
 {
@@ -13,6 +16,8 @@ static struct option long_opts[] =
     {"list", no_argument, NULL, 'l'},
     {"verbose", no_argument, NULL, 'v'},
     {"help", no_argument, NULL, 'h'},
+    {"compile-cfg", no_argument, NULL, 49},
+    {"cfg-cache", required_argument, NULL, 50},
 
     /* CLI options. */
     {"interface", required_argument, NULL, 0},
@@ -27,6 +32,10 @@ static struct option long_opts[] =
     {"l4csum", required_argument, NULL, 9},
     {"pps", required_argument, NULL, 43},
     {"bps", required_argument, NULL, 44},
+    {"csumoffload", required_argument, NULL, 45},
+    {"gsosize", required_argument, NULL, 46},
+    {"cpus", required_argument, NULL, 47},
+    {"numa", required_argument, NULL, 48},
 
     {"smac", required_argument, NULL, 10},
     {"dmac", required_argument, NULL, 11},
@@ -66,6 +75,8 @@ static struct option long_opts[] =
     {"pexact", required_argument, NULL, 35},
     {"pfile", required_argument, NULL, 36},
     {"pstring", required_argument, NULL, 37},
+    {"pescaped", required_argument, NULL, 51},
+    {"ppool", required_argument, NULL, 52},
 
     {NULL, 0, NULL, 0}
 };
@@ -85,6 +96,8 @@ void print_cmd_help()
     fprintf(stdout, "\t-l --list => Print full config values.\n");
     fprintf(stdout, "\t-v --verbose => Provide verbose output on packets sent.\n");
     fprintf(stdout, "\t-h --help => Print out the help menu and exit.\n");
+    fprintf(stdout, "\t--compile-cfg => Compile the config file into a binary cache that later runs map instead of parsing.\n");
+    fprintf(stdout, "\t--cfg-cache => Path to the binary config cache (default: <configfile>.pbc).\n");
 
     // First sequence override.
     fprintf(stdout, "First Sequence/Packet Override\n");
@@ -98,8 +111,12 @@ void print_cmd_help()
     fprintf(stdout, "\t--pps => The amount of packets per second to limit this sequence to (0 = disabled).\n");
     fprintf(stdout, "\t--bps => The amount of bytes per second to limit this sequence to (0 = disabled)\n");
     fprintf(stdout, "\t--delay => The delay in-between sending packets on each thread.\n");
-    fprintf(stdout, "\t--threads => The amount of threads and sockets to spawn (0 = CPU count).\n");
-    fprintf(stdout, "\t--l4csum => Whether to calculate the layer-4 checksum (TCP, UDP, and ICMP) (0/1).\n\n");
+    fprintf(stdout, "\t--threads => The amount of threads and sockets to spawn (0 = physical cores local to the interface, or all physical cores).\n");
+    fprintf(stdout, "\t--cpus => The CPUs to pin threads to (e.g. 0-3,8). Overrides --numa.\n");
+    fprintf(stdout, "\t--numa => The NUMA policy for thread placement (auto = interface's node, none, or a node number).\n");
+    fprintf(stdout, "\t--l4csum => Whether to calculate the layer-4 checksum (TCP, UDP, and ICMP) (0/1).\n");
+    fprintf(stdout, "\t--csumoffload => Offload the layer-4 checksum (TCP and UDP) to the kernel/NIC with a virtio-net header instead of calculating it (0/1).\n");
+    fprintf(stdout, "\t--gsosize => The segment size to use with segmentation offload (0 = disabled, requires --csumoffload).\n\n");
 
     fprintf(stdout, "\t--smac => The ethernet source MAC address to use.\n");
     fprintf(stdout, "\t--dmac => The ethernet destination MAC address to use.\n\n");
@@ -108,8 +125,8 @@ void print_cmd_help()
     fprintf(stdout, "\t--maxttl => The maximum IP TTL to use.\n");
     fprintf(stdout, "\t--minid => The minimum IP ID to use.\n");
     fprintf(stdout, "\t--maxid => The maximum IP ID to use.\n");
-    fprintf(stdout, "\t--sip => The source IP (one range is supported in CIDR format).\n");
-    fprintf(stdout, "\t--dip => The destination IP.\n");
+    fprintf(stdout, "\t--sip => The source IPv4 or IPv6 address (one range is supported in CIDR format).\n");
+    fprintf(stdout, "\t--dip => The destination IPv4 or IPv6 address.\n");
     fprintf(stdout, "\t--protocol => The protocol to use (TCP, UDP, or ICMP).\n");
     fprintf(stdout, "\t--tos => The IP TOS to use.\n");
     fprintf(stdout, "\t--l3csum => Whether to calculate the IP header checksum or not (0/1).\n\n");
@@ -136,6 +153,8 @@ void print_cmd_help()
     fprintf(stdout, "\t--pexact => The exact payload string.\n");
     fprintf(stdout, "\t--pfile => Whether to parse a file as the 'pexact' string instead.\n");
     fprintf(stdout, "\t--pstring => Parse the 'pexact' string or file as a string instead of hexadecimal.\n");
+    fprintf(stdout, "\t--pescaped => Decode escape sequences (e.g. \\r\\n, \\x00) in a 'pstring' payload (0/1).\n");
+    fprintf(stdout, "\t--ppool => Pregenerate this many random payloads for a non-static payload and cycle through them (0 = generate per packet).\n");
 }
 
 /**
@@ -149,6 +168,11 @@ void print_cmd_help()
 **/
 void parse_cli(cmd_line_t *cmd, config_t *cfg)
 {
+    if (reserve_sequences(cfg, 1) != 0)
+    {
+        return;
+    }
+
     sequence_t *seq = &cfg->seq[0];
 
     if (cmd->interface != NULL && cmd->is_interface)
@@ -202,11 +226,31 @@ void parse_cli(cmd_line_t *cmd, config_t *cfg)
         seq->threads = cmd->threads;
     }
     
+    if(cmd->is_cpus)
+    {
+        seq->cpus = cmd->cpus;
+    }
+
+    if(cmd->is_numa)
+    {
+        seq->numa = cmd->numa;
+    }
+
     if(cmd->is_l4_csum)
     {
         seq->l4_csum = cmd->l4_csum;
     }
 
+    if(cmd->is_csum_offload)
+    {
+        seq->csum_offload = cmd->csum_offload;
+    }
+
+    if(cmd->is_gso_size)
+    {
+        seq->gso_size = cmd->gso_size;
+    }
+
     if(cmd->is_src_mac)
     {
         seq->eth.src_mac = cmd->src_mac;
@@ -242,9 +286,23 @@ void parse_cli(cmd_line_t *cmd, config_t *cfg)
         // Check for range.
         if (strstr(cmd->src_ip, "/") != NULL)
         {
+            if (seq->ip.range_count < 1)
+            {
+                seq->ip.ranges = arena_calloc(&cfg->arena, 1, sizeof(char *));
+                seq->ip.range_weights = arena_calloc(&cfg->arena, 1, sizeof(u32));
+
+                if (seq->ip.ranges == NULL || seq->ip.range_weights == NULL)
+                {
+                    fprintf(stderr, "Failed to allocate source range.\n");
+
+                    return;
+                }
+            }
+
             seq->ip.src_ip = 0;
             seq->ip.range_count = 1;
             seq->ip.ranges[0] = cmd->src_ip;
+            seq->ip.range_weights[0] = 0;
         }
         else
         {
@@ -257,6 +315,16 @@ void parse_cli(cmd_line_t *cmd, config_t *cfg)
         seq->ip.dst_ip = cmd->dst_ip;
     }
 
+    if (cmd->is_src_ip || cmd->is_dst_ip)
+    {
+        seq->ip.is_ipv6 = is_ipv6(cmd->src_ip) || is_ipv6(cmd->dst_ip);
+
+        if (!seq->ip.is_ipv6)
+        {
+            compile_ranges(&seq->ip.range_tbl, seq->ip.ranges, seq->ip.range_weights, seq->ip.range_count, seq->ip.src_ip);
+        }
+    }
+
     if(cmd->is_protocol)
     {
         seq->ip.protocol = cmd->protocol;
@@ -354,6 +422,18 @@ void parse_cli(cmd_line_t *cmd, config_t *cfg)
 
     if (cmd->is_pl_min_len || cmd->is_pl_max_len || cmd->is_pl_exact)
     {
+        if (seq->pl_cnt < 1)
+        {
+            seq->pls = arena_calloc(&cfg->arena, 1, sizeof(payload_opt_t));
+
+            if (seq->pls == NULL)
+            {
+                fprintf(stderr, "Failed to allocate payload.\n");
+
+                return;
+            }
+        }
+
         seq->pl_cnt = 1;
         
         struct payload_opt *pl = &seq->pls[0];
@@ -387,6 +467,21 @@ void parse_cli(cmd_line_t *cmd, config_t *cfg)
         {
             pl->is_string = cmd->pl_is_string;
         }
+
+        if(cmd->is_pl_is_escaped)
+        {
+            pl->is_escaped = cmd->pl_is_escaped;
+        }
+
+        if(cmd->is_pl_pool)
+        {
+            pl->pool = cmd->pl_pool;
+        }
+
+        // Decode static payloads and precompute their partial checksum once.
+        load_payload(&cfg->pl_store, pl);
+
+        pl_store_seal(&cfg->pl_store);
     }
 }
 
@@ -417,6 +512,16 @@ void parse_cmd_line(int argc, char **argv, cmd_line_t *cmd)
 
                 break;
 
+            case 49:
+                cmd->compile_cfg = 1;
+
+                break;
+
+            case 50:
+                cmd->cfg_cache = optarg;
+
+                break;
+
             /* CLI options. */
             case 0:
                 cmd->interface = optarg;
@@ -688,6 +793,20 @@ void parse_cmd_line(int argc, char **argv, cmd_line_t *cmd)
                 cmd->is_pl_is_string = 1;
 
                 break;
+
+            case 51:
+                cmd->pl_is_escaped = atoi(optarg);
+
+                cmd->is_pl_is_escaped = 1;
+
+                break;
+
+            case 52:
+                cmd->pl_pool = strtoul(optarg, NULL, 10);
+
+                cmd->is_pl_pool = 1;
+
+                break;
                 
             case 38:
                 cmd->icmp_code = atoi(optarg);
@@ -744,6 +863,52 @@ void parse_cmd_line(int argc, char **argv, cmd_line_t *cmd)
                 break;
             }
 
+            case 45:
+                cmd->csum_offload = atoi(optarg);
+
+                cmd->is_csum_offload = 1;
+
+                break;
+
+            case 46:
+                cmd->gso_size = atoi(optarg);
+
+                cmd->is_gso_size = 1;
+
+                break;
+
+            case 47:
+                if (topo_parse_cpu_list(optarg, NULL, 0) < 1)
+                {
+                    fprintf(stderr, "Invalid CPU list '%s'.\n", optarg);
+
+                    break;
+                }
+
+                cmd->cpus = optarg;
+
+                cmd->is_cpus = 1;
+
+                break;
+
+            case 48:
+            {
+                int numa = topo_parse_numa(optarg);
+
+                if (numa == TOPO_NUMA_INVALID)
+                {
+                    fprintf(stderr, "Invalid NUMA policy '%s'.\n", optarg);
+
+                    break;
+                }
+
+                cmd->numa = numa;
+
+                cmd->is_numa = 1;
+
+                break;
+            }
+
             case 'l':
                 cmd->list = 1;
 
@@ -11,6 +11,9 @@ typedef struct cmd_line
     unsigned int help : 1;
     unsigned int cli : 1;
 
+    const char *cfg_cache;
+    unsigned int compile_cfg : 1;
+
     /* Sequence options. */
     char *interface;
     unsigned int is_interface : 1;
@@ -24,6 +27,12 @@ typedef struct cmd_line
     unsigned int l4_csum : 1;
     unsigned int is_l4_csum : 1;
 
+    unsigned int csum_offload : 1;
+    unsigned int is_csum_offload : 1;
+
+    u16 gso_size;
+    unsigned int is_gso_size : 1;
+
     u64 max_pckts;
     unsigned int is_max_pckts : 1;
 
@@ -44,6 +53,12 @@ typedef struct cmd_line
     
     u16 threads;
     unsigned int is_threads : 1;
+
+    char *cpus;
+    unsigned int is_cpus : 1;
+
+    s16 numa;
+    unsigned int is_numa : 1;
     
     char *src_mac;
     unsigned int is_src_mac : 1;
@@ -143,6 +158,12 @@ typedef struct cmd_line
 
     unsigned int pl_is_string : 1;
     unsigned int is_pl_is_string : 1;
+
+    unsigned int pl_is_escaped : 1;
+    unsigned int is_pl_is_escaped : 1;
+
+    u32 pl_pool;
+    unsigned int is_pl_pool : 1;
 } cmd_line_t;
 
 void print_cmd_help();
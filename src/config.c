@@ -2,421 +2,1623 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <limits.h>
+#include <sys/mman.h>
 #include <linux/types.h>
 
 #include <json-c/json.h>
 
 #include "config.h"
 #include "utils.h"
+#include "payload.h"
+#include "topology.h"
+#include "cfg_loader.h"
 
 /**
- * Parses a config file including the main config options and sequences. It then fills out the config structure passed in the function's parameters.
+ * Initializes an empty config.
+ * 
+ * @param cfg A pointer to the config structure.
+ * 
+ * @return Void
+**/
+void init_config(config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+}
+
+/**
+ * Makes sure a config has room for at least `count` sequences. New sequences are set to their defaults.
+ * 
+ * @param cfg A pointer to the config structure.
+ * @param count The amount of sequences needed.
+ * 
+ * @return 0 on success or -1 on failure (allocation failure).
+**/
+int reserve_sequences(config_t *cfg, int count)
+{
+    if (count <= cfg->seq_cap)
+    {
+        return 0;
+    }
+
+    // parse_config() reserves once for every file it loaded, so this only grows per parse. The old array stays in the arena until the config is freed.
+    sequence_t *seq = arena_calloc(&cfg->arena, count, sizeof(sequence_t));
+
+    if (seq == NULL)
+    {
+        fprintf(stderr, "Failed to allocate %d sequences.\n", count);
+
+        return -1;
+    }
+
+    if (cfg->seq_cap > 0)
+    {
+        memcpy(seq, cfg->seq, sizeof(sequence_t) * cfg->seq_cap);
+    }
+
+    int old_cap = cfg->seq_cap;
+
+    cfg->seq = seq;
+    cfg->seq_cap = count;
+
+    for (int i = old_cap; i < count; i++)
+    {
+        clear_sequence(cfg, i);
+    }
+
+    return 0;
+}
+
+/**
+ * Frees a config's sequences along with their compiled ranges, payload store and payload pools.
+ * 
+ * @param cfg A pointer to the config structure.
+ * 
+ * @return Void
+**/
+void free_config(config_t *cfg)
+{
+    for (int i = 0; i < cfg->seq_cap; i++)
+    {
+        sequence_t *seq = &cfg->seq[i];
+
+        free_ranges(&seq->ip.range_tbl);
+
+        for (int j = 0; j < seq->pl_cnt; j++)
+        {
+            free_payload(&seq->pls[j]);
+        }
+    }
+
+    pl_store_free(&cfg->pl_store);
+
+    while (cfg->pools != NULL)
+    {
+        pl_pool_t *next = cfg->pools->next;
+
+        pl_pool_free(cfg->pools);
+
+        cfg->pools = next;
+    }
+
+    if (cfg->map != NULL)
+    {
+        munmap(cfg->map, cfg->map_len);
+
+        cfg->map = NULL;
+        cfg->map_len = 0;
+    }
+
+    arena_free(&cfg->arena);
+
+    cfg->seq = NULL;
+    cfg->seq_cap = 0;
+}
+
+// Field types.
+enum cfg_type
+{
+    CFG_T_STR,
+    CFG_T_BOOL,
+    CFG_T_U8,
+    CFG_T_U16,
+    CFG_T_U32,
+    CFG_T_U64,
+    CFG_T_HEX32,
+    CFG_T_OBJ,
+    CFG_T_CUSTOM
+};
+
+static const char *cfg_type_names[] = { "string", "boolean", "integer", "integer", "integer", "integer", "integer", "object", "value" };
+static const u64 cfg_type_max[] = { 0, 1, UINT8_MAX, UINT16_MAX, UINT32_MAX, UINT64_MAX, UINT32_MAX, 0, 0 };
+
+// Print a nested object's fields inline (without a header).
+#define CFG_F_FLAT (1 << 0)
+
+// Maximum perfect hash slots per schema.
+#define CFG_HASH_SLOTS 256
+
+typedef struct cfg_parse
+{
+    config_t *cfg;
+    int *seq_num;
+    int seq_idx;
+    u8 log;
+    u8 has_seqs;
+
+    // File being walked (includes resolve against it) and the loaded files.
+    const char *file;
+    cfg_loader_t *loader;
+} cfg_parse_t;
+
+typedef struct cfg_schema cfg_schema_t;
+
+typedef struct cfg_field
+{
+    // JSON key (NULL = derived and only printed) and print label (NULL = not printed).
+    const char *key;
+    const char *label;
+
+    u8 type;
+    u8 flags;
+    u16 offset;
+
+    // Nested object (CFG_T_OBJ).
+    cfg_schema_t *sub;
+
+    // Custom parser and printer (CFG_T_CUSTOM). Both receive the object that holds the field.
+    int (*parse)(cfg_parse_t *ctx, void *base, json_object *val);
+    void (*print)(const void *base, int depth);
+} cfg_field_t;
+
+struct cfg_schema
+{
+    const char *name;
+    const cfg_field_t *fields;
+    u16 count;
+
+    // Perfect hash of the keys (built once): slots[hash(key, seed) & mask] = field index + 1.
+    u32 seed;
+    u32 mask;
+    u8 slots[CFG_HASH_SLOTS];
+};
+
+#define CFG_FIELD(type, member, key, label, t) { key, label, t, 0, offsetof(type, member), NULL, NULL, NULL }
+#define CFG_DERIVED(type, member, label, t) { NULL, label, t, 0, offsetof(type, member), NULL, NULL, NULL }
+#define CFG_OBJ(type, member, key, label, schema) { key, label, CFG_T_OBJ, 0, offsetof(type, member), schema, NULL, NULL }
+#define CFG_FLAT(key, schema) { key, NULL, CFG_T_OBJ, CFG_F_FLAT, 0, schema, NULL, NULL }
+#define CFG_CUSTOM(key, label, parse, print) { key, label, CFG_T_CUSTOM, 0, 0, NULL, parse, print }
+#define CFG_SCHEMA(name, fields) { name, fields, sizeof(fields) / sizeof(fields[0]), 0, 0, {0} }
+
+static int cfg_walk(cfg_parse_t *ctx, const cfg_schema_t *schema, void *base, json_object *obj);
+static void cfg_print_fields(const cfg_schema_t *schema, const void *base, int depth);
+
+static int parse_sequences(cfg_parse_t *ctx, void *base, json_object *val);
+static int parse_includes(cfg_parse_t *ctx, void *base, json_object *val);
+static int parse_cpus(cfg_parse_t *ctx, void *base, json_object *val);
+static int parse_numa(cfg_parse_t *ctx, void *base, json_object *val);
+static int parse_ranges(cfg_parse_t *ctx, void *base, json_object *val);
+static int parse_payloads(cfg_parse_t *ctx, void *base, json_object *val);
+static void print_includes(const void *base, int depth);
+static void print_cpus(const void *base, int depth);
+static void print_numa(const void *base, int depth);
+static void print_ranges(const void *base, int depth);
+static void print_payloads(const void *base, int depth);
+
+static const cfg_field_t eth_fields[] =
+{
+    CFG_FIELD(eth_opt_t, src_mac, "smac", "Source MAC", CFG_T_STR),
+    CFG_FIELD(eth_opt_t, dst_mac, "dmac", "Destination MAC", CFG_T_STR),
+};
+
+static const cfg_field_t ttl_fields[] =
+{
+    CFG_FIELD(ip_opt_t, min_ttl, "min", "Min TTL", CFG_T_U8),
+    CFG_FIELD(ip_opt_t, max_ttl, "max", "Max TTL", CFG_T_U8),
+};
+
+static const cfg_field_t id_fields[] =
+{
+    CFG_FIELD(ip_opt_t, min_id, "min", "Min ID", CFG_T_U16),
+    CFG_FIELD(ip_opt_t, max_id, "max", "Max ID", CFG_T_U16),
+};
+
+static cfg_schema_t ttl_schema = CFG_SCHEMA("ttl", ttl_fields);
+static cfg_schema_t id_schema = CFG_SCHEMA("id", id_fields);
+
+static const cfg_field_t ip_fields[] =
+{
+    CFG_FIELD(ip_opt_t, protocol, "protocol", "Protocol", CFG_T_STR),
+    CFG_FIELD(ip_opt_t, src_ip, "sip", "Source IP", CFG_T_STR),
+    CFG_FIELD(ip_opt_t, dst_ip, "dip", "Destination IP", CFG_T_STR),
+    CFG_DERIVED(ip_opt_t, is_ipv6, "IPv6", CFG_T_BOOL),
+    CFG_FIELD(ip_opt_t, tos, "tos", "Type of Service", CFG_T_U8),
+    CFG_FLAT("ttl", &ttl_schema),
+    CFG_FLAT("id", &id_schema),
+    CFG_FIELD(ip_opt_t, csum, "csum", "Checksum", CFG_T_BOOL),
+    CFG_CUSTOM("ranges", "Ranges", parse_ranges, print_ranges),
+    CFG_DERIVED(ip_opt_t, range_tbl.count, "Compiled Ranges", CFG_T_U16),
+};
+
+static const cfg_field_t tcp_fields[] =
+{
+    CFG_FIELD(tcp_opt_t, src_port, "sport", "Source Port", CFG_T_U16),
+    CFG_FIELD(tcp_opt_t, dst_port, "dport", "Dest Port", CFG_T_U16),
+    CFG_FIELD(tcp_opt_t, cooked, "cooked", "Use Socket", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, one_connection, "oneconn", "One Connection", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, syn, "syn", "SYN Flag", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, psh, "psh", "PSH Flag", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, fin, "fin", "FIN Flag", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, ack, "ack", "ACK Flag", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, rst, "rst", "RST Flag", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, urg, "urg", "URG Flag", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, ece, "ece", "ECE Flag", CFG_T_BOOL),
+    CFG_FIELD(tcp_opt_t, cwr, "cwr", "CWR Flag", CFG_T_BOOL),
+};
+
+static const cfg_field_t udp_fields[] =
+{
+    CFG_FIELD(udp_opt_t, src_port, "sport", "Src Port", CFG_T_U16),
+    CFG_FIELD(udp_opt_t, dst_port, "dport", "Dst Port", CFG_T_U16),
+};
+
+static const cfg_field_t icmp_fields[] =
+{
+    CFG_FIELD(icmp_opt_t, code, "code", "Code", CFG_T_U8),
+    CFG_FIELD(icmp_opt_t, type, "type", "Type", CFG_T_U8),
+};
+
+static const cfg_field_t length_fields[] =
+{
+    CFG_FIELD(payload_opt_t, min_len, "min", "Min Length", CFG_T_U16),
+    CFG_FIELD(payload_opt_t, max_len, "max", "Max Length", CFG_T_U16),
+};
+
+static cfg_schema_t length_schema = CFG_SCHEMA("length", length_fields);
+
+static const cfg_field_t payload_fields[] =
+{
+    CFG_FLAT("length", &length_schema),
+    CFG_FIELD(payload_opt_t, is_static, "isstatic", "Is Static", CFG_T_BOOL),
+    CFG_FIELD(payload_opt_t, is_file, "isfile", "Is File", CFG_T_BOOL),
+    CFG_FIELD(payload_opt_t, is_string, "isstring", "Is String", CFG_T_BOOL),
+    CFG_FIELD(payload_opt_t, is_escaped, "isescaped", "Is Escaped", CFG_T_BOOL),
+    CFG_FIELD(payload_opt_t, pool, "pool", "Pool Size", CFG_T_U32),
+    CFG_FIELD(payload_opt_t, exact, "exact", "Exact String", CFG_T_STR),
+    CFG_DERIVED(payload_opt_t, data_len, "Decoded Length", CFG_T_U32),
+    CFG_DERIVED(payload_opt_t, data_csum, "Partial Checksum", CFG_T_HEX32),
+};
+
+static cfg_schema_t eth_schema = CFG_SCHEMA("eth", eth_fields);
+static cfg_schema_t ip_schema = CFG_SCHEMA("ip", ip_fields);
+static cfg_schema_t tcp_schema = CFG_SCHEMA("tcp", tcp_fields);
+static cfg_schema_t udp_schema = CFG_SCHEMA("udp", udp_fields);
+static cfg_schema_t icmp_schema = CFG_SCHEMA("icmp", icmp_fields);
+static cfg_schema_t payload_schema = CFG_SCHEMA("payload", payload_fields);
+
+static const cfg_field_t seq_fields[] =
+{
+    CFG_CUSTOM("includes", "Includes", parse_includes, print_includes),
+    CFG_FIELD(sequence_t, interface, "interface", "Interface Override", CFG_T_STR),
+    CFG_FIELD(sequence_t, block, "block", "Block", CFG_T_BOOL),
+    CFG_FIELD(sequence_t, track, "track", "Track", CFG_T_BOOL),
+    CFG_FIELD(sequence_t, max_pckts, "maxpckts", "Max Packets", CFG_T_U64),
+    CFG_FIELD(sequence_t, max_bytes, "maxbytes", "Max Bytes", CFG_T_U64),
+    CFG_FIELD(sequence_t, pps, "pps", "Packets Per Second", CFG_T_U64),
+    CFG_FIELD(sequence_t, bps, "bps", "Bytes Per Second", CFG_T_U64),
+    CFG_FIELD(sequence_t, time, "time", "Time", CFG_T_U64),
+    CFG_FIELD(sequence_t, delay, "delay", "Delay", CFG_T_U64),
+    CFG_FIELD(sequence_t, threads, "threads", "Threads", CFG_T_U16),
+    CFG_CUSTOM("cpus", "CPUs", parse_cpus, print_cpus),
+    CFG_CUSTOM("numa", "NUMA", parse_numa, print_numa),
+    CFG_OBJ(sequence_t, eth, "eth", "Ethernet", &eth_schema),
+    CFG_OBJ(sequence_t, ip, "ip", "IP", &ip_schema),
+    CFG_OBJ(sequence_t, tcp, "tcp", "TCP", &tcp_schema),
+    CFG_OBJ(sequence_t, udp, "udp", "UDP", &udp_schema),
+    CFG_OBJ(sequence_t, icmp, "icmp", "ICMP", &icmp_schema),
+    CFG_FIELD(sequence_t, l4_csum, "l4csum", "Layer 4 Checksum", CFG_T_BOOL),
+    CFG_FIELD(sequence_t, csum_offload, "csumoffload", "Checksum Offload", CFG_T_BOOL),
+    CFG_FIELD(sequence_t, gso_size, "gsosize", "GSO Size", CFG_T_U16),
+    CFG_CUSTOM("payloads", "Payloads", parse_payloads, print_payloads),
+};
+
+static const cfg_field_t root_fields[] =
+{
+    CFG_FIELD(config_t, interface, "interface", "Interface", CFG_T_STR),
+    CFG_CUSTOM("sequences", NULL, parse_sequences, NULL),
+};
+
+static cfg_schema_t seq_schema = CFG_SCHEMA("sequence", seq_fields);
+static cfg_schema_t root_schema = CFG_SCHEMA("config", root_fields);
+
+static cfg_schema_t *cfg_schemas[] = { &eth_schema, &ttl_schema, &id_schema, &ip_schema, &tcp_schema, &udp_schema, &icmp_schema, &length_schema, &payload_schema, &seq_schema, &root_schema };
+
+static pthread_once_t cfg_schemas_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Hashes a key with a seed (FNV-1a with a final mix).
+ * 
+ * @param key The key.
+ * @param seed The seed.
+ * 
+ * @return The hash.
+**/
+static inline u32 cfg_hash(const char *key, u32 seed)
+{
+    u32 hash = 2166136261U ^ seed;
+
+    while (*key)
+    {
+        hash ^= (u8)*key++;
+        hash *= 16777619U;
+    }
+
+    return hash ^ (hash >> 15);
+}
+
+/**
+ * Finds a seed that maps every key of a schema to its own slot.
+ * 
+ * @param schema A pointer to the schema.
+ * 
+ * @return Void
+**/
+static void cfg_build_schema(cfg_schema_t *schema)
+{
+    u32 size = 8;
+
+    while (size < schema->count * 4u && size < CFG_HASH_SLOTS)
+    {
+        size *= 2;
+    }
+
+    for (u32 seed = 0; ; seed++)
+    {
+        // Give up on this size after enough seeds and try a larger table.
+        if (seed > 0 && (seed & 0xffff) == 0 && size < CFG_HASH_SLOTS)
+        {
+            size *= 2;
+        }
+
+        int ok = 1;
+
+        memset(schema->slots, 0, sizeof(schema->slots));
+
+        for (u16 i = 0; i < schema->count && ok; i++)
+        {
+            if (schema->fields[i].key == NULL)
+            {
+                continue;
+            }
+
+            u32 slot = cfg_hash(schema->fields[i].key, seed) & (size - 1);
+
+            if (schema->slots[slot] != 0)
+            {
+                ok = 0;
+            }
+
+            schema->slots[slot] = i + 1;
+        }
+
+        if (ok)
+        {
+            schema->seed = seed;
+            schema->mask = size - 1;
+
+            return;
+        }
+    }
+}
+
+/**
+ * Builds the perfect hashes of every schema.
+ * 
+ * @return Void
+**/
+static void cfg_build_schemas()
+{
+    for (size_t i = 0; i < sizeof(cfg_schemas) / sizeof(cfg_schemas[0]); i++)
+    {
+        cfg_build_schema(cfg_schemas[i]);
+    }
+}
+
+/**
+ * Looks up a key in a schema.
+ * 
+ * @param schema A pointer to the schema.
+ * @param key The key.
+ * 
+ * @return A pointer to the field or NULL if the schema has no such key.
+**/
+static inline const cfg_field_t *cfg_lookup(const cfg_schema_t *schema, const char *key)
+{
+    u8 slot = schema->slots[cfg_hash(key, schema->seed) & schema->mask];
+
+    if (slot == 0)
+    {
+        return NULL;
+    }
+
+    const cfg_field_t *field = &schema->fields[slot - 1];
+
+    return strcmp(field->key, key) == 0 ? field : NULL;
+}
+
+/**
+ * Reports an invalid value.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param schema A pointer to the schema holding the field.
+ * @param key The key.
+ * @param why Why the value is invalid.
+ * 
+ * @return Void
+**/
+static void cfg_invalid(const cfg_parse_t *ctx, const cfg_schema_t *schema, const char *key, const char *why)
+{
+    if (ctx->seq_idx < 0)
+    {
+        fprintf(stderr, "Invalid value for '%s' in %s (%s).\n", key, schema->name, why);
+    }
+    else
+    {
+        fprintf(stderr, "Invalid value for '%s' in %s of sequence #%d (%s).\n", key, schema->name, ctx->seq_idx, why);
+    }
+}
+
+/**
+ * Validates and stores a value according to its field.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param schema A pointer to the schema holding the field.
+ * @param field A pointer to the field.
+ * @param base A pointer to the object that holds the field.
+ * @param val The JSON value.
+ * 
+ * @return 0 on success (invalid values are reported and skipped) or -1 on failure (allocation failure).
+**/
+static int cfg_set(cfg_parse_t *ctx, const cfg_schema_t *schema, const cfg_field_t *field, void *base, json_object *val)
+{
+    u8 *ptr = (u8 *)base + field->offset;
+    json_type type = json_object_get_type(val);
+
+    switch (field->type)
+    {
+        case CFG_T_STR:
+            if (type != json_type_string)
+            {
+                break;
+            }
+
+            if ((*(char **)ptr = arena_strdup(&ctx->cfg->arena, json_object_get_string(val))) == NULL)
+            {
+                return -1;
+            }
+
+            return 0;
+
+        case CFG_T_BOOL:
+            if (type != json_type_boolean && type != json_type_int)
+            {
+                break;
+            }
+
+            *ptr = json_object_get_boolean(val) ? 1 : 0;
+
+            return 0;
+
+        case CFG_T_U8:
+        case CFG_T_U16:
+        case CFG_T_U32:
+        case CFG_T_U64:
+        {
+            if (type != json_type_int)
+            {
+                break;
+            }
+
+            u64 num = json_object_get_uint64(val);
+
+            if (json_object_get_int64(val) < 0 || num > cfg_type_max[field->type])
+            {
+                cfg_invalid(ctx, schema, field->key, "out of range");
+
+                return 0;
+            }
+
+            if (field->type == CFG_T_U8)
+            {
+                *ptr = num;
+            }
+            else if (field->type == CFG_T_U16)
+            {
+                *(u16 *)ptr = num;
+            }
+            else if (field->type == CFG_T_U32)
+            {
+                *(u32 *)ptr = num;
+            }
+            else
+            {
+                *(u64 *)ptr = num;
+            }
+
+            return 0;
+        }
+
+        case CFG_T_OBJ:
+            if (type != json_type_object)
+            {
+                break;
+            }
+
+            return cfg_walk(ctx, field->sub, ptr, val);
+
+        case CFG_T_CUSTOM:
+            return field->parse(ctx, base, val);
+    }
+
+    char why[32];
+    snprintf(why, sizeof(why), "expected %s", cfg_type_names[field->type]);
+
+    cfg_invalid(ctx, schema, field->key, why);
+
+    return 0;
+}
+
+/**
+ * Walks an object's keys once, dispatching each through the schema's perfect hash.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param schema A pointer to the object's schema.
+ * @param base A pointer to the structure to fill out.
+ * @param obj The JSON object.
+ * 
+ * @return 0 on success or -1 on failure (allocation failure).
+**/
+static int cfg_walk(cfg_parse_t *ctx, const cfg_schema_t *schema, void *base, json_object *obj)
+{
+    json_object_object_foreach(obj, key, val)
+    {
+        const cfg_field_t *field = cfg_lookup(schema, key);
+
+        if (field == NULL)
+        {
+            if (ctx->log)
+            {
+                fprintf(stderr, "Unknown key '%s' in %s.\n", key, schema->name);
+            }
+
+            continue;
+        }
+
+        if (val == NULL || json_object_get_type(val) == json_type_null)
+        {
+            continue;
+        }
+
+        if (cfg_set(ctx, schema, field, base, val) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Parses a sequence's includes. Paths are stored resolved against the including file.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param base A pointer to the sequence.
+ * @param val The JSON array of file names.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int parse_includes(cfg_parse_t *ctx, void *base, json_object *val)
+{
+    sequence_t *seq = base;
+
+    if (json_object_get_type(val) != json_type_array)
+    {
+        cfg_invalid(ctx, &seq_schema, "includes", "expected array");
+
+        return 0;
+    }
+
+    int len = json_object_array_length(val);
+
+    if (len > UINT16_MAX)
+    {
+        cfg_invalid(ctx, &seq_schema, "includes", "too many entries");
+
+        len = UINT16_MAX;
+    }
+
+    if (len < 1)
+    {
+        return 0;
+    }
+
+    if ((seq->includes = arena_calloc(&ctx->cfg->arena, len, sizeof(char *))) == NULL)
+    {
+        return -1;
+    }
+
+    seq->include_count = 0;
+
+    for (int i = 0; i < len; i++)
+    {
+        json_object *inc_obj = json_object_array_get_idx(val, i);
+
+        if (json_object_get_type(inc_obj) != json_type_string)
+        {
+            cfg_invalid(ctx, &seq_schema, "includes", "expected string");
+
+            continue;
+        }
+
+        char path[PATH_MAX];
+
+        if (cfg_resolve_path(ctx->file, json_object_get_string(inc_obj), path, sizeof(path)) != 0)
+        {
+            cfg_invalid(ctx, &seq_schema, "includes", "path too long");
+
+            continue;
+        }
+
+        if ((seq->includes[seq->include_count++] = arena_strdup(&ctx->cfg->arena, path)) == NULL)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Parses a sequence's CPU list.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param base A pointer to the sequence.
+ * @param val The JSON string (e.g. "0-3,8").
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int parse_cpus(cfg_parse_t *ctx, void *base, json_object *val)
+{
+    sequence_t *seq = base;
+
+    if (json_object_get_type(val) != json_type_string || topo_parse_cpu_list(json_object_get_string(val), NULL, 0) < 1)
+    {
+        cfg_invalid(ctx, &seq_schema, "cpus", "expected CPU list");
+
+        return 0;
+    }
+
+    return (seq->cpus = arena_strdup(&ctx->cfg->arena, json_object_get_string(val))) != NULL ? 0 : -1;
+}
+
+/**
+ * Parses a sequence's NUMA policy.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param base A pointer to the sequence.
+ * @param val A node number or "auto"/"none".
+ * 
+ * @return 0 on success.
+**/
+static int parse_numa(cfg_parse_t *ctx, void *base, json_object *val)
+{
+    sequence_t *seq = base;
+    int numa = json_object_get_type(val) == json_type_int ? json_object_get_int(val) : topo_parse_numa(json_object_get_string(val));
+
+    if (numa < TOPO_NUMA_NONE)
+    {
+        cfg_invalid(ctx, &seq_schema, "numa", "expected node, \"auto\", or \"none\"");
+
+        return 0;
+    }
+
+    seq->numa = numa;
+
+    return 0;
+}
+
+/**
+ * Parses an IP object's source ranges. Ranges are either a string or an object with a range and an optional weight.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param base A pointer to the IP options.
+ * @param val The JSON array of ranges.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int parse_ranges(cfg_parse_t *ctx, void *base, json_object *val)
+{
+    ip_opt_t *ip = base;
+
+    if (json_object_get_type(val) != json_type_array)
+    {
+        cfg_invalid(ctx, &ip_schema, "ranges", "expected array");
+
+        return 0;
+    }
+
+    int len = json_object_array_length(val);
+
+    if (len > UINT16_MAX)
+    {
+        cfg_invalid(ctx, &ip_schema, "ranges", "too many entries");
+
+        len = UINT16_MAX;
+    }
+
+    if (len < 1)
+    {
+        return 0;
+    }
+
+    ip->ranges = arena_calloc(&ctx->cfg->arena, len, sizeof(char *));
+    ip->range_weights = arena_calloc(&ctx->cfg->arena, len, sizeof(u32));
+
+    if (ip->ranges == NULL || ip->range_weights == NULL)
+    {
+        return -1;
+    }
+
+    ip->range_count = 0;
+
+    for (int i = 0; i < len; i++)
+    {
+        json_object *range_obj = json_object_array_get_idx(val, i);
+        json_object *tmp_obj;
+        const char *range = NULL;
+        u32 weight = 0;
+
+        if (json_object_get_type(range_obj) == json_type_object)
+        {
+            if (json_object_object_get_ex(range_obj, "range", &tmp_obj))
+            {
+                range = json_object_get_string(tmp_obj);
+            }
+
+            if (json_object_object_get_ex(range_obj, "weight", &tmp_obj))
+            {
+                int64_t w = json_object_get_int64(tmp_obj);
+
+                // Invalid weights are skipped like other invalid values (the range is weighted by its size).
+                if (json_object_get_type(tmp_obj) != json_type_int || w < 0 || w > UINT32_MAX)
+                {
+                    cfg_invalid(ctx, &ip_schema, "weight", "expected integer between 0 and 4294967295");
+                }
+                else
+                {
+                    weight = (u32)w;
+                }
+            }
+        }
+        else if (json_object_get_type(range_obj) == json_type_string)
+        {
+            range = json_object_get_string(range_obj);
+        }
+
+        if (range == NULL)
+        {
+            cfg_invalid(ctx, &ip_schema, "ranges", "expected range string or object");
+
+            continue;
+        }
+
+        if ((ip->ranges[ip->range_count] = arena_strdup(&ctx->cfg->arena, range)) == NULL)
+        {
+            return -1;
+        }
+
+        ip->range_weights[ip->range_count++] = weight;
+    }
+
+    return 0;
+}
+
+/**
+ * Parses a sequence's payloads and loads static ones.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param base A pointer to the sequence.
+ * @param val The JSON array of payload objects.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int parse_payloads(cfg_parse_t *ctx, void *base, json_object *val)
+{
+    sequence_t *seq = base;
+
+    if (json_object_get_type(val) != json_type_array)
+    {
+        cfg_invalid(ctx, &seq_schema, "payloads", "expected array");
+
+        return 0;
+    }
+
+    int len = json_object_array_length(val);
+
+    if (len < 1)
+    {
+        return 0;
+    }
+
+    // Payloads from an included fragment are replaced.
+    for (int i = 0; i < seq->pl_cnt; i++)
+    {
+        free_payload(&seq->pls[i]);
+    }
+
+    seq->pl_cnt = 0;
+
+    if ((seq->pls = arena_calloc(&ctx->cfg->arena, len, sizeof(payload_opt_t))) == NULL)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < len; i++)
+    {
+        json_object *pl_obj = json_object_array_get_idx(val, i);
+        payload_opt_t *pl = &seq->pls[seq->pl_cnt];
+
+        if (json_object_get_type(pl_obj) != json_type_object)
+        {
+            cfg_invalid(ctx, &seq_schema, "payloads", "expected object");
+
+            continue;
+        }
+
+        if (cfg_walk(ctx, &payload_schema, pl, pl_obj) != 0)
+        {
+            return -1;
+        }
+
+        // Decode static payloads and precompute their partial checksum once.
+        if (load_payload(&ctx->cfg->pl_store, pl) < 0 && ctx->log)
+        {
+            fprintf(stderr, "Failed to load static payload #%d of sequence #%d.\n", i + 1, ctx->seq_idx);
+        }
+
+        seq->pl_cnt++;
+    }
+
+    return 0;
+}
+
+/**
+ * Finishes a parsed sequence (address family detection and range compilation).
+ * 
+ * Invalid IPv6 ranges and weights given to IPv6 ranges (which aren't supported) are reported and skipped like other invalid values.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param seq A pointer to the sequence.
+ * 
+ * @return 0 on success or -1 if the sequence mixes IPv4 and IPv6 and should be skipped.
+**/
+static int finish_sequence(cfg_parse_t *ctx, sequence_t *seq)
+{
+    int i = ctx->seq_idx;
+
+    // Detect IPv6 and make sure addresses and ranges don't mix families.
+    int v6 = is_ipv6(seq->ip.src_ip) || is_ipv6(seq->ip.dst_ip);
+    int v4 = (seq->ip.src_ip && !is_ipv6(seq->ip.src_ip)) || (seq->ip.dst_ip && !is_ipv6(seq->ip.dst_ip));
+
+    for (int j = 0; j < seq->ip.range_count; j++)
+    {
+        v6 |= is_ipv6(seq->ip.ranges[j]);
+        v4 |= !is_ipv6(seq->ip.ranges[j]);
+    }
+
+    if (v4 && v6)
+    {
+        cfg_invalid(ctx, &ip_schema, seq->ip.range_count > 0 ? "ranges" : "sip", "mixes IPv4 and IPv6 addresses");
+
+        return -1;
+    }
+
+    seq->ip.is_ipv6 = v6;
+
+    if (seq->ip.is_ipv6)
+    {
+        ip6_range_t range;
+        u16 cnt = 0;
+
+        for (int j = 0; j < seq->ip.range_count; j++)
+        {
+            if (parse_ip6_range(seq->ip.ranges[j], &range) != 0)
+            {
+                cfg_invalid(ctx, &ip_schema, "ranges", "invalid IPv6 range");
+
+                continue;
+            }
+
+            if (seq->ip.range_weights[j] > 0)
+            {
+                cfg_invalid(ctx, &ip_schema, "weight", "not supported for IPv6 ranges");
+            }
+
+            seq->ip.ranges[cnt] = seq->ip.ranges[j];
+            seq->ip.range_weights[cnt++] = 0;
+        }
+
+        seq->ip.range_count = cnt;
+    }
+    else if (compile_ranges(&seq->ip.range_tbl, seq->ip.ranges, seq->ip.range_weights, seq->ip.range_count, seq->ip.src_ip) < 0)
+    {
+        // Compile source ranges once so senders never parse strings per packet.
+        fprintf(stderr, "Failed to compile one or more source ranges in sequence #%d.\n", i);
+    }
+
+    return 0;
+}
+
+/**
+ * Records an include in a sequence's include list (kept so every file a sequence depends on is listed).
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param incs A pointer to the list.
+ * @param cnt A pointer to the amount of includes in the list.
+ * @param path The resolved path.
+ * 
+ * @return 0 on success or -1 on failure (allocation failure).
+**/
+static int add_include(cfg_parse_t *ctx, char ***incs, int *cnt, const char *path)
+{
+    for (int i = 0; i < *cnt; i++)
+    {
+        if (strcmp((*incs)[i], path) == 0)
+        {
+            return 0;
+        }
+    }
+
+    if (*cnt >= UINT16_MAX)
+    {
+        return 0;
+    }
+
+    // Grow in powers of two (old arrays stay in the arena).
+    if ((*cnt & (*cnt - 1)) == 0)
+    {
+        char **list = arena_alloc(&ctx->cfg->arena, sizeof(char *) * (*cnt ? *cnt * 2 : 1), sizeof(char *));
+
+        if (list == NULL)
+        {
+            return -1;
+        }
+
+        if (*cnt > 0)
+        {
+            memcpy(list, *incs, sizeof(char *) * *cnt);
+        }
+
+        *incs = list;
+    }
+
+    if (((*incs)[*cnt] = arena_strdup(&ctx->cfg->arena, path)) == NULL)
+    {
+        return -1;
+    }
+
+    *cnt += 1;
+
+    return 0;
+}
+
+/**
+ * Applies included fragments to a sequence. A fragment is an included file without a sequences array; its keys are walked as sequence keys. Nested fragments are applied before the fragment that includes them.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param idx The sequence's index.
+ * @param val The JSON array of includes.
+ * @param depth The nesting depth.
+ * @param chain The fragments being applied at each shallower depth (a fragment including one of them is a cycle and is skipped).
+ * @param incs A pointer to the sequence's include list.
+ * @param cnt A pointer to the amount of includes in the list.
+ * 
+ * @return 0 on success or -1 on failure (allocation failure).
+**/
+static int apply_fragments(cfg_parse_t *ctx, int idx, json_object *val, int depth, cfg_doc_t **chain, char ***incs, int *cnt)
+{
+    if (json_object_get_type(val) != json_type_array)
+    {
+        return 0;
+    }
+
+    if (depth >= CFG_LOADER_MAX_DEPTH)
+    {
+        fprintf(stderr, "Includes of sequence #%d are nested too deeply in '%s'.\n", ctx->seq_idx, ctx->file);
+
+        return 0;
+    }
+
+    int len = json_object_array_length(val);
+
+    for (int i = 0; i < len; i++)
+    {
+        json_object *inc_obj = json_object_array_get_idx(val, i);
+        char path[PATH_MAX];
+
+        if (json_object_get_type(inc_obj) != json_type_string || cfg_resolve_path(ctx->file, json_object_get_string(inc_obj), path, sizeof(path)) != 0)
+        {
+            continue;
+        }
+
+        if (add_include(ctx, incs, cnt, path) != 0)
+        {
+            return -1;
+        }
+
+        cfg_doc_t *doc = cfg_loader_find(ctx->loader, path);
+        json_object *root = cfg_doc_root(doc);
+        json_object *tmp_obj;
+
+        if (root == NULL)
+        {
+            fprintf(stderr, "Failed to load include '%s' of sequence #%d.\n", path, ctx->seq_idx);
+
+            continue;
+        }
+
+        // Sequence files are appended after the array instead.
+        if (json_object_object_get_ex(root, "sequences", &tmp_obj))
+        {
+            continue;
+        }
+
+        // Files are compared by content, so the same file reached through another path is caught too.
+        cfg_doc_t *canon = doc->same ? doc->same : doc;
+        int cycle = 0;
+
+        for (int j = 0; j < depth; j++)
+        {
+            if (chain[j] == canon)
+            {
+                cycle = 1;
+
+                break;
+            }
+        }
+
+        if (cycle)
+        {
+            fprintf(stderr, "Skipping include cycle through '%s' in sequence #%d.\n", path, idx);
+
+            continue;
+        }
+
+        chain[depth] = canon;
+
+        const char *file = ctx->file;
+        int ret = 0;
+
+        ctx->file = doc->path;
+
+        if (json_object_object_get_ex(root, "includes", &tmp_obj))
+        {
+            ret = apply_fragments(ctx, idx, tmp_obj, depth + 1, chain, incs, cnt);
+        }
+
+        if (ret == 0)
+        {
+            ret = cfg_walk(ctx, &seq_schema, &ctx->cfg->seq[idx], root);
+        }
+
+        ctx->file = file;
+
+        if (ret != 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Appends the sequences of files included by a range of sequences. Each file (by content) is appended once, no matter how many sequences include it.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param first The first sequence's index.
+ * @param last The index after the last sequence.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int append_includes(cfg_parse_t *ctx, int first, int last)
+{
+    for (int i = first; i < last; i++)
+    {
+        // The sequence array may move while appending, so index it each time.
+        for (int j = 0; j < ctx->cfg->seq[i].include_count; j++)
+        {
+            cfg_doc_t *doc = cfg_loader_find(ctx->loader, ctx->cfg->seq[i].includes[j]);
+            json_object *root = cfg_doc_root(doc);
+            json_object *seqs;
+
+            if (root == NULL || !json_object_object_get_ex(root, "sequences", &seqs))
+            {
+                continue;
+            }
+
+            cfg_doc_t *canon = doc->same ? doc->same : doc;
+
+            if (canon->appended)
+            {
+                continue;
+            }
+
+            canon->appended = 1;
+
+            // Only sequences are taken from included files.
+            const char *file = ctx->file;
+            int seq_idx = ctx->seq_idx;
+
+            ctx->file = doc->path;
+
+            int ret = parse_sequences(ctx, ctx->cfg, seqs);
+
+            ctx->file = file;
+            ctx->seq_idx = seq_idx;
+
+            if (ret != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Parses the sequences array, appending after any sequences parsed before. Included fragments are applied first (the sequence's own keys override them) and included sequence files are appended after the array.
+ * 
+ * @param ctx A pointer to the parse context.
+ * @param base A pointer to the config structure.
+ * @param val The JSON array of sequence objects.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int parse_sequences(cfg_parse_t *ctx, void *base, json_object *val)
+{
+    config_t *cfg = base;
+
+    if (json_object_get_type(val) != json_type_array)
+    {
+        return 0;
+    }
+
+    ctx->has_seqs = 1;
+
+    int seq_len = json_object_array_length(val);
+
+    if (seq_len < 1)
+    {
+        return 0;
+    }
+
+    if (reserve_sequences(cfg, *ctx->seq_num + seq_len) != 0)
+    {
+        return -1;
+    }
+
+    int first = *ctx->seq_num;
+
+    for (int i = 0; i < seq_len; i++)
+    {
+        json_object *seq_obj = json_object_array_get_idx(val, i);
+        sequence_t *seq = &cfg->seq[*ctx->seq_num];
+        json_object *inc_obj;
+
+        ctx->seq_idx = i;
+
+        if (json_object_get_type(seq_obj) != json_type_object)
+        {
+            cfg_invalid(ctx, &root_schema, "sequences", "expected object");
+
+            continue;
+        }
+
+        char **incs = NULL;
+        int inc_cnt = 0;
+        cfg_doc_t *chain[CFG_LOADER_MAX_DEPTH];
+
+        if (json_object_object_get_ex(seq_obj, "includes", &inc_obj) && apply_fragments(ctx, *ctx->seq_num, inc_obj, 0, chain, &incs, &inc_cnt) != 0)
+        {
+            return -1;
+        }
+
+        if (cfg_walk(ctx, &seq_schema, seq, seq_obj) != 0)
+        {
+            return -1;
+        }
+
+        if (inc_cnt > 0)
+        {
+            seq->includes = incs;
+            seq->include_count = inc_cnt;
+        }
+
+        // Sequences that can't be sent are dropped and their slot reused.
+        if (finish_sequence(ctx, seq) != 0)
+        {
+            for (int j = 0; j < seq->pl_cnt; j++)
+            {
+                free_payload(&seq->pls[j]);
+            }
+
+            clear_sequence(cfg, *ctx->seq_num);
+
+            continue;
+        }
+
+        *ctx->seq_num += 1;
+    }
+
+    ctx->seq_idx = -1;
+
+    return append_includes(ctx, first, *ctx->seq_num);
+}
+
+/**
+ * Prints tabs for a depth.
+ * 
+ * @param depth The depth.
+ * 
+ * @return Void
+**/
+static void print_indent(int depth)
+{
+    for (int i = 0; i < depth; i++)
+    {
+        fputc('\t', stdout);
+    }
+}
+
+/**
+ * Prints a sequence's includes.
  * 
- * @param file_name The YAML config file to parse.
- * @param cfg A pointer to a config structure that'll be filled in with values.
- * @param only_seq If set to 1, this function will only parse sequences and add onto the number.
- * @param seq_num A pointer to the current sequence # (starting from 0).
+ * @param base A pointer to the sequence.
+ * @param depth The depth to print at.
  * 
- * @return Returns 0 on success and -1 on failure.
+ * @return Void
 **/
-int parse_config(const char file_name[], config_t *cfg, int only_seq, int *seq_num, u8 log)
-{    
-    // Attempt to open config file with JSON.
-    json_object *root = json_object_from_file(file_name);
+static void print_includes(const void *base, int depth)
+{
+    const sequence_t *seq = base;
 
-    if (root == NULL)
+    print_indent(depth);
+    fprintf(stdout, "Includes =>\n");
+
+    for (int i = 0; i < seq->include_count; i++)
     {
-        fprintf(stderr, "Failed to open config file '%s'.\n", file_name);
+        print_indent(depth + 1);
+        fprintf(stdout, "- %s\n", seq->includes[i]);
+    }
+}
 
-        return 1;
+/**
+ * Prints a sequence's CPU list.
+ * 
+ * @param base A pointer to the sequence.
+ * @param depth The depth to print at.
+ * 
+ * @return Void
+**/
+static void print_cpus(const void *base, int depth)
+{
+    const sequence_t *seq = base;
+
+    print_indent(depth);
+    fprintf(stdout, "CPUs => %s\n", seq->cpus ? seq->cpus : "N/A");
+}
+
+/**
+ * Prints a sequence's NUMA policy.
+ * 
+ * @param base A pointer to the sequence.
+ * @param depth The depth to print at.
+ * 
+ * @return Void
+**/
+static void print_numa(const void *base, int depth)
+{
+    const sequence_t *seq = base;
+
+    print_indent(depth);
+
+    if (seq->numa >= 0)
+    {
+        fprintf(stdout, "NUMA => %d\n", seq->numa);
     }
+    else
+    {
+        fprintf(stdout, "NUMA => %s\n", seq->numa == TOPO_NUMA_NONE ? "None" : "Auto");
+    }
+}
 
-    json_object *tmp_obj;
+/**
+ * Prints an IP object's source ranges.
+ * 
+ * @param base A pointer to the IP options.
+ * @param depth The depth to print at.
+ * 
+ * @return Void
+**/
+static void print_ranges(const void *base, int depth)
+{
+    const ip_opt_t *ip = base;
 
-    // Parse global interface.
-    if (json_object_object_get_ex(root, "interface", &tmp_obj))
+    if (ip->range_count < 1)
     {
-        cfg->interface = (char *) json_object_get_string(tmp_obj);
+        return;
     }
 
-    // Parse sequences array.
-    json_object *j_sequences;
+    print_indent(depth);
+    fprintf(stdout, "Ranges:\n");
 
-    if (!json_object_object_get_ex(root, "sequences", &j_sequences))
+    for (int i = 0; i < ip->range_count; i++)
     {
-        fprintf(stderr, "Failed to open sequences array.\n");
+        print_indent(depth + 1);
 
-        return 1;
+        if (ip->range_weights[i] > 0)
+        {
+            fprintf(stdout, "- %s (weight %u)\n", ip->ranges[i], ip->range_weights[i]);
+        }
+        else
+        {
+            fprintf(stdout, "- %s\n", ip->ranges[i]);
+        }
     }
+}
 
-    // Check length of sequences.
-    int seq_len = json_object_array_length(j_sequences);
+/**
+ * Prints a sequence's payloads.
+ * 
+ * @param base A pointer to the sequence.
+ * @param depth The depth to print at.
+ * 
+ * @return Void
+**/
+static void print_payloads(const void *base, int depth)
+{
+    const sequence_t *seq = base;
 
-    if (seq_len > 0)
+    if (seq->pl_cnt < 1)
     {
-        // Loop through each sequence.
-        for (int i = 0; i < seq_len; i++)
-        {
-            // Retrieve current sequence.
-            sequence_t *seq = &cfg->seq[i];
+        return;
+    }
 
-            // Get sequence JSON object.
-            json_object *seq_obj = json_object_array_get_idx(j_sequences, i);
+    print_indent(depth);
+    fprintf(stdout, "Payloads (%d)\n", seq->pl_cnt);
 
-            // Retrieve interface.
-            if (json_object_object_get_ex(seq_obj, "interface", &tmp_obj))
-            {
-                seq->interface = (char *) json_object_get_string(tmp_obj);
-            }
+    for (int i = 0; i < seq->pl_cnt; i++)
+    {
+        print_indent(depth + 1);
+        fprintf(stdout, "#%d\n", i + 1);
 
-            // Retrieve block.
-            if (json_object_object_get_ex(seq_obj, "block", &tmp_obj))
-            {
-                seq->block = json_object_get_boolean(tmp_obj);
-            }
+        cfg_print_fields(&payload_schema, &seq->pls[i], depth + 2);
+    }
+}
 
-            // Retrieve max packets.
-            if (json_object_object_get_ex(seq_obj, "maxpckts", &tmp_obj))
-            {
-                seq->max_pckts = json_object_get_uint64(tmp_obj);
-            }
+/**
+ * Prints every field of a schema.
+ * 
+ * @param schema A pointer to the schema.
+ * @param base A pointer to the structure holding the fields.
+ * @param depth The depth to print at.
+ * 
+ * @return Void
+**/
+static void cfg_print_fields(const cfg_schema_t *schema, const void *base, int depth)
+{
+    for (u16 i = 0; i < schema->count; i++)
+    {
+        const cfg_field_t *field = &schema->fields[i];
+        const u8 *ptr = (const u8 *)base + field->offset;
 
-            // Retrieve max bytes.
-            if (json_object_object_get_ex(seq_obj, "maxbytes", &tmp_obj))
+        if (field->type == CFG_T_OBJ)
+        {
+            if (field->flags & CFG_F_FLAT)
             {
-                seq->max_bytes = json_object_get_uint64(tmp_obj);
+                cfg_print_fields(field->sub, ptr, depth);
             }
-
-            // Retrieve packets per second rate.
-            if (json_object_object_get_ex(seq_obj, "pps", &tmp_obj))
+            else
             {
-                seq->pps = json_object_get_uint64(tmp_obj);
-            }
+                print_indent(depth);
+                fprintf(stdout, "%s\n", field->label);
 
-            // Retrieve bytes per second rate.
-            if (json_object_object_get_ex(seq_obj, "bps", &tmp_obj))
-            {
-                seq->bps = json_object_get_uint64(tmp_obj);
+                cfg_print_fields(field->sub, ptr, depth + 1);
             }
 
-            // Retrieve time
-            if (json_object_object_get_ex(seq_obj, "time", &tmp_obj))
-            {
-                seq->time = json_object_get_int(tmp_obj);
-            }
+            continue;
+        }
 
-            // Retrieve threads.
-            if (json_object_object_get_ex(seq_obj, "threads", &tmp_obj))
+        if (field->type == CFG_T_CUSTOM)
+        {
+            if (field->print != NULL)
             {
-                seq->threads = json_object_get_int(tmp_obj);
+                field->print(base, depth);
             }
 
-            // Retrieve delay.
-            if (json_object_object_get_ex(seq_obj, "delay", &tmp_obj))
-            {
-                seq->delay = json_object_get_uint64(tmp_obj);
-            }
+            continue;
+        }
 
-            // Retrieve tracking.
-            if (json_object_object_get_ex(seq_obj, "track", &tmp_obj))
-            {
-                seq->track = json_object_get_boolean(tmp_obj);
-            }
+        if (field->label == NULL)
+        {
+            continue;
+        }
 
-            // Retrieve layer-4 checksum.
-            if (json_object_object_get_ex(seq_obj, "l4csum", &tmp_obj))
-            {
-                seq->l4_csum = json_object_get_boolean(tmp_obj);
-            }
+        print_indent(depth);
 
-            // Retrieve ethernet object.
-            json_object *eth_obj;
+        switch (field->type)
+        {
+            case CFG_T_STR:
+                fprintf(stdout, "%s => %s\n", field->label, *(char * const *)ptr ? *(char * const *)ptr : "N/A");
 
-            if (json_object_object_get_ex(seq_obj, "eth", &eth_obj))
-            {
-                // Source MAC address.
-                if (json_object_object_get_ex(eth_obj, "smac", &tmp_obj))
-                {
-                    seq->eth.src_mac = (char *) json_object_get_string(tmp_obj);
-                }
+                break;
 
-                // Destination MAC address.
-                if (json_object_object_get_ex(eth_obj, "dmac", &tmp_obj))
-                {
-                    seq->eth.dst_mac = (char *) json_object_get_string(tmp_obj);
-                }
-            }
+            case CFG_T_BOOL:
+                fprintf(stdout, "%s => %s\n", field->label, *ptr ? "Yes" : "No");
 
-            // Retrieve IP object.
-            json_object *ip_obj;
+                break;
 
-            if (json_object_object_get_ex(seq_obj, "ip", &ip_obj))
-            {
-                // Source IP.
-                if (json_object_object_get_ex(ip_obj, "sip", &tmp_obj))
-                {
-                    seq->ip.src_ip = (char *) json_object_get_string(tmp_obj);
-                }
+            case CFG_T_U8:
+                fprintf(stdout, "%s => %u\n", field->label, *ptr);
 
-                // Destination IP.
-                if (json_object_object_get_ex(ip_obj, "dip", &tmp_obj))
-                {
-                    seq->ip.dst_ip = (char *) json_object_get_string(tmp_obj);
-                }
+                break;
 
-                // Protocol.
-                if (json_object_object_get_ex(ip_obj, "protocol", &tmp_obj))
-                {
-                    seq->ip.protocol = (char *) json_object_get_string(tmp_obj);
-                }
+            case CFG_T_U16:
+                fprintf(stdout, "%s => %u\n", field->label, *(const u16 *)ptr);
 
-                // ToS.
-                if (json_object_object_get_ex(ip_obj, "tos", &tmp_obj))
-                {
-                    seq->ip.tos = json_object_get_int(tmp_obj);
-                }
+                break;
 
-                // Checksum.
-                if (json_object_object_get_ex(ip_obj, "csum", &tmp_obj))
-                {
-                    seq->ip.csum = json_object_get_boolean(tmp_obj);
-                }
+            case CFG_T_U32:
+                fprintf(stdout, "%s => %u\n", field->label, *(const u32 *)ptr);
 
-                // TTL object.
-                json_object *ttl_obj;
+                break;
 
-                if (json_object_object_get_ex(ip_obj, "ttl", &ttl_obj))
-                {
-                    // Minimum TTL.
-                    if (json_object_object_get_ex(ttl_obj, "min", &tmp_obj))
-                    {
-                        seq->ip.min_ttl = json_object_get_int(tmp_obj);
-                    }
-
-                    // Maximum TTL.
-                    if (json_object_object_get_ex(ttl_obj, "max", &tmp_obj))
-                    {
-                        seq->ip.max_ttl = json_object_get_int(tmp_obj);
-                    }
-                }
+            case CFG_T_U64:
+                fprintf(stdout, "%s => %llu\n", field->label, *(const u64 *)ptr);
 
-                // ID object.
-                json_object *id_obj;
+                break;
 
-                if (json_object_object_get_ex(ip_obj, "id", &id_obj))
-                {
-                    // Minimum ID.
-                    if (json_object_object_get_ex(id_obj, "min", &tmp_obj))
-                    {
-                        seq->ip.min_id = json_object_get_int(tmp_obj);
-                    }
-
-                    // Maximum ID.
-                    if (json_object_object_get_ex(id_obj, "max", &tmp_obj))
-                    {
-                        seq->ip.max_id = json_object_get_int(tmp_obj);
-                    }
-                }
+            case CFG_T_HEX32:
+                fprintf(stdout, "%s => 0x%08x\n", field->label, *(const u32 *)ptr);
 
-                // Ranges array.
-                json_object *ranges_obj;
+                break;
+        }
+    }
+}
 
-                if (json_object_object_get_ex(ip_obj, "ranges", &ranges_obj))
-                {
-                    int ranges_len = json_object_array_length(ranges_obj);
-
-                    if (ranges_len > 0)
-                    {
-                        for (int j = 0; j < ranges_len; j++)
-                        {
-                            // Retrieve specific range and add to ranges array.
-                            json_object *range_obj = json_object_array_get_idx(ranges_obj, j);
-
-                            seq->ip.ranges[j] = (char *) json_object_get_string(range_obj);
-                            seq->ip.range_count++;
-                        }
-                    }
-                }
-            }
+/**
+ * Counts the sequences of every file a loader read. Each file's sequences are appended at most once, so this bounds what a parse can add.
+ * 
+ * @param ld A pointer to the loader.
+ * 
+ * @return The amount of sequences.
+**/
+static int count_sequences(cfg_loader_t *ld)
+{
+    int count = 0;
 
-            // UDP object.
-            json_object *udp_obj;
+    for (cfg_doc_t *doc = ld->head; doc != NULL; doc = doc->next)
+    {
+        json_object *seqs;
 
-            if (json_object_object_get_ex(seq_obj, "udp", &udp_obj))
-            {
-                // Source port.
-                if (json_object_object_get_ex(udp_obj, "sport", &tmp_obj))
-                {
-                    seq->udp.src_port = json_object_get_int(tmp_obj);
-                }
+        // Files with identical content are only appended once.
+        if (doc->same == NULL && doc->root != NULL && json_object_object_get_ex(doc->root, "sequences", &seqs) && json_object_get_type(seqs) == json_type_array)
+        {
+            count += json_object_array_length(seqs);
+        }
+    }
 
-                // Destination port.
-                if (json_object_object_get_ex(udp_obj, "dport", &tmp_obj))
-                {
-                    seq->udp.dst_port = json_object_get_int(tmp_obj);
-                }
-            }
+    return count;
+}
 
-            // TCP object.
-            json_object *tcp_obj;
+/**
+ * Parses a config file including the main config options and sequences. It then fills out the config structure passed in the function's parameters.
+ * 
+ * @param file_name The JSON config file to parse.
+ * @param cfg A pointer to a config structure that'll be filled in with values.
+ * @param only_seq If set to 1, this function will only parse sequences and add onto the number.
+ * @param seq_num A pointer to the current sequence # (starting from 0).
+ * @param log Whether to report unknown keys and payload load failures.
+ * 
+ * @return Returns 0 on success and 1 on failure.
+ * 
+ * @note Each object's keys are walked once and dispatched through its schema table. Strings are copied into the config's arena and the JSON documents are freed before returning.
+ * @note Included files are loaded in parallel before walking (see cfg_loader_run()). Fragments are merged into the sequences that include them and sequence files are appended once each.
+**/
+int parse_config(const char file_name[], config_t *cfg, int only_seq, int *seq_num, u8 log)
+{
+    pthread_once(&cfg_schemas_once, cfg_build_schemas);
 
-            if (json_object_object_get_ex(seq_obj, "tcp", &tcp_obj))
-            {
-                // Cooked socket.
-                if (json_object_object_get_ex(tcp_obj, "cooked", &tmp_obj))
-                {
-                    seq->tcp.cooked = json_object_get_boolean(tmp_obj);
-                }
+    // Load the config file and everything it includes.
+    cfg_loader_t loader;
+    cfg_loader_init(&loader);
 
-                // One connection.
-                if (json_object_object_get_ex(tcp_obj, "oneconn", &tmp_obj))
-                {
-                    seq->tcp.one_connection = json_object_get_boolean(tmp_obj);
-                }
+    json_object *root = cfg_loader_run(&loader, file_name);
 
-                // Source port.
-                if (json_object_object_get_ex(tcp_obj, "sport", &tmp_obj))
-                {
-                    seq->tcp.src_port = json_object_get_int(tmp_obj);
-                }
+    if (root == NULL)
+    {
+        fprintf(stderr, "Failed to open config file '%s'.\n", file_name);
 
-                // Destination port.
-                if (json_object_object_get_ex(tcp_obj, "dport", &tmp_obj))
-                {
-                    seq->tcp.dst_port = json_object_get_int(tmp_obj);
-                }
+        cfg_loader_free(&loader);
 
-                // SYN flag.
-                if (json_object_object_get_ex(tcp_obj, "syn", &tmp_obj))
-                {
-                    seq->tcp.syn = json_object_get_boolean(tmp_obj);
-                }
+        return 1;
+    }
 
-                // PSH flag.
-                if (json_object_object_get_ex(tcp_obj, "psh", &tmp_obj))
-                {
-                    seq->tcp.psh = json_object_get_boolean(tmp_obj);
-                }
+    // Size the sequence array once instead of growing it for every appended file.
+    int seq_cnt = count_sequences(&loader);
 
-                // FIN flag.
-                if (json_object_object_get_ex(tcp_obj, "fin", &tmp_obj))
-                {
-                    seq->tcp.fin = json_object_get_boolean(tmp_obj);
-                }
+    if (seq_cnt > 0 && reserve_sequences(cfg, *seq_num + seq_cnt) != 0)
+    {
+        cfg_loader_free(&loader);
 
-                // ACK flag.
-                if (json_object_object_get_ex(tcp_obj, "ack", &tmp_obj))
-                {
-                    seq->tcp.ack = json_object_get_boolean(tmp_obj);
-                }
+        return 1;
+    }
 
-                // RST flag.
-                if (json_object_object_get_ex(tcp_obj, "rst", &tmp_obj))
-                {
-                    seq->tcp.rst = json_object_get_boolean(tmp_obj);
-                }
+    cfg_parse_t ctx = {0};
+    ctx.cfg = cfg;
+    ctx.seq_num = seq_num;
+    ctx.seq_idx = -1;
+    ctx.log = log;
+    ctx.file = file_name;
+    ctx.loader = &loader;
 
-                // URG flag.
-                if (json_object_object_get_ex(tcp_obj, "urg", &tmp_obj))
-                {
-                    seq->tcp.urg = json_object_get_boolean(tmp_obj);
-                }
+    int ret = 0;
 
-                // ECE flag.
-                if (json_object_object_get_ex(tcp_obj, "ece", &tmp_obj))
-                {
-                    seq->tcp.ece = json_object_get_boolean(tmp_obj);
-                }
+    // The config's own sequences are never appended again through an include cycle.
+    cfg_doc_t *self = cfg_loader_find(&loader, file_name);
 
-                // CWR flag.
-                if (json_object_object_get_ex(tcp_obj, "cwr", &tmp_obj))
-                {
-                    seq->tcp.cwr = json_object_get_boolean(tmp_obj);
-                }
-            }
+    if (self != NULL)
+    {
+        (self->same ? self->same : self)->appended = 1;
+    }
 
-            // ICMP object.
-            json_object *icmp_obj;
+    // Only sequences are taken from included files.
+    if (only_seq)
+    {
+        json_object *seqs;
 
-            if (json_object_object_get_ex(seq_obj, "icmp", &icmp_obj))
-            {
-                // Code.
-                if (json_object_object_get_ex(icmp_obj, "code", &tmp_obj))
-                {
-                    seq->icmp.code = json_object_get_int(tmp_obj);
-                }
+        if (json_object_object_get_ex(root, "sequences", &seqs))
+        {
+            ret = parse_sequences(&ctx, cfg, seqs);
+        }
+    }
+    else
+    {
+        ret = cfg_walk(&ctx, &root_schema, cfg, root);
+    }
 
-                // Type.
-                if (json_object_object_get_ex(icmp_obj, "type", &tmp_obj))
-                {
-                    seq->icmp.type = json_object_get_int(tmp_obj);
-                }
-            }
+    cfg_loader_free(&loader);
 
-            // Payloads object.
-            json_object *pls_obj;
+    // Payloads are read-only from here on.
+    pl_store_seal(&cfg->pl_store);
 
-            if (json_object_object_get_ex(seq_obj, "payloads", &pls_obj))
-            {
-                int pls_len = json_object_array_length(pls_obj);
+    if (ret != 0)
+    {
+        fprintf(stderr, "Failed to allocate memory while parsing '%s'.\n", file_name);
 
-                if (pls_len > 0)
-                {
-                    for (int j = 0; j < pls_len; j++)
-                    {
-                        json_object *pl_obj = json_object_array_get_idx(pls_obj, j);
-
-                        payload_opt_t *pl = &seq->pls[j];
-
-                        // Is static.
-                        if (json_object_object_get_ex(pl_obj, "isstatic", &tmp_obj))
-                        {
-                            pl->is_static = json_object_get_boolean(tmp_obj);
-                        }
-
-                        // Is file.
-                        if (json_object_object_get_ex(pl_obj, "isfile", &tmp_obj))
-                        {
-                            pl->is_file = json_object_get_boolean(tmp_obj);
-                        }
-
-                        // Is string.
-                        if (json_object_object_get_ex(pl_obj, "isstring", &tmp_obj))
-                        {
-                            pl->is_string = json_object_get_boolean(tmp_obj);
-                        }
-
-                        // Exact.
-                        if (json_object_object_get_ex(pl_obj, "exact", &tmp_obj))
-                        {
-                            pl->exact = (char *) json_object_get_string(tmp_obj);
-                        }
-
-                        // Length object.
-                        json_object *len_obj;
-
-                        if (json_object_object_get_ex(pl_obj, "length", &len_obj))
-                        {
-                            // Minimum length.
-                            if (json_object_object_get_ex(len_obj, "min", &tmp_obj))
-                            {
-                                pl->min_len = json_object_get_int(tmp_obj);
-                            }
-
-                            // Maximum length.
-                            if (json_object_object_get_ex(len_obj, "max", &tmp_obj))
-                            {
-                                pl->max_len = json_object_get_int(tmp_obj);
-                            }
-                        }
-
-                        seq->pl_cnt++;
-                    }
-                }
-            }
+        return 1;
+    }
 
-            *seq_num += 1;
-        }
+    if (!ctx.has_seqs)
+    {
+        fprintf(stderr, "Failed to open sequences array.\n");
+
+        return 1;
     }
 
     return 0;
@@ -432,6 +1634,11 @@ int parse_config(const char file_name[], config_t *cfg, int only_seq, int *seq_n
 **/
 void clear_sequence(config_t *cfg, int seq_num)
 {
+    if (seq_num < 0 || seq_num >= cfg->seq_cap)
+    {
+        return;
+    }
+
     sequence_t *seq = &cfg->seq[seq_num];
 
     seq->interface = NULL;
@@ -442,6 +1649,8 @@ void clear_sequence(config_t *cfg, int seq_num)
     seq->pps = 0;
     seq->bps = 0;
     seq->threads = 0;
+    seq->cpus = NULL;
+    seq->numa = TOPO_NUMA_AUTO;
     seq->time = 0;
     seq->delay = 1000000;
 
@@ -457,6 +1666,10 @@ void clear_sequence(config_t *cfg, int seq_num)
     seq->ip.min_id = 0;
     seq->ip.max_id = 64000;
     seq->ip.csum = 1;
+    seq->ip.is_ipv6 = 0;
+    seq->ip.range_tbl.entries = NULL;
+    seq->ip.range_tbl.count = 0;
+    seq->ip.range_tbl.mapped = 0;
     
     seq->udp.src_port = 0;
     seq->udp.dst_port = 0;
@@ -474,34 +1687,23 @@ void clear_sequence(config_t *cfg, int seq_num)
     seq->icmp.type = 0;
 
     seq->l4_csum = 1;
+    seq->csum_offload = 0;
+    seq->gso_size = 0;
 
-    // Reset includes.
-    for (int i = 0; i < MAX_INCLUDES; i++)
-    {
-        seq->includes[i] = NULL;
-    }
-
-    // Reset IP ranges.
-    for (int i = 0; i < MAX_RANGES; i++)
-    {
-        seq->ip.ranges[i] = NULL;
-    }
+    // Arrays are allocated at parse time.
+    seq->includes = NULL;
+    seq->include_count = 0;
 
-    // Reset payloads.
-    for (int i = 0; i < MAX_PAYLOADS; i++) {
-        payload_opt_t *pl = &seq->pls[i];
+    seq->ip.ranges = NULL;
+    seq->ip.range_weights = NULL;
+    seq->ip.range_count = 0;
 
-        pl->exact = NULL;
-        pl->is_file = 0;
-        pl->is_static = 0;
-        pl->is_static = 0;
-        pl->min_len = 0;
-        pl->max_len = 0;
-    }
+    seq->pls = NULL;
+    seq->pl_cnt = 0;
 }
 
 /**
- * Clears a sequence.
+ * Prints the config and every parsed sequence.
  * 
  * @param cfg A pointer to the config structure.
  * @param seq_cnt How many sequences we have.
@@ -512,120 +1714,17 @@ void print_config(config_t *cfg, int seq_cnt)
 {
     fprintf(stdout, "Found %d sequences.\n", seq_cnt);
 
-    fprintf(stdout, "Got interface => %s.\n", cfg->interface ? cfg->interface : "N/A");
+    cfg_print_fields(&root_schema, cfg, 0);
 
     fprintf(stdout, "Sequences:\n\n--------------------------\n");
 
-    for (int i = 0; i < seq_cnt; i++)
+    for (int i = 0; i < seq_cnt && i < cfg->seq_cap; i++)
     {
-        sequence_t *seq = &cfg->seq[i];
-
-        if (!seq)
-            continue;
-
         fprintf(stdout, "Sequence #%d:\n", i);
-
-        // General settings.
         fprintf(stdout, "\tGeneral\n");
-        fprintf(stdout, "\t\tIncludes =>\n");
-
-        if (seq->include_count > 0)
-        {
-            for (int j = 0; j < seq->include_count; j++)
-            {
-                fprintf(stdout, "\t\t\t- %s\n", seq->includes[j]);
-            }
-        }
-
-
-        fprintf(stdout, "\t\tInterface Override => %s\n", seq->interface ? seq->interface : "N/A");
-        fprintf(stdout, "\t\tBlock => %s\n", seq->block ? "Yes" : "No");
-        fprintf(stdout, "\t\tTrack => %s\n", seq->track ? "Yes": "No");
-        fprintf(stdout, "\t\tMax Packets => %llu\n", seq->max_pckts);
-        fprintf(stdout, "\t\tMax Bytes => %llu.\n", seq->max_bytes);
-        fprintf(stdout, "\t\tPackets Per Second => %llu.\n", seq->pps);
-        fprintf(stdout, "\t\tBytes Per Second => %llu\n", seq->bps);
-        fprintf(stdout, "\t\tTime => %llu\n", seq->time);
-        fprintf(stdout, "\t\tDelay => %llu\n", seq->delay);
-        fprintf(stdout, "\t\tThreads => %u\n", seq->threads);
-
-        // Ethernet settings.
-        fprintf(stdout, "\t\tEthernet\n");
-        fprintf(stdout, "\t\t\tSource MAC => %s\n", seq->eth.src_mac ? seq->eth.src_mac : "N/A");
-        fprintf(stdout, "\t\t\tDestination MAC => %s\n", seq->eth.dst_mac ? seq->eth.dst_mac : "N/A");
-
-        // IP settings.
-        fprintf(stdout, "\t\tIP\n");
-        fprintf(stdout, "\t\t\tProtocol => %s\n", seq->ip.protocol ? seq->ip.protocol : "N/A");
-
-        fprintf(stdout, "\t\t\tSource IP => %s\n", seq->ip.src_ip ? seq->ip.src_ip : "N/A");
-        fprintf(stdout, "\t\t\tDestination IP => %s\n", seq->ip.dst_ip ? seq->ip.dst_ip : "N/A");
-
-        fprintf(stdout, "\t\t\tType of Service => %d\n", seq->ip.tos);
-        fprintf(stdout, "\t\t\tMin TTL => %d\n", seq->ip.min_ttl);
-        fprintf(stdout, "\t\t\tMax TTL => %d\n", seq->ip.max_ttl);
-        fprintf(stdout, "\t\t\tMin ID => %d\n", seq->ip.min_id);
-        fprintf(stdout, "\t\t\tMax ID => %d\n", seq->ip.max_id);
-        fprintf(stdout, "\t\t\tChecksum => %s\n", seq->ip.csum ? "Yes" : "No");
-
-        if (seq->ip.range_count > 0)
-        {
-            fprintf(stdout, "\t\t\tRanges:\n");
-
-            for (int j = 0; j < seq->ip.range_count; j++)
-            {
-                fprintf(stdout, "\t\t\t\t- %s\n", seq->ip.ranges[j]);
-            }
-        }
-
-        // TCP settings.
-        fprintf(stdout, "\t\tTCP\n");
-        fprintf(stdout, "\t\t\tSource Port => %d\n", seq->tcp.src_port);
-        fprintf(stdout, "\t\t\tDest Port => %d\n", seq->tcp.dst_port);
-        fprintf(stdout, "\t\t\tUse Socket => %s\n", seq->tcp.cooked ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tOne Connection => %s\n", seq->tcp.one_connection ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tSYN Flag => %s\n", seq->tcp.syn ? "Yes": "No");
-        fprintf(stdout, "\t\t\tPSH Flag => %s\n", seq->tcp.psh ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tFIN Flag => %s\n", seq->tcp.fin ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tACK Flag => %s\n", seq->tcp.ack ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tRST Flag => %s\n", seq->tcp.rst ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tURG Flag => %s\n", seq->tcp.urg ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tECE Flag => %s\n", seq->tcp.ece ? "Yes" : "No");
-        fprintf(stdout, "\t\t\tCWR Flag => %s\n", seq->tcp.cwr ? "Yes" : "No");
-
-        // UDP settings.
-        fprintf(stdout, "\t\tUDP\n");
-        fprintf(stdout, "\t\t\tSrc Port => %d\n", seq->udp.src_port);
-        fprintf(stdout, "\t\t\tDst Port => %d\n", seq->udp.dst_port);
-
-        // ICMP settings.
-        fprintf(stdout, "\t\tICMP\n");
-        fprintf(stdout, "\t\t\tCode => %d\n", seq->icmp.code);
-        fprintf(stdout, "\t\t\tType => %d\n", seq->icmp.type);
-
-        // Layer 4 setting(s).
-        fprintf(stdout, "\t\tLayer 4\n");
-        fprintf(stdout, "\t\t\tChecksum => %s\n", seq->l4_csum ? "Yes" : "No");
-
-        if (seq->pl_cnt > 0)
-        {
-            fprintf(stdout, "\t\tPayloads (%d)\n", seq->pl_cnt);
-
-            for (int j = 0; j < seq->pl_cnt; j++)
-            {
-                payload_opt_t *pl = &seq->pls[j];
 
-                fprintf(stdout, "\t\t\t#%d\n", j + 1);
-
-                fprintf(stdout, "\t\t\t\tMin Length => %d\n", pl->min_len);
-                fprintf(stdout, "\t\t\t\tMax Length => %d\n", pl->max_len);
-                fprintf(stdout, "\t\t\t\tIs Static => %s\n", pl->is_static ? "Yes" : "No");
-                fprintf(stdout, "\t\t\t\tIs File => %s\n", pl->is_file ? "Yes" : "No");
-                fprintf(stdout, "\t\t\t\tIs String => %s\n", pl->is_string ? "Yes" : "No");
-                fprintf(stdout, "\t\t\t\tExact String => %s\n", pl->exact ? pl->exact : "N/A");
-            }
-        }
+        cfg_print_fields(&seq_schema, &cfg->seq[i], 2);
 
         fprintf(stdout, "\n\n");
     }
-}
\ No newline at end of file
+}
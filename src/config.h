@@ -4,12 +4,10 @@
 #include <linux/if_ether.h>
 
 #include "simple_types.h"
-
-#define MAX_INCLUDES 64
-#define MAX_SEQUENCES 256
-#define MAX_RANGES 64
-
-#define MAX_PAYLOADS 256
+#include "ranges.h"
+#include "arena.h"
+#include "pl_store.h"
+#include "pl_pool.h"
 
 typedef struct eth_opt
 {
@@ -25,9 +23,16 @@ typedef struct ip_opt
     // Source and destination addresses (Required).
     char *src_ip;
     char *dst_ip;
-    char *ranges[MAX_RANGES];
+    char **ranges;
+    u32 *range_weights;
     u16 range_count;
 
+    // Whether the addresses and ranges above are IPv6.
+    u8 is_ipv6;
+
+    // Source ranges (or source IP) compiled at config load (IPv4 only).
+    range_table_t range_tbl;
+
     // Type of Service.
     u8 tos;
 
@@ -40,7 +45,7 @@ typedef struct ip_opt
     u16 max_id;
 
     // Do checksum.
-    unsigned int csum : 1;
+    u8 csum;
 } ip_opt_t;
 
 typedef struct tcp_opt
@@ -49,17 +54,17 @@ typedef struct tcp_opt
     u16 dst_port;
 
     // TCP flags.
-    unsigned int syn : 1;
-    unsigned int psh : 1;
-    unsigned int fin : 1;
-    unsigned int ack : 1;
-    unsigned int rst : 1;
-    unsigned int urg : 1;
-    unsigned int ece : 1;
-    unsigned int cwr : 1;
-
-    unsigned int cooked : 1;
-    unsigned int one_connection : 1;
+    u8 syn;
+    u8 psh;
+    u8 fin;
+    u8 ack;
+    u8 rst;
+    u8 urg;
+    u8 ece;
+    u8 cwr;
+
+    u8 cooked;
+    u8 one_connection;
 } tcp_opt_t;
 
 typedef struct udp_opt
@@ -78,10 +83,22 @@ typedef struct payload_opt
 {
     u16 min_len;
     u16 max_len;
-    unsigned int is_static : 1;
-    unsigned int is_file : 1;
-    unsigned int is_string : 1;
+    u8 is_static;
+    u8 is_file;
+    u8 is_string;
+
+    // Decode escape sequences in string payloads.
+    u8 is_escaped;
+
+    // Amount of random payloads to pregenerate for non-static payloads (0 = generate per packet).
+    u32 pool;
+
     char *exact;
+
+    // Decoded static payload and its 32-bit partial checksum (filled in at config load, owned by the config's payload store).
+    const u8 *data;
+    u32 data_len;
+    u32 data_csum;
 } payload_opt_t;
 
 typedef struct sequence
@@ -89,8 +106,8 @@ typedef struct sequence
     // General options.
     char *interface;
 
-    unsigned int block : 1;
-    unsigned int track : 1;
+    u8 block;
+    u8 track;
 
     u64 max_pckts;
     u64 max_bytes;
@@ -101,7 +118,12 @@ typedef struct sequence
     u64 time;
     u64 delay;
     u16 threads;
-    char *includes[MAX_INCLUDES];
+
+    // Thread placement: explicit CPU list (e.g. "0-3,8") and NUMA policy (TOPO_NUMA_* or a node).
+    char *cpus;
+    s16 numa;
+
+    char **includes;
     u16 include_count;
 
     // Ethernet options.
@@ -114,11 +136,15 @@ typedef struct sequence
     tcp_opt_t tcp;
     udp_opt_t udp;
     icmp_opt_t icmp;
-    unsigned int l4_csum : 1;
+    u8 l4_csum;
+
+    // Offload the layer-4 checksum (and optionally segmentation) with a virtio-net header instead of computing it in software.
+    u8 csum_offload;
+    u16 gso_size;
 
     // Payload options.
     int pl_cnt;
-    payload_opt_t pls[MAX_PAYLOADS];
+    payload_opt_t *pls;
 } sequence_t;
 
 typedef struct config
@@ -126,9 +152,27 @@ typedef struct config
     // Device options.
     char *interface;
 
-    sequence_t seq[MAX_SEQUENCES];
+    // Sequences (sized for every file a parse loaded) and the amount allocated.
+    sequence_t *seq;
+    int seq_cap;
+
+    // Storage for the sequences and their arrays (released with free_config()).
+    arena_t arena;
+
+    // Decoded static payloads shared by every sequence and thread.
+    pl_store_t pl_store;
+
+    // Pregenerated random payload pools created by compile_plan() (released with free_config()).
+    pl_pool_t *pools;
+
+    // Mapped binary config cache holding the sequences instead (NULL when parsed from JSON).
+    void *map;
+    size_t map_len;
 } config_t;
 
+void init_config(struct config *cfg);
+int reserve_sequences(struct config *cfg, int count);
+void free_config(struct config *cfg);
 int parse_config(const char file_name[], struct config *cfg, int only_seq, int *seq_num, u8 log);
 void clear_sequence(struct config *cfg, int seq_num);
 void print_config(struct config *cfg, int seq_cnt);
\ No newline at end of file
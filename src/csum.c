@@ -0,0 +1,54 @@
+#include "csum.h"
+
+/*
+ * Kernel dispatch for csum.h.
+ *
+ * The kernels themselves are inlined from the header, but the pointers that
+ * pick one live here so every file that includes csum.h shares them and
+ * csum_set_kernel() applies to the whole program.
+ */
+
+static unsigned do_csum_resolve(const unsigned char *buff, unsigned len);
+static unsigned do_csum_copy_resolve(unsigned char *dst, const unsigned char *src,
+				     unsigned len);
+
+/*
+ * Both pointers start out at a resolver so callers that run before the
+ * constructor below (e.g. from another constructor) still pick a kernel.
+ */
+csum_kernel_fn do_csum_kernel = do_csum_resolve;
+csum_copy_kernel_fn do_csum_copy_kernel = do_csum_copy_resolve;
+
+static unsigned do_csum_resolve(const unsigned char *buff, unsigned len)
+{
+	do_csum_kernel = csum_kernel_get(CSUM_KERNEL_AUTO);
+
+	return do_csum_kernel(buff, len);
+}
+
+static unsigned do_csum_copy_resolve(unsigned char *dst, const unsigned char *src,
+				     unsigned len)
+{
+	do_csum_copy_kernel = csum_copy_kernel_get();
+
+	return do_csum_copy_kernel(dst, src, len);
+}
+
+__attribute__((constructor))
+static void csum_kernel_init(void)
+{
+	do_csum_kernel = csum_kernel_get(CSUM_KERNEL_AUTO);
+	do_csum_copy_kernel = csum_copy_kernel_get();
+}
+
+int csum_set_kernel(enum csum_kernel kernel)
+{
+	csum_kernel_fn fn = csum_kernel_get(kernel);
+
+	if (fn == NULL)
+		return -1;
+
+	do_csum_kernel = fn;
+
+	return 0;
+}
@@ -10,12 +10,37 @@
 
 #ifndef __BPF__
 
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
 #include "simple_types.h"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #ifndef unlikely
 #define unlikely(x) __builtin_expect(!!(x), 0)
 #endif
 
+/*
+ * The x86-64 inline assembly below is used unless we're building for another
+ * architecture or CSUM_NO_ASM is defined. Portable C versions are used otherwise.
+ */
+#if defined(__x86_64__) && !defined(CSUM_NO_ASM)
+#define CSUM_X86_ASM
+#endif
+
+/*
+ * Packet headers are written through their own structures and read back here
+ * as plain words, so the C paths load through types that may alias anything.
+ */
+typedef u16 __attribute__((__may_alias__)) csum_u16_t;
+typedef u32 __attribute__((__may_alias__)) csum_u32_t;
+
+struct in6_addr;
+
 struct pseudo_hdr 
 {
    unsigned long saddr; // 4 bytes
@@ -32,6 +57,7 @@ struct pseudo_hdr
  * with some code from asm-x86/checksum.h
  */
 
+#ifdef CSUM_X86_ASM
 static inline unsigned add32_with_carry(unsigned a, unsigned b)
 {
 	asm("addl %2,%0\n\t"
@@ -50,7 +76,35 @@ static inline unsigned short from32to16(unsigned a)
 	    : "0" (b), "r" (a));
 	return b;
 }
+#else
+static inline unsigned add32_with_carry(unsigned a, unsigned b)
+{
+	a += b;
+
+	return a + (a < b);
+}
+
+static inline unsigned short from32to16(unsigned a)
+{
+	unsigned b = (a & 0xffff) + (a >> 16);
+
+	return (unsigned short)((b & 0xffff) + (b >> 16));
+}
+#endif
+
+/*
+ * Folds a 64-bit sum into 32 bits with end-around carry. The result is the
+ * same value add32_with_carry() produces from the same high and low halves.
+ */
+static inline unsigned csum_fold64(u64 sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+
+	return (unsigned)sum;
+}
 
+#ifdef CSUM_X86_ASM
 /*
  * Do a 64-bit checksum on an arbitrary memory area.
  * Returns a 32bit checksum.
@@ -63,7 +117,7 @@ static inline unsigned short from32to16(unsigned a)
  * Unrolling to an 128 bytes inner loop.
  * Using interleaving with more registers to break the carry chains.
  */
-static unsigned do_csum(const unsigned char *buff, unsigned len)
+static inline unsigned do_csum_x86(const unsigned char *buff, unsigned len)
 {
 	unsigned odd, count;
 	unsigned long result = 0;
@@ -149,6 +203,255 @@ static unsigned do_csum(const unsigned char *buff, unsigned len)
 	}
 	return result;
 }
+#endif
+
+/*
+ * The kernels below split the buffer exactly like do_csum_x86() does (odd
+ * byte, 16-bit and 32-bit alignment heads, 8-byte aligned bulk, tails) and
+ * only differ in how the bulk is summed. The bulk is summed as the exact
+ * integer sum of its 32-bit words, which is congruent to the 64-bit carry
+ * chain modulo 2^32 - 1 and is zero only when the data is. After folding, every
+ * kernel therefore returns a bit-identical 32-bit value for every length and
+ * alignment.
+ */
+typedef u64 (*csum_bulk_fn)(const unsigned char *buff, unsigned count);
+
+/*
+ * Sums the 32-bit words of `count` 8-byte words starting at `buff`.
+ */
+static inline u64 csum_bulk_generic(const unsigned char *buff, unsigned count)
+{
+	u64 sum = 0;
+
+	while (count--) {
+		u64 w;
+
+		memcpy(&w, buff, sizeof(w));
+		sum += (w & 0xffffffff) + (w >> 32);
+		buff += 8;
+	}
+
+	return sum;
+}
+
+static __always_inline unsigned do_csum_common(const unsigned char *buff, unsigned len,
+					       csum_bulk_fn bulk)
+{
+	unsigned odd, count;
+	u64 result = 0;
+
+	if (unlikely(len == 0))
+		return result;
+	odd = 1 & (unsigned long) buff;
+	if (unlikely(odd)) {
+		result = *buff << 8;
+		len--;
+		buff++;
+	}
+	count = len >> 1;		/* nr of 16-bit words.. */
+	if (count) {
+		if (2 & (unsigned long) buff) {
+			result += *(const csum_u16_t *)buff;
+			count--;
+			len -= 2;
+			buff += 2;
+		}
+		count >>= 1;		/* nr of 32-bit words.. */
+		if (count) {
+			if (4 & (unsigned long) buff) {
+				result += *(const csum_u32_t *) buff;
+				count--;
+				len -= 4;
+				buff += 4;
+			}
+			count >>= 1;	/* nr of 64-bit words.. */
+
+			result += bulk(buff, count);
+			buff += (unsigned long)count * 8;
+			result = csum_fold64(result);
+
+			if (len & 4) {
+				result += *(const csum_u32_t *) buff;
+				buff += 4;
+			}
+		}
+		if (len & 2) {
+			result += *(const csum_u16_t *) buff;
+			buff += 2;
+		}
+	}
+	if (len & 1)
+		result += *buff;
+	result = csum_fold64(result);
+	if (unlikely(odd)) {
+		result = from32to16(result);
+		result = ((result >> 8) & 0xff) | ((result & 0xff) << 8);
+	}
+	return result;
+}
+
+/*
+ * Portable C checksum for builds without the x86-64 inline assembly.
+ */
+static inline unsigned do_csum_generic(const unsigned char *buff, unsigned len)
+{
+	return do_csum_common(buff, len, csum_bulk_generic);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static inline u64 csum_bulk_avx2(const unsigned char *buff, unsigned count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i acc0 = zero, acc1 = zero;
+	unsigned count64 = count >> 3;
+
+	/* Zero-extend each 32-bit word to 64 bits so nothing carries out. */
+	while (count64) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)buff);
+		__m256i b = _mm256_loadu_si256((const __m256i *)(buff + 32));
+
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(a, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(a, zero));
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(b, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(b, zero));
+		buff += 64;
+		count64--;
+	}
+
+	acc0 = _mm256_add_epi64(acc0, acc1);
+
+	__m128i s = _mm_add_epi64(_mm256_castsi256_si128(acc0),
+				  _mm256_extracti128_si256(acc0, 1));
+
+	return (u64)_mm_cvtsi128_si64(s) + (u64)_mm_extract_epi64(s, 1) +
+	       csum_bulk_generic(buff, count & 7);
+}
+
+/*
+ * AVX2 checksum, selected at startup on CPUs that support it.
+ */
+__attribute__((target("avx2")))
+static inline unsigned do_csum_avx2(const unsigned char *buff, unsigned len)
+{
+	return do_csum_common(buff, len, csum_bulk_avx2);
+}
+
+__attribute__((target("avx512f")))
+static inline u64 csum_bulk_avx512(const unsigned char *buff, unsigned count)
+{
+	const __m512i zero = _mm512_setzero_si512();
+	__m512i acc0 = zero, acc1 = zero;
+	unsigned count128 = count >> 4;
+
+	while (count128) {
+		__m512i a = _mm512_loadu_si512((const void *)buff);
+		__m512i b = _mm512_loadu_si512((const void *)(buff + 64));
+
+		acc0 = _mm512_add_epi64(acc0, _mm512_unpacklo_epi32(a, zero));
+		acc1 = _mm512_add_epi64(acc1, _mm512_unpackhi_epi32(a, zero));
+		acc0 = _mm512_add_epi64(acc0, _mm512_unpacklo_epi32(b, zero));
+		acc1 = _mm512_add_epi64(acc1, _mm512_unpackhi_epi32(b, zero));
+		buff += 128;
+		count128--;
+	}
+
+	if (count & 8) {
+		__m512i a = _mm512_loadu_si512((const void *)buff);
+
+		acc0 = _mm512_add_epi64(acc0, _mm512_unpacklo_epi32(a, zero));
+		acc1 = _mm512_add_epi64(acc1, _mm512_unpackhi_epi32(a, zero));
+		buff += 64;
+	}
+
+	return (u64)_mm512_reduce_add_epi64(_mm512_add_epi64(acc0, acc1)) +
+	       csum_bulk_generic(buff, count & 7);
+}
+
+/*
+ * AVX-512 checksum, selected at startup on CPUs that support it.
+ */
+__attribute__((target("avx512f")))
+static inline unsigned do_csum_avx512(const unsigned char *buff, unsigned len)
+{
+	return do_csum_common(buff, len, csum_bulk_avx512);
+}
+#endif
+
+enum csum_kernel
+{
+	CSUM_KERNEL_AUTO = 0,
+	CSUM_KERNEL_GENERIC,
+	CSUM_KERNEL_X86,
+	CSUM_KERNEL_AVX2,
+	CSUM_KERNEL_AVX512,
+	CSUM_KERNEL_MAX
+};
+
+typedef unsigned (*csum_kernel_fn)(const unsigned char *buff, unsigned len);
+
+/**
+ * csum_kernel_get - Retrieve a checksum kernel.
+ * @kernel: the kernel to retrieve (CSUM_KERNEL_AUTO picks the fastest one)
+ *
+ * Returns NULL if the kernel isn't built in or the CPU doesn't support it.
+ */
+static inline csum_kernel_fn csum_kernel_get(enum csum_kernel kernel)
+{
+	switch (kernel) {
+	case CSUM_KERNEL_AUTO:
+#if defined(__x86_64__)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+			return do_csum_avx512;
+		if (__builtin_cpu_supports("avx2"))
+			return do_csum_avx2;
+#endif
+#ifdef CSUM_X86_ASM
+		return do_csum_x86;
+#else
+		return do_csum_generic;
+#endif
+	case CSUM_KERNEL_GENERIC:
+		return do_csum_generic;
+#ifdef CSUM_X86_ASM
+	case CSUM_KERNEL_X86:
+		return do_csum_x86;
+#endif
+#if defined(__x86_64__)
+	case CSUM_KERNEL_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? do_csum_avx2 : NULL;
+	case CSUM_KERNEL_AVX512:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f") ? do_csum_avx512 : NULL;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+/* The kernel do_csum() uses, resolved once at startup (see csum.c). */
+extern csum_kernel_fn do_csum_kernel;
+
+/**
+ * csum_set_kernel - Override the kernel do_csum() uses.
+ * @kernel: the kernel to use
+ *
+ * The kernel is shared by every translation unit including this header.
+ *
+ * Returns 0 on success or -1 if the kernel isn't available.
+ */
+int csum_set_kernel(enum csum_kernel kernel);
+
+/*
+ * Do a checksum on an arbitrary memory area using the fastest kernel
+ * the CPU supports. Returns a 32bit checksum.
+ */
+static inline unsigned do_csum(const unsigned char *buff, unsigned len)
+{
+	return do_csum_kernel(buff, len);
+}
 
 /*
  * computes the checksum of a memory block at buff, length len,
@@ -168,6 +471,260 @@ static inline __wsum csum_partial(const void *buff, int len, __wsum sum)
 						(u32)sum);
 }
 
+/*
+ * Fused copy and checksum.
+ *
+ * These copy a buffer and checksum it in a single pass so payload bytes are
+ * only read once while materializing a packet. The buffer is split according
+ * to the alignment of the destination exactly like do_csum() splits it, so
+ * the result is bit-identical to csum_partial() over the destination.
+ */
+typedef u64 (*csum_copy_bulk_fn)(unsigned char *dst, const unsigned char *src, unsigned count);
+
+static inline u64 csum_copy_bulk_generic(unsigned char *dst, const unsigned char *src,
+					 unsigned count)
+{
+	u64 sum = 0;
+
+	while (count--) {
+		u64 w;
+
+		memcpy(&w, src, sizeof(w));
+		memcpy(dst, &w, sizeof(w));
+		sum += (w & 0xffffffff) + (w >> 32);
+		src += 8;
+		dst += 8;
+	}
+
+	return sum;
+}
+
+static __always_inline unsigned do_csum_copy_common(unsigned char *dst, const unsigned char *src,
+						    unsigned len, csum_copy_bulk_fn bulk)
+{
+	unsigned odd, count;
+	u64 result = 0;
+	u16 w16;
+	u32 w32;
+
+	if (unlikely(len == 0))
+		return result;
+	odd = 1 & (unsigned long) dst;
+	if (unlikely(odd)) {
+		*dst = *src;
+		result = *src << 8;
+		len--;
+		src++;
+		dst++;
+	}
+	count = len >> 1;		/* nr of 16-bit words.. */
+	if (count) {
+		if (2 & (unsigned long) dst) {
+			memcpy(&w16, src, 2);
+			memcpy(dst, &w16, 2);
+			result += w16;
+			count--;
+			len -= 2;
+			src += 2;
+			dst += 2;
+		}
+		count >>= 1;		/* nr of 32-bit words.. */
+		if (count) {
+			if (4 & (unsigned long) dst) {
+				memcpy(&w32, src, 4);
+				memcpy(dst, &w32, 4);
+				result += w32;
+				count--;
+				len -= 4;
+				src += 4;
+				dst += 4;
+			}
+			count >>= 1;	/* nr of 64-bit words.. */
+
+			result += bulk(dst, src, count);
+			src += (unsigned long)count * 8;
+			dst += (unsigned long)count * 8;
+			result = csum_fold64(result);
+
+			if (len & 4) {
+				memcpy(&w32, src, 4);
+				memcpy(dst, &w32, 4);
+				result += w32;
+				src += 4;
+				dst += 4;
+			}
+		}
+		if (len & 2) {
+			memcpy(&w16, src, 2);
+			memcpy(dst, &w16, 2);
+			result += w16;
+			src += 2;
+			dst += 2;
+		}
+	}
+	if (len & 1) {
+		*dst = *src;
+		result += *src;
+	}
+	result = csum_fold64(result);
+	if (unlikely(odd)) {
+		result = from32to16(result);
+		result = ((result >> 8) & 0xff) | ((result & 0xff) << 8);
+	}
+	return result;
+}
+
+static inline unsigned do_csum_copy_generic(unsigned char *dst, const unsigned char *src,
+					    unsigned len)
+{
+	return do_csum_copy_common(dst, src, len, csum_copy_bulk_generic);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static inline u64 csum_copy_bulk_avx2(unsigned char *dst, const unsigned char *src,
+				      unsigned count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i acc0 = zero, acc1 = zero;
+	unsigned count32 = count >> 2;
+
+	while (count32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)src);
+
+		_mm256_storeu_si256((__m256i *)dst, a);
+		acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(a, zero));
+		acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(a, zero));
+		src += 32;
+		dst += 32;
+		count32--;
+	}
+
+	acc0 = _mm256_add_epi64(acc0, acc1);
+
+	__m128i s = _mm_add_epi64(_mm256_castsi256_si128(acc0),
+				  _mm256_extracti128_si256(acc0, 1));
+
+	return (u64)_mm_cvtsi128_si64(s) + (u64)_mm_extract_epi64(s, 1) +
+	       csum_copy_bulk_generic(dst, src, count & 3);
+}
+
+__attribute__((target("avx2")))
+static inline unsigned do_csum_copy_avx2(unsigned char *dst, const unsigned char *src,
+					 unsigned len)
+{
+	return do_csum_copy_common(dst, src, len, csum_copy_bulk_avx2);
+}
+
+/*
+ * Non-temporal bulk: stores bypass the cache so large payloads written into
+ * TX frames don't evict the working set. The destination is 8-byte aligned
+ * here, one scalar word brings it to the 16 bytes movntdq needs.
+ */
+static inline u64 csum_copy_bulk_nt(unsigned char *dst, const unsigned char *src,
+				    unsigned count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i acc = zero;
+	u64 sum = 0;
+	unsigned count16;
+
+	if (count && (8 & (unsigned long) dst)) {
+		u64 w;
+
+		memcpy(&w, src, sizeof(w));
+		_mm_stream_si64((long long *)dst, (long long)w);
+		sum += (w & 0xffffffff) + (w >> 32);
+		src += 8;
+		dst += 8;
+		count--;
+	}
+
+	count16 = count >> 1;
+
+	while (count16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)src);
+
+		_mm_stream_si128((__m128i *)dst, a);
+		acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(a, zero));
+		acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(a, zero));
+		src += 16;
+		dst += 16;
+		count16--;
+	}
+
+	if (count & 1) {
+		u64 w;
+
+		memcpy(&w, src, sizeof(w));
+		_mm_stream_si64((long long *)dst, (long long)w);
+		sum += (w & 0xffffffff) + (w >> 32);
+	}
+
+	return sum + (u64)_mm_cvtsi128_si64(acc) +
+	       (u64)_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc));
+}
+#endif
+
+typedef unsigned (*csum_copy_kernel_fn)(unsigned char *dst, const unsigned char *src,
+					unsigned len);
+
+/* The kernel csum_partial_copy() uses, resolved once at startup (see csum.c). */
+extern csum_copy_kernel_fn do_csum_copy_kernel;
+
+static inline csum_copy_kernel_fn csum_copy_kernel_get(void)
+{
+#if defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return do_csum_copy_avx2;
+#endif
+	return do_csum_copy_generic;
+}
+
+/**
+ * csum_partial_copy - Copy a memory block and checksum it in one pass.
+ * @dst: destination buffer
+ * @src: source buffer (must not overlap dst)
+ * @len: number of bytes to copy
+ * @sum: initial sum to be added in (32bit unfolded)
+ *
+ * Returns the same value csum_partial(dst, len, sum) returns after the copy.
+ */
+static inline __wsum csum_partial_copy(void *dst, const void *src, int len, __wsum sum)
+{
+	return (__wsum)add32_with_carry(do_csum_copy_kernel((unsigned char *)dst,
+							    (const unsigned char *)src, len),
+					(u32)sum);
+}
+
+/**
+ * csum_partial_copy_nt - Copy a memory block with non-temporal stores and checksum it.
+ * @dst: destination buffer
+ * @src: source buffer (must not overlap dst)
+ * @len: number of bytes to copy
+ * @sum: initial sum to be added in (32bit unfolded)
+ *
+ * Like csum_partial_copy(), but the bulk of the copy bypasses the cache. Meant
+ * for large payloads written into frames the CPU won't read again (e.g.
+ * AF_XDP UMEM or DPDK mbufs). Falls back to csum_partial_copy() on other
+ * architectures.
+ */
+static inline __wsum csum_partial_copy_nt(void *dst, const void *src, int len, __wsum sum)
+{
+#if defined(__x86_64__)
+	unsigned res = do_csum_copy_common((unsigned char *)dst, (const unsigned char *)src,
+					   len, csum_copy_bulk_nt);
+
+	/* Order the streaming stores before the frame is handed to the NIC. */
+	_mm_sfence();
+
+	return (__wsum)add32_with_carry(res, (u32)sum);
+#else
+	return csum_partial_copy(dst, src, len, sum);
+#endif
+}
+
 /**
  * csum_fold - Fold and invert a 32bit checksum.
  * sum: 32bit unfolded sum
@@ -178,12 +735,16 @@ static inline __wsum csum_partial(const void *buff, int len, __wsum sum)
  */
 static inline __sum16 csum_fold(__wsum sum)
 {
+#ifdef CSUM_X86_ASM
 	asm("  addl %1,%0\n"
 	    "  adcl $0xffff,%0"
 	    : "=r" (sum)
 	    : "r" ((u32)sum << 16),
 	      "0" ((u32)sum & 0xffff0000));
 	return (__sum16)(~(u32)sum >> 16);
+#else
+	return (__sum16)~from32to16((u32)sum);
+#endif
 }
 
 
@@ -203,6 +764,7 @@ static inline __sum16 csum_fold(__wsum sum)
  */
 static inline __sum16 ip_fast_csum(const void *iph, unsigned int ihl)
 {
+#ifdef CSUM_X86_ASM
 	unsigned int sum;
 
 	asm("  movl (%1), %0\n"
@@ -229,6 +791,15 @@ static inline __sum16 ip_fast_csum(const void *iph, unsigned int ihl)
 	    : "1" (iph), "2" (ihl)
 	    : "memory");
 	return (__sum16)sum;
+#else
+	const csum_u32_t *words = (const csum_u32_t *)iph;
+	u64 sum = 0;
+
+	for (unsigned int i = 0; i < ihl; i++)
+		sum += words[i];
+
+	return (__sum16)~from32to16(csum_fold64(sum));
+#endif
 }
 
 /**
@@ -246,6 +817,7 @@ static inline __wsum
 csum_tcpudp_nofold(__be32 saddr, __be32 daddr, u32 len,
 		   u8 proto, __wsum sum)
 {
+#ifdef CSUM_X86_ASM
 	asm("  addl %1, %0\n"
 	    "  adcl %2, %0\n"
 	    "  adcl %3, %0\n"
@@ -254,9 +826,68 @@ csum_tcpudp_nofold(__be32 saddr, __be32 daddr, u32 len,
 	    : "g" (daddr), "g" (saddr),
 	      "g" ((len + proto)<<8), "0" (sum));
 	return sum;
+#else
+	u64 s = (u64)(u32)sum + (u32)daddr + (u32)saddr;
+
+	/* Length and protocol are summed as a network order 16-bit word pair. */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	s += len + proto;
+#else
+	s += (len + proto) << 8;
+#endif
+	return (__wsum)csum_fold64(s);
+#endif
 }
 
 
+/**
+ * csum_ipv6_nofold - Compute an IPv6 pseudo header checksum.
+ * @saddr: source address (16 bytes, network order)
+ * @daddr: destination address (16 bytes, network order)
+ * @len: length of packet
+ * @proto: ip protocol of packet
+ * @sum: initial sum to be added in (32bit unfolded)
+ *
+ * Returns the pseudo header checksum of the input data. Result is
+ * 32bit unfolded.
+ */
+static inline __wsum csum_ipv6_nofold(const struct in6_addr *saddr,
+				      const struct in6_addr *daddr,
+				      u32 len, u8 proto, __wsum sum)
+{
+	u64 w[4];
+	u64 res = (u32)sum;
+
+	memcpy(&w[0], saddr, 16);
+	memcpy(&w[2], daddr, 16);
+
+	/* Sum the 32-bit halves exactly; folding afterwards keeps every carry. */
+	for (int i = 0; i < 4; i++)
+		res += (w[i] & 0xffffffff) + (w[i] >> 32);
+
+	res += (u64)htonl(len) + htonl(proto);
+
+	return (__wsum)csum_fold64(res);
+}
+
+/**
+ * csum_ipv6_magic - Compute an IPv6 pseudo header checksum.
+ * @saddr: source address (16 bytes, network order)
+ * @daddr: destination address (16 bytes, network order)
+ * @len: length of packet
+ * @proto: ip protocol of packet
+ * @sum: initial sum to be added in (32bit unfolded)
+ *
+ * Returns the 16bit pseudo header checksum the input data already
+ * complemented and ready to be filled in.
+ */
+static inline __sum16 csum_ipv6_magic(const struct in6_addr *saddr,
+				      const struct in6_addr *daddr,
+				      u32 len, u8 proto, __wsum sum)
+{
+	return csum_fold(csum_ipv6_nofold(saddr, daddr, len, proto, sum));
+}
+
 /**
  * csum_tcpup_magic - Compute an IPv4 pseudo header checksum.
  * @saddr: source address
@@ -317,71 +948,452 @@ static __always_inline u16 csum_diff4(u32 from, u32 to, u16 csum) {
     return csum_fold_helper(csum_add(to, tmp));
 }
 
-u16 tcp_checksum(const void *buff, size_t len, u32 *src_addr, u32 *dest_addr)
+#ifndef __BPF__
+/*
+ * Batch checksums.
+ *
+ * These compute the checksums of a burst of IPv4 packets at once. Packets are
+ * processed CSUM_BATCH_LANES at a time with each packet in its own SIMD lane
+ * so the per-packet fold, pseudo header and invert steps are shared.
+ */
+#define CSUM_BATCH_LANES 4
+
+#define CSUM_TCP_CHECK_OFF 16
+#define CSUM_UDP_CHECK_OFF 6
+#define CSUM_ICMP_CHECK_OFF 2
+
+/*
+ * Folds each 32-bit lane of sums[] (already reduced below 2^20) to 16 bits and
+ * inverts it. Zero results are replaced with 0xffff when zero_is_ffff is set.
+ */
+static __always_inline void csum_batch_fold_lanes(u32 *sums, int zero_is_ffff)
 {
-    const u16 *buf=buff;
-    u32 sum;
-    size_t length=len;
+#ifdef __SSE2__
+	const __m128i mask = _mm_set1_epi32(0xffff);
+	__m128i s = _mm_loadu_si128((const __m128i *)sums);
 
-    // Calculate the sum                                            //
-    sum = 0;
-    while (len > 1)
-    {
-        sum += *buf++;
-        if (sum & 0x80000000)
-            sum = (sum & 0xFFFF) + (sum >> 16);
-        len -= 2;
-    }
+	s = _mm_add_epi32(_mm_and_si128(s, mask), _mm_srli_epi32(s, 16));
+	s = _mm_add_epi32(_mm_and_si128(s, mask), _mm_srli_epi32(s, 16));
+	s = _mm_andnot_si128(s, mask);
 
-    if ( len & 1 )
-    // Add the padding if the packet lenght is odd          //
-    sum += *((u8 *)buf);
+	if (zero_is_ffff)
+		s = _mm_or_si128(s, _mm_and_si128(_mm_cmpeq_epi32(s, _mm_setzero_si128()), mask));
 
-    // Add the pseudo-header                                        //
-    sum += *(src_addr++);
-    sum += *src_addr;
-    sum += *(dest_addr++);
-    sum += *dest_addr;
-    sum += htons(IPPROTO_TCP);
-    sum += htons(length);
+	_mm_storeu_si128((__m128i *)sums, s);
+#else
+	for (int i = 0; i < CSUM_BATCH_LANES; i++) {
+		u32 v = sums[i];
+
+		v = (v & 0xffff) + (v >> 16);
+		v = (v & 0xffff) + (v >> 16);
+		v = ~v & 0xffff;
 
-    // Add the carries                                              //
-    while (sum >> 16)
-        sum = (sum & 0xFFFF) + (sum >> 16);
+		if (zero_is_ffff && v == 0)
+			v = 0xffff;
 
-    // Return the one's complement of sum                           //
-    return ( (u16)(~sum)  );
+		sums[i] = v;
+	}
+#endif
 }
 
-u16 icmp_csum (u16 *addr, int len)
+/**
+ * csum_batch_ipv4_hdr - Compute and store the IPv4 header checksum of several packets.
+ * @hdrs: array of pointers to IPv4 headers
+ * @n: number of headers
+ *
+ * Headers without options (ihl == 5) are summed CSUM_BATCH_LANES at a time in
+ * SIMD lanes. Other headers fall back to update_iph_checksum().
+ */
+static inline void csum_batch_ipv4_hdr(struct iphdr **hdrs, int n)
 {
-	int count = len;
-	register u32 sum = 0;
-	u16 answer = 0;
+	int i = 0;
+
+#ifdef __SSE2__
+	/* Masks out the check field (bytes 10-11) while loading the first 16 bytes. */
+	const __m128i check_mask = _mm_set_epi32(-1, 0x0000ffff, -1, -1);
+	const __m128i lo_mask = _mm_set1_epi32(0xffff);
+
+	for (; i + CSUM_BATCH_LANES <= n; i += CSUM_BATCH_LANES) {
+		struct iphdr **h = &hdrs[i];
+
+		if (unlikely(h[0]->ihl != 5 || h[1]->ihl != 5 || h[2]->ihl != 5 || h[3]->ihl != 5)) {
+			for (int j = 0; j < CSUM_BATCH_LANES; j++)
+				update_iph_checksum(h[j]);
 
-	// Sum up 2-byte values until none or only one byte left.
-	while (count > 1) 
-	{
-		sum += *(addr++);
-		count -= 2;
+			continue;
+		}
+
+		__m128i v0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)h[0]), check_mask);
+		__m128i v1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)h[1]), check_mask);
+		__m128i v2 = _mm_and_si128(_mm_loadu_si128((const __m128i *)h[2]), check_mask);
+		__m128i v3 = _mm_and_si128(_mm_loadu_si128((const __m128i *)h[3]), check_mask);
+
+		/* Transpose so that lane j of each row holds a word of packet j. */
+		__m128i a = _mm_unpacklo_epi32(v0, v1);
+		__m128i b = _mm_unpacklo_epi32(v2, v3);
+		__m128i c = _mm_unpackhi_epi32(v0, v1);
+		__m128i d = _mm_unpackhi_epi32(v2, v3);
+
+		__m128i rows[5] = {
+			_mm_unpacklo_epi64(a, b),
+			_mm_unpackhi_epi64(a, b),
+			_mm_unpacklo_epi64(c, d),
+			_mm_unpackhi_epi64(c, d),
+			_mm_set_epi32(((const csum_u32_t *)h[3])[4], ((const csum_u32_t *)h[2])[4],
+				      ((const csum_u32_t *)h[1])[4], ((const csum_u32_t *)h[0])[4]),
+		};
+
+		/* Sum 16-bit halves; ten words per lane can't overflow 32 bits. */
+		__m128i sum = _mm_setzero_si128();
+
+		for (int r = 0; r < 5; r++) {
+			sum = _mm_add_epi32(sum, _mm_and_si128(rows[r], lo_mask));
+			sum = _mm_add_epi32(sum, _mm_srli_epi32(rows[r], 16));
+		}
+
+		u32 sums[CSUM_BATCH_LANES];
+
+		_mm_storeu_si128((__m128i *)sums, sum);
+		csum_batch_fold_lanes(sums, 0);
+
+		for (int j = 0; j < CSUM_BATCH_LANES; j++)
+			h[j]->check = (u16)sums[j];
 	}
+#endif
 
-	// Add left-over byte, if any.
-	if (count > 0) 
-	{
-		sum += *(u8 *) addr;
+	for (; i < n; i++)
+		update_iph_checksum(hdrs[i]);
+}
+
+/*
+ * Shared body of the batch layer-4 checksums. The payload of each packet is
+ * summed with the do_csum() kernel loaded once for the whole batch, then the
+ * pseudo header, fold and invert are done for all lanes at once.
+ */
+static __always_inline void csum_batch_l4(struct iphdr **hdrs, int n, u8 proto,
+					  unsigned check_off, int pseudo)
+{
+	csum_kernel_fn kernel = do_csum_kernel;
+
+	for (int i = 0; i < n; i += CSUM_BATCH_LANES) {
+		int lanes = n - i < CSUM_BATCH_LANES ? n - i : CSUM_BATCH_LANES;
+		u32 sums[CSUM_BATCH_LANES] = { 0 };
+		csum_u16_t *checks[CSUM_BATCH_LANES];
+
+		for (int j = 0; j < lanes; j++) {
+			struct iphdr *iph = hdrs[i + j];
+			unsigned hlen = iph->ihl * 4;
+			unsigned len = ntohs(iph->tot_len) - hlen;
+			unsigned char *l4 = (unsigned char *)iph + hlen;
+			u32 body;
+
+			if (j + 1 < lanes)
+				__builtin_prefetch(hdrs[i + j + 1]);
+
+			checks[j] = (csum_u16_t *)(l4 + check_off);
+			*checks[j] = 0;
+
+			body = kernel(l4, len);
+			sums[j] = (body & 0xffff) + (body >> 16);
+
+			if (pseudo) {
+				sums[j] += (iph->saddr & 0xffff) + (iph->saddr >> 16);
+				sums[j] += (iph->daddr & 0xffff) + (iph->daddr >> 16);
+				sums[j] += htons(proto) + htons(len);
+			}
+		}
+
+		csum_batch_fold_lanes(sums, proto == IPPROTO_UDP);
+
+		for (int j = 0; j < lanes; j++)
+			*checks[j] = (u16)sums[j];
 	}
+}
 
-	// Fold 32-bit sum into 16 bits; we lose information by doing this,
-	// increasing the chances of a collision.
-	// sum = (lower 16 bits) + (upper 16 bits shifted right 16 bits)
-	while (sum >> 16) 
-	{
-		sum = (sum & 0xffff) + (sum >> 16);
+/**
+ * csum_batch_tcp - Compute and store the TCP checksum of several IPv4 packets.
+ * @hdrs: array of pointers to IPv4 headers, each followed by its TCP segment
+ * @n: number of packets
+ */
+static inline void csum_batch_tcp(struct iphdr **hdrs, int n)
+{
+	csum_batch_l4(hdrs, n, IPPROTO_TCP, CSUM_TCP_CHECK_OFF, 1);
+}
+
+/**
+ * csum_batch_udp - Compute and store the UDP checksum of several IPv4 packets.
+ * @hdrs: array of pointers to IPv4 headers, each followed by its UDP datagram
+ * @n: number of packets
+ */
+static inline void csum_batch_udp(struct iphdr **hdrs, int n)
+{
+	csum_batch_l4(hdrs, n, IPPROTO_UDP, CSUM_UDP_CHECK_OFF, 1);
+}
+
+/**
+ * csum_batch_icmp - Compute and store the ICMP checksum of several IPv4 packets.
+ * @hdrs: array of pointers to IPv4 headers, each followed by its ICMP message
+ * @n: number of packets
+ */
+static inline void csum_batch_icmp(struct iphdr **hdrs, int n)
+{
+	csum_batch_l4(hdrs, n, IPPROTO_ICMP, CSUM_ICMP_CHECK_OFF, 0);
+}
+
+/*
+ * Incremental checksum patching (RFC 1624).
+ *
+ * Rewrites header fields of a packet that already carries valid checksums and
+ * adjusts the IPv4 header and layer-4 checksums from the old and new field
+ * values only, without reading the payload.
+ */
+#define CSUM_PATCH_L3 (1 << 0)
+#define CSUM_PATCH_L4 (1 << 1)
+
+/* Field offsets from the start of an option-less IPv4 header. */
+#define CSUM_PATCH_OFF_IP_ID 4
+#define CSUM_PATCH_OFF_IP_TTL 8 /* TTL and protocol word. */
+#define CSUM_PATCH_OFF_IP_SADDR 12
+#define CSUM_PATCH_OFF_IP_DADDR 16
+#define CSUM_PATCH_OFF_L4_SPORT(ihl) ((ihl) * 4)
+#define CSUM_PATCH_OFF_L4_DPORT(ihl) ((ihl) * 4 + 2)
+
+struct csum_patch
+{
+	u16 off;	/* offset from the start of the IPv4 header, must be even */
+	u8 len;		/* 2 or 4 */
+	u32 val;	/* new value in network byte order */
+};
+
+/**
+ * csum_patch_ipv4 - Rewrite header fields and fix up the checksums incrementally.
+ * @iph: IPv4 header of a packet with valid checksums
+ * @patches: fields to rewrite
+ * @n: number of fields
+ * @flags: CSUM_PATCH_L3 and/or CSUM_PATCH_L4 for the checksums to update
+ *
+ * Fields inside the IPv4 header update the header checksum. The source and
+ * destination addresses also update the TCP/UDP checksum through the pseudo
+ * header, and fields past the IPv4 header only update the layer-4 checksum.
+ * A UDP checksum of zero (disabled) is left alone.
+ */
+static inline void csum_patch_ipv4(struct iphdr *iph, const struct csum_patch *patches,
+				   int n, int flags)
+{
+	unsigned char *pkt = (unsigned char *)iph;
+	unsigned hlen = iph->ihl * 4;
+	csum_u16_t *l4_check = NULL;
+	int pseudo = 1;
+	u32 l3 = ~(u32)iph->check;
+	u32 l4;
+
+	switch (iph->protocol) {
+	case IPPROTO_TCP:
+		l4_check = (csum_u16_t *)(pkt + hlen + CSUM_TCP_CHECK_OFF);
+		break;
+	case IPPROTO_UDP:
+		l4_check = (csum_u16_t *)(pkt + hlen + CSUM_UDP_CHECK_OFF);
+		if (*l4_check == 0)
+			l4_check = NULL;
+		break;
+	case IPPROTO_ICMP:
+		l4_check = (csum_u16_t *)(pkt + hlen + CSUM_ICMP_CHECK_OFF);
+		pseudo = 0;
+		break;
 	}
 
-	// Checksum is one's compliment of sum.
-	answer = ~sum;
+	if (!(flags & CSUM_PATCH_L4))
+		l4_check = NULL;
+
+	l4 = l4_check ? ~(u32)*l4_check : 0;
+
+	for (int i = 0; i < n; i++) {
+		const struct csum_patch *p = &patches[i];
+		u32 from = 0, to = p->val;
+
+		if (p->len == 4) {
+			memcpy(&from, pkt + p->off, 4);
+			memcpy(pkt + p->off, &to, 4);
+		} else {
+			u16 old16, new16 = (u16)to;
+
+			memcpy(&old16, pkt + p->off, 2);
+			memcpy(pkt + p->off, &new16, 2);
+			from = old16;
+			to = new16;
+		}
+
+		if (p->off < hlen) {
+			l3 = csum_add(to, csum_sub(from, l3));
+
+			if (!(pseudo && p->off >= CSUM_PATCH_OFF_IP_SADDR &&
+			      p->off < CSUM_PATCH_OFF_IP_DADDR + 4))
+				continue;
+		}
+
+		l4 = csum_add(to, csum_sub(from, l4));
+	}
+
+	if (flags & CSUM_PATCH_L3)
+		iph->check = csum_fold_helper(l3);
+
+	if (l4_check) {
+		u16 check = csum_fold_helper(l4);
+
+		if (check == 0 && iph->protocol == IPPROTO_UDP)
+			check = 0xffff;
+
+		*l4_check = check;
+	}
+}
+#endif
+
+#ifndef __BPF__
+/*
+ * Layer-4 checksums.
+ *
+ * TCP and UDP checksums cover a pseudo header made of the source address,
+ * destination address, protocol and layer-4 length. Everything but the length
+ * is the same for every packet of a flow, so its partial sum is computed once
+ * with csum_flow_init() and reused for each packet.
+ */
+struct csum_flow
+{
+    __wsum sum;
+    u8 proto;
+};
+
+/**
+ * Computes the partial pseudo header sum of a flow (everything but the length).
+ * 
+ * @param flow The flow to initialize.
+ * @param saddr The source address (network byte order).
+ * @param daddr The destination address (network byte order).
+ * @param proto The IP protocol (IPPROTO_TCP, IPPROTO_UDP, or IPPROTO_ICMP).
+ * 
+ * @return Void
+ * 
+ * @note ICMP has no pseudo header so its flow sum is zero.
+**/
+static inline void csum_flow_init(struct csum_flow *flow, __be32 saddr, __be32 daddr, u8 proto)
+{
+    flow->proto = proto;
+    flow->sum = (proto == IPPROTO_ICMP) ? 0 : csum_tcpudp_nofold(saddr, daddr, 0, proto, 0);
+}
+
+/**
+ * Computes the partial pseudo header sum of an IPv6 flow (everything but the length).
+ * 
+ * @param flow The flow to initialize.
+ * @param saddr The source address (16 bytes, network byte order).
+ * @param daddr The destination address (16 bytes, network byte order).
+ * @param proto The next header (IPPROTO_TCP, IPPROTO_UDP, or IPPROTO_ICMPV6).
+ * 
+ * @return Void
+ * 
+ * @note Unlike ICMP, ICMPv6 checksums cover the pseudo header.
+**/
+static inline void csum_flow_init6(struct csum_flow *flow, const struct in6_addr *saddr, const struct in6_addr *daddr, u8 proto)
+{
+    flow->proto = proto;
+    flow->sum = csum_ipv6_nofold(saddr, daddr, 0, proto, 0);
+}
+
+/**
+ * Finishes a layer-4 checksum from an already computed sum over the layer-4 header and data.
+ * 
+ * @param flow The flow the packet belongs to.
+ * @param body The 32-bit unfolded sum of the layer-4 header (with a zeroed checksum field) and data.
+ * @param len The layer-4 length (header and data).
+ * 
+ * @return The 16-bit checksum ready to be stored in the packet.
+ * 
+ * @note Useful with csum_partial_copy() where the sum comes for free while the payload is copied.
+**/
+static inline __sum16 csum_flow_fold(const struct csum_flow *flow, __wsum body, u32 len)
+{
+    __wsum sum = body;
+
+    if (flow->proto != IPPROTO_ICMP)
+    {
+        sum = (__wsum)add32_with_carry(add32_with_carry((u32)sum, (u32)flow->sum), htons(len));
+    }
+
+    __sum16 csum = csum_fold(sum);
 
-	return (answer);
-}
\ No newline at end of file
+    // A computed UDP checksum of zero is sent as all ones (zero means no checksum).
+    if (flow->proto == IPPROTO_UDP && csum == 0)
+    {
+        csum = 0xffff;
+    }
+
+    return csum;
+}
+
+/**
+ * Computes the layer-4 checksum of a packet belonging to a flow.
+ * 
+ * @param flow The flow the packet belongs to.
+ * @param buff A pointer to the layer-4 header (with a zeroed checksum field).
+ * @param len The layer-4 length (header and data).
+ * 
+ * @return The 16-bit checksum ready to be stored in the packet.
+**/
+static inline __sum16 csum_flow_l4(const struct csum_flow *flow, const void *buff, u32 len)
+{
+    return csum_flow_fold(flow, csum_partial(buff, len, 0), len);
+}
+
+/**
+ * Computes the TCP checksum of a segment.
+ * 
+ * @param buff A pointer to the TCP header (with a zeroed checksum field).
+ * @param len The TCP length (header and data).
+ * @param src_addr A pointer to the source address (network byte order).
+ * @param dest_addr A pointer to the destination address (network byte order).
+ * 
+ * @return The 16-bit checksum ready to be stored in the packet.
+ * 
+ * @note Use csum_flow_init() and csum_flow_l4() when sending many packets of the same flow.
+**/
+static inline u16 tcp_checksum(const void *buff, size_t len, u32 *src_addr, u32 *dest_addr)
+{
+    struct csum_flow flow;
+
+    csum_flow_init(&flow, *src_addr, *dest_addr, IPPROTO_TCP);
+
+    return csum_flow_l4(&flow, buff, len);
+}
+
+/**
+ * Computes the UDP checksum of a datagram.
+ * 
+ * @param buff A pointer to the UDP header (with a zeroed checksum field).
+ * @param len The UDP length (header and data).
+ * @param src_addr A pointer to the source address (network byte order).
+ * @param dest_addr A pointer to the destination address (network byte order).
+ * 
+ * @return The 16-bit checksum ready to be stored in the packet.
+**/
+static inline u16 udp_checksum(const void *buff, size_t len, u32 *src_addr, u32 *dest_addr)
+{
+    struct csum_flow flow;
+
+    csum_flow_init(&flow, *src_addr, *dest_addr, IPPROTO_UDP);
+
+    return csum_flow_l4(&flow, buff, len);
+}
+
+/**
+ * Computes the ICMP checksum of a message.
+ * 
+ * @param addr A pointer to the ICMP header (with a zeroed checksum field).
+ * @param len The ICMP length (header and data).
+ * 
+ * @return The 16-bit checksum ready to be stored in the packet.
+**/
+static inline u16 icmp_csum(u16 *addr, int len)
+{
+    return csum_fold(csum_partial(addr, len, 0));
+}
+#endif
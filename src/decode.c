@@ -0,0 +1,542 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "decode.h"
+
+// Maps characters to hexadecimal values (0xFF = not hexadecimal).
+static const u8 hex_table[256] =
+{
+    ['0'] = 0, ['1'] = 1, ['2'] = 2, ['3'] = 3, ['4'] = 4, ['5'] = 5, ['6'] = 6, ['7'] = 7, ['8'] = 8, ['9'] = 9,
+    ['a'] = 10, ['b'] = 11, ['c'] = 12, ['d'] = 13, ['e'] = 14, ['f'] = 15,
+    ['A'] = 10, ['B'] = 11, ['C'] = 12, ['D'] = 13, ['E'] = 14, ['F'] = 15
+};
+
+static inline int hex_val(char c)
+{
+    u8 v = hex_table[(u8)c];
+
+    return v == 0 && c != '0' ? -1 : v;
+}
+
+static inline int hex_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * Decodes one unit of a hexadecimal string: a run of whitespace or a single byte.
+ * 
+ * @param hex A pointer to the current position (advanced).
+ * @param end The end of the string.
+ * @param out The output buffer (may be NULL to only count).
+ * @param len A pointer to the amount of bytes decoded so far (advanced).
+ * @param out_len The size of the output buffer.
+ * 
+ * @return 1 to continue, 0 at the end of the string (or a NUL), or -1 on failure.
+**/
+static inline int hex_step(const char **hex, const char *end, u8 *out, size_t *len, size_t out_len)
+{
+    const char *p = *hex;
+
+    while (p < end && hex_space(*p))
+    {
+        p++;
+    }
+
+    if (p >= end || *p == '\0')
+    {
+        *hex = p;
+
+        return 0;
+    }
+
+    int hi = hex_val(p[0]);
+    int lo = hi < 0 || p + 1 >= end ? -1 : hex_val(p[1]);
+
+    if (lo < 0)
+    {
+        return -1;
+    }
+
+    if (out != NULL)
+    {
+        if (*len >= out_len)
+        {
+            return -1;
+        }
+
+        out[*len] = (u8)((hi << 4) | lo);
+    }
+
+    *len += 1;
+    *hex = p + 2;
+
+    return 1;
+}
+
+/**
+ * Portable hexadecimal decoder.
+ * 
+ * @param hex The hexadecimal string (e.g. "FF FF 00 01", doesn't need to be NUL-terminated).
+ * @param hex_len The string's length.
+ * @param out The output buffer (may be NULL to only count bytes).
+ * @param out_len The size of the output buffer.
+ * 
+ * @return The amount of decoded bytes or -1 on failure.
+**/
+static long decode_hex_generic(const char *hex, size_t hex_len, u8 *out, size_t out_len)
+{
+    const char *end = hex + hex_len;
+    size_t len = 0;
+    int ret;
+
+    while ((ret = hex_step(&hex, end, out, &len, out_len)) > 0);
+
+    return ret < 0 ? -1 : (long)len;
+}
+
+#if defined(__x86_64__)
+/**
+ * Converts 16 characters to hexadecimal values.
+ * 
+ * @param c The characters.
+ * @param valid A pointer to store the mask of hexadecimal characters in.
+ * @param space A pointer to store the mask of whitespace characters in.
+ * 
+ * @return The values (undefined where not hexadecimal).
+**/
+__attribute__((target("ssse3")))
+static inline __m128i hex_nibbles_sse(__m128i c, int *valid, int *space)
+{
+    // Unsigned range checks done as signed compares on values offset by 0x80.
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_d = _mm_cmpgt_epi8(_mm_set1_epi8((char)(0x80 + 10)), _mm_xor_si128(d, bias));
+    __m128i is_l = _mm_cmpgt_epi8(_mm_set1_epi8((char)(0x80 + 6)), _mm_xor_si128(l, bias));
+
+    __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\n'))),
+                              _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(c, _mm_set1_epi8('\r'))));
+
+    *valid = _mm_movemask_epi8(_mm_or_si128(is_d, is_l));
+    *space = _mm_movemask_epi8(ws);
+
+    return _mm_or_si128(_mm_and_si128(is_d, d), _mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+/**
+ * Decodes 32 contiguous hexadecimal characters into 16 bytes.
+ * 
+ * @param hex The characters.
+ * @param out The output (16 bytes).
+ * 
+ * @return 1 on success or 0 if the block isn't 32 hexadecimal characters.
+**/
+__attribute__((target("ssse3")))
+static inline int hex_dense_sse(const char *hex, u8 *out)
+{
+    int va, sa, vb, sb;
+    __m128i a = hex_nibbles_sse(_mm_loadu_si128((const __m128i *)hex), &va, &sa);
+    __m128i b = hex_nibbles_sse(_mm_loadu_si128((const __m128i *)(hex + 16)), &vb, &sb);
+
+    if ((va & vb) != 0xFFFF)
+    {
+        return 0;
+    }
+
+    // (hi * 16 + lo) per pair, then narrow to bytes.
+    const __m128i mul = _mm_set1_epi16(0x0110);
+
+    _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(_mm_maddubs_epi16(a, mul), _mm_maddubs_epi16(b, mul)));
+
+    return 1;
+}
+
+/**
+ * Decodes 48 characters of whitespace-separated bytes ("FF FF ... FF\n") into 16 bytes.
+ * 
+ * @param hex The characters.
+ * @param out The output (16 bytes).
+ * 
+ * @return 1 on success or 0 if the block isn't 16 separated bytes.
+**/
+__attribute__((target("ssse3")))
+static inline int hex_spaced_sse(const char *hex, u8 *out)
+{
+    int va, sa, vb, sb, vc, sc;
+    __m128i a = hex_nibbles_sse(_mm_loadu_si128((const __m128i *)hex), &va, &sa);
+    __m128i b = hex_nibbles_sse(_mm_loadu_si128((const __m128i *)(hex + 16)), &vb, &sb);
+    __m128i c = hex_nibbles_sse(_mm_loadu_si128((const __m128i *)(hex + 32)), &vc, &sc);
+
+    // Every third character is a separator.
+    if ((va & 0xB6DB) != 0xB6DB || (sa & 0x4924) != 0x4924 || (vb & 0xDB6D) != 0xDB6D || (sb & 0x2492) != 0x2492 || (vc & 0x6DB6) != 0x6DB6 || (sc & 0x9249) != 0x9249)
+    {
+        return 0;
+    }
+
+    const __m128i hi_a = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i hi_b = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i hi_c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i lo_a = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i lo_b = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i lo_c = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+
+    __m128i hi = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, hi_a), _mm_shuffle_epi8(b, hi_b)), _mm_shuffle_epi8(c, hi_c));
+    __m128i lo = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, lo_a), _mm_shuffle_epi8(b, lo_b)), _mm_shuffle_epi8(c, lo_c));
+
+    // Values are at most 15, so shifting 16-bit lanes never carries into the next byte.
+    _mm_storeu_si128((__m128i *)out, _mm_or_si128(_mm_slli_epi16(hi, 4), lo));
+
+    return 1;
+}
+
+/**
+ * SSSE3 hexadecimal decoder. Contiguous and whitespace-separated runs are decoded 16 bytes at a time; anything else goes through the portable path.
+ * 
+ * @param hex The hexadecimal string.
+ * @param hex_len The string's length.
+ * @param out The output buffer (may be NULL to only count bytes).
+ * @param out_len The size of the output buffer.
+ * 
+ * @return The amount of decoded bytes or -1 on failure.
+**/
+__attribute__((target("ssse3")))
+static long decode_hex_ssse3(const char *hex, size_t hex_len, u8 *out, size_t out_len)
+{
+    const char *end = hex + hex_len;
+    size_t len = 0;
+    u8 tmp[16];
+
+    // Try whichever layout matched last first.
+    int spaced = 1;
+
+    for (;;)
+    {
+        u8 *dst = out != NULL && len + 16 <= out_len ? out + len : (out == NULL ? tmp : NULL);
+
+        if (dst != NULL)
+        {
+            if (!spaced && end - hex >= 32 && hex_dense_sse(hex, dst))
+            {
+                hex += 32;
+                len += 16;
+
+                continue;
+            }
+
+            if (end - hex >= 48 && hex_spaced_sse(hex, dst))
+            {
+                hex += 48;
+                len += 16;
+                spaced = 1;
+
+                continue;
+            }
+
+            if (spaced && end - hex >= 32 && hex_dense_sse(hex, dst))
+            {
+                hex += 32;
+                len += 16;
+                spaced = 0;
+
+                continue;
+            }
+        }
+
+        int ret = hex_step(&hex, end, out, &len, out_len);
+
+        if (ret <= 0)
+        {
+            return ret < 0 ? -1 : (long)len;
+        }
+    }
+}
+
+/**
+ * Decodes 64 contiguous hexadecimal characters into 32 bytes.
+ * 
+ * @param hex The characters.
+ * @param out The output (32 bytes).
+ * 
+ * @return 1 on success or 0 if the block isn't 64 hexadecimal characters.
+**/
+__attribute__((target("avx2")))
+static inline int hex_dense_avx2(const char *hex, u8 *out)
+{
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    __m256i vals[2];
+    int valid = -1;
+
+    for (int i = 0; i < 2; i++)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(hex + i * 32));
+        __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+        __m256i l = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        __m256i is_d = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 10)), _mm256_xor_si256(d, bias));
+        __m256i is_l = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 6)), _mm256_xor_si256(l, bias));
+
+        valid &= _mm256_movemask_epi8(_mm256_or_si256(is_d, is_l));
+
+        vals[i] = _mm256_or_si256(_mm256_and_si256(is_d, d), _mm256_and_si256(is_l, _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+    }
+
+    if (valid != -1)
+    {
+        return 0;
+    }
+
+    const __m256i mul = _mm256_set1_epi16(0x0110);
+    __m256i packed = _mm256_packus_epi16(_mm256_maddubs_epi16(vals[0], mul), _mm256_maddubs_epi16(vals[1], mul));
+
+    // Packing works per 128-bit lane, so put the quarters back in order.
+    _mm256_storeu_si256((__m256i *)out, _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+
+    return 1;
+}
+
+/**
+ * AVX2 hexadecimal decoder. Contiguous runs are decoded 32 bytes at a time and whitespace-separated runs 16 at a time.
+ * 
+ * @param hex The hexadecimal string.
+ * @param hex_len The string's length.
+ * @param out The output buffer (may be NULL to only count bytes).
+ * @param out_len The size of the output buffer.
+ * 
+ * @return The amount of decoded bytes or -1 on failure.
+**/
+__attribute__((target("avx2")))
+static long decode_hex_avx2(const char *hex, size_t hex_len, u8 *out, size_t out_len)
+{
+    const char *end = hex + hex_len;
+    size_t len = 0;
+    u8 tmp[32];
+
+    // Try whichever layout matched last first.
+    int spaced = 1;
+
+    for (;;)
+    {
+        u8 *dst = out != NULL && len + 32 <= out_len ? out + len : (out == NULL ? tmp : NULL);
+
+        if (dst != NULL)
+        {
+            if (!spaced && end - hex >= 64 && hex_dense_avx2(hex, dst))
+            {
+                hex += 64;
+                len += 32;
+
+                continue;
+            }
+
+            if (end - hex >= 48 && hex_spaced_sse(hex, dst))
+            {
+                hex += 48;
+                len += 16;
+                spaced = 1;
+
+                continue;
+            }
+
+            if (spaced && end - hex >= 64 && hex_dense_avx2(hex, dst))
+            {
+                hex += 64;
+                len += 32;
+                spaced = 0;
+
+                continue;
+            }
+
+            if (end - hex >= 32 && hex_dense_sse(hex, dst))
+            {
+                hex += 32;
+                len += 16;
+
+                continue;
+            }
+        }
+
+        int ret = hex_step(&hex, end, out, &len, out_len);
+
+        if (ret <= 0)
+        {
+            return ret < 0 ? -1 : (long)len;
+        }
+    }
+}
+#endif
+
+/**
+ * Retrieves a hexadecimal decoding kernel.
+ * 
+ * @param kernel The kernel to retrieve (HEX_KERNEL_AUTO picks the fastest one).
+ * 
+ * @return The kernel or NULL if it isn't built in or the CPU doesn't support it.
+**/
+hex_kernel_fn hex_kernel_get(enum hex_kernel kernel)
+{
+    switch (kernel)
+    {
+        case HEX_KERNEL_AUTO:
+#if defined(__x86_64__)
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return decode_hex_avx2;
+            }
+
+            if (__builtin_cpu_supports("ssse3"))
+            {
+                return decode_hex_ssse3;
+            }
+#endif
+            return decode_hex_generic;
+
+        case HEX_KERNEL_GENERIC:
+            return decode_hex_generic;
+
+#if defined(__x86_64__)
+        case HEX_KERNEL_SSSE3:
+            __builtin_cpu_init();
+
+            return __builtin_cpu_supports("ssse3") ? decode_hex_ssse3 : NULL;
+
+        case HEX_KERNEL_AVX2:
+            __builtin_cpu_init();
+
+            return __builtin_cpu_supports("avx2") ? decode_hex_avx2 : NULL;
+#endif
+
+        default:
+            return NULL;
+    }
+}
+
+static hex_kernel_fn hex_kernel;
+
+/**
+ * Decodes a hexadecimal string (e.g. "FF FF 00 01") into bytes using the fastest kernel the CPU supports. Whitespace between bytes is ignored and decoding stops at a NUL.
+ * 
+ * @param hex The hexadecimal string (doesn't need to be NUL-terminated).
+ * @param hex_len The string's length.
+ * @param out The buffer to store the decoded bytes in. May be NULL to only count bytes.
+ * @param out_len The size of the output buffer.
+ * 
+ * @return The amount of decoded bytes or -1 on failure (invalid character, odd digit count, or output buffer too small).
+**/
+long decode_hex(const char *hex, size_t hex_len, u8 *out, size_t out_len)
+{
+    hex_kernel_fn fn = __atomic_load_n(&hex_kernel, __ATOMIC_RELAXED);
+
+    if (fn == NULL)
+    {
+        fn = hex_kernel_get(HEX_KERNEL_AUTO);
+
+        __atomic_store_n(&hex_kernel, fn, __ATOMIC_RELAXED);
+    }
+
+    return fn(hex, hex_len, out, out_len);
+}
+
+/**
+ * Decodes escape sequences in a string payload (\n, \r, \t, \0, \\, \", \', \a, \b, \f, \v, \xHH, and up to three octal digits).
+ * 
+ * @param str The string (doesn't need to be NUL-terminated).
+ * @param str_len The string's length.
+ * @param out The buffer to store the decoded bytes in (at most str_len bytes are written).
+ * @param out_len The size of the output buffer.
+ * 
+ * @return The amount of decoded bytes or -1 on failure (unknown or truncated escape, or output buffer too small).
+ * 
+ * @note Runs without escapes are found with memchr() and copied with memcpy(), so mostly literal payloads decode at memory speed.
+**/
+long decode_escapes(const char *str, size_t str_len, u8 *out, size_t out_len)
+{
+    const char *end = str + str_len;
+    size_t len = 0;
+
+    while (str < end)
+    {
+        const char *esc = memchr(str, '\\', end - str);
+        size_t run = (esc ? esc : end) - str;
+
+        if (len + run > out_len)
+        {
+            return -1;
+        }
+
+        memcpy(out + len, str, run);
+        len += run;
+
+        if (esc == NULL)
+        {
+            break;
+        }
+
+        str = esc + 1;
+
+        if (str >= end || len >= out_len)
+        {
+            return -1;
+        }
+
+        char c = *str++;
+        int val;
+
+        switch (c)
+        {
+            case 'n': val = '\n'; break;
+            case 'r': val = '\r'; break;
+            case 't': val = '\t'; break;
+            case 'a': val = '\a'; break;
+            case 'b': val = '\b'; break;
+            case 'f': val = '\f'; break;
+            case 'v': val = '\v'; break;
+            case '\\': case '"': case '\'': case '?': val = c; break;
+
+            case 'x':
+            {
+                int hi = str < end ? hex_val(str[0]) : -1;
+
+                if (hi < 0)
+                {
+                    return -1;
+                }
+
+                int lo = str + 1 < end ? hex_val(str[1]) : -1;
+
+                val = lo < 0 ? hi : (hi << 4) | lo;
+                str += lo < 0 ? 1 : 2;
+
+                break;
+            }
+
+            default:
+                if (c < '0' || c > '7')
+                {
+                    return -1;
+                }
+
+                val = c - '0';
+
+                for (int i = 0; i < 2 && str < end && *str >= '0' && *str <= '7'; i++)
+                {
+                    val = (val << 3) | (*str++ - '0');
+                }
+
+                if (val > 0xFF)
+                {
+                    return -1;
+                }
+        }
+
+        out[len++] = (u8)val;
+    }
+
+    return (long)len;
+}
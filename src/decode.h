@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "simple_types.h"
+
+enum hex_kernel
+{
+    HEX_KERNEL_AUTO = 0,
+    HEX_KERNEL_GENERIC,
+    HEX_KERNEL_SSSE3,
+    HEX_KERNEL_AVX2,
+    HEX_KERNEL_MAX
+};
+
+typedef long (*hex_kernel_fn)(const char *hex, size_t hex_len, u8 *out, size_t out_len);
+
+hex_kernel_fn hex_kernel_get(enum hex_kernel kernel);
+long decode_hex(const char *hex, size_t hex_len, u8 *out, size_t out_len);
+long decode_escapes(const char *str, size_t str_len, u8 *out, size_t out_len);
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "hash.h"
+
+/**
+ * Hashes a file's contents.
+ * 
+ * @param path The file's path.
+ * @param seed The seed (chain hashes by passing a previous result).
+ * @param out A pointer to store the hash in.
+ * 
+ * @return 0 on success or -1 on failure (file can't be read).
+**/
+int hash_file(const char *path, u64 seed, u64 *out)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+
+        return -1;
+    }
+
+    if (st.st_size == 0)
+    {
+        close(fd);
+
+        *out = hash64(NULL, 0, seed);
+
+        return 0;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    *out = hash64(data, st.st_size, seed);
+
+    munmap(data, st.st_size);
+
+    return 0;
+}
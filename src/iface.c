@@ -0,0 +1,364 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include "iface.h"
+#include "netlink.h"
+
+typedef struct iface_table
+{
+    iface_t *ifaces;
+    u32 count;
+    u32 cap;
+
+    // Open addressing hash of names (slot values are index + 1, 0 = empty).
+    u32 *slots;
+    u32 slot_mask;
+
+    int loaded;
+} iface_table_t;
+
+static iface_table_t iface_tbl;
+static pthread_once_t iface_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Hashes an interface name (FNV-1a).
+ * 
+ * @param name The interface name.
+ * 
+ * @return The hash.
+**/
+static u32 iface_hash(const char *name)
+{
+    u32 hash = 2166136261U;
+
+    while (*name)
+    {
+        hash ^= (u8)*name++;
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/**
+ * Counts the entries of a sysfs queue directory with a given prefix.
+ * 
+ * @param dev The interface name.
+ * @param prefix The queue prefix ("tx-" or "rx-").
+ * 
+ * @return The amount of queues (0 if the directory can't be read).
+**/
+static u32 iface_count_queues(const char *dev, const char *prefix)
+{
+    char path[255];
+    snprintf(path, sizeof(path) - 1, "/sys/class/net/%s/queues", dev);
+
+    DIR *dir = opendir(path);
+
+    if (dir == NULL)
+    {
+        return 0;
+    }
+
+    u32 count = 0;
+    struct dirent *ent;
+
+    while ((ent = readdir(dir)) != NULL)
+    {
+        if (strncmp(ent->d_name, prefix, strlen(prefix)) == 0)
+        {
+            count++;
+        }
+    }
+
+    closedir(dir);
+
+    return count;
+}
+
+/**
+ * Reads the NUMA node of an interface's device from sysfs.
+ * 
+ * @param dev The interface name.
+ * 
+ * @return The NUMA node or -1 if unknown.
+**/
+static int iface_read_numa(const char *dev)
+{
+    char path[255];
+    snprintf(path, sizeof(path) - 1, "/sys/class/net/%s/device/numa_node", dev);
+
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL)
+    {
+        return -1;
+    }
+
+    int node = -1;
+
+    if (fscanf(fp, "%d", &node) != 1)
+    {
+        node = -1;
+    }
+
+    fclose(fp);
+
+    return node;
+}
+
+/**
+ * Parses a link message into the interface table.
+ * 
+ * @param nh The link message.
+ * @param ctx The interface table (iface_table_t).
+ * 
+ * @return Void
+**/
+static void iface_link_cb(struct nlmsghdr *nh, void *ctx)
+{
+    iface_table_t *tbl = ctx;
+
+    if (nh->nlmsg_type != RTM_NEWLINK)
+    {
+        return;
+    }
+
+    if (tbl->count >= tbl->cap)
+    {
+        u32 cap = tbl->cap ? tbl->cap * 2 : 16;
+        iface_t *ifaces = realloc(tbl->ifaces, sizeof(iface_t) * cap);
+
+        if (ifaces == NULL)
+        {
+            return;
+        }
+
+        tbl->ifaces = ifaces;
+        tbl->cap = cap;
+    }
+
+    struct ifinfomsg *ifi = NLMSG_DATA(nh);
+    iface_t *iface = &tbl->ifaces[tbl->count];
+
+    memset(iface, 0, sizeof(*iface));
+    iface->ifindex = ifi->ifi_index;
+
+    int len = IFLA_PAYLOAD(nh);
+
+    for (struct rtattr *rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        switch (rta->rta_type)
+        {
+            case IFLA_IFNAME:
+                strncpy(iface->name, RTA_DATA(rta), sizeof(iface->name) - 1);
+
+                break;
+
+            case IFLA_ADDRESS:
+                if (RTA_PAYLOAD(rta) == ETH_ALEN)
+                {
+                    memcpy(iface->mac, RTA_DATA(rta), ETH_ALEN);
+                }
+
+                break;
+
+            case IFLA_MTU:
+                iface->mtu = *(u32 *)RTA_DATA(rta);
+
+                break;
+
+            case IFLA_NUM_TX_QUEUES:
+                iface->tx_queues = *(u32 *)RTA_DATA(rta);
+
+                break;
+
+            case IFLA_NUM_RX_QUEUES:
+                iface->rx_queues = *(u32 *)RTA_DATA(rta);
+
+                break;
+        }
+    }
+
+    if (iface->name[0] == '\0')
+    {
+        return;
+    }
+
+    tbl->count++;
+}
+
+/**
+ * Builds the interface table (once).
+ * 
+ * @return Void
+**/
+static void iface_build()
+{
+    iface_table_t *tbl = &iface_tbl;
+    nl_request_t req = {0};
+
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.nh.nlmsg_type = RTM_GETLINK;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.ifi.ifi_family = AF_UNSPEC;
+
+    if (nl_transact(&req, iface_link_cb, tbl) != 0)
+    {
+        fprintf(stderr, "Failed to dump network interfaces.\n");
+    }
+
+    // Fill in what netlink doesn't report.
+    for (u32 i = 0; i < tbl->count; i++)
+    {
+        iface_t *iface = &tbl->ifaces[i];
+        u32 tx = iface_count_queues(iface->name, "tx-");
+        u32 rx = iface_count_queues(iface->name, "rx-");
+
+        if (tx > 0)
+        {
+            iface->tx_queues = tx;
+        }
+
+        if (rx > 0)
+        {
+            iface->rx_queues = rx;
+        }
+
+        iface->numa_node = iface_read_numa(iface->name);
+    }
+
+    // Size the hash to at least twice the amount of interfaces.
+    u32 slots = 16;
+
+    while (slots < tbl->count * 2)
+    {
+        slots *= 2;
+    }
+
+    tbl->slots = calloc(slots, sizeof(u32));
+
+    if (tbl->slots != NULL)
+    {
+        tbl->slot_mask = slots - 1;
+
+        for (u32 i = 0; i < tbl->count; i++)
+        {
+            u32 idx = iface_hash(tbl->ifaces[i].name) & tbl->slot_mask;
+
+            while (tbl->slots[idx] != 0)
+            {
+                idx = (idx + 1) & tbl->slot_mask;
+            }
+
+            tbl->slots[idx] = i + 1;
+        }
+    }
+
+    tbl->loaded = tbl->slots != NULL;
+}
+
+/**
+ * Loads the interface table. This is done once per process (on the first call of any lookup if not called at startup) and the table isn't modified afterwards, so lookups need no locking.
+ * 
+ * @return 0 on success or -1 on failure.
+ * 
+ * @note Interfaces created after loading aren't seen.
+**/
+int iface_load()
+{
+    pthread_once(&iface_once, iface_build);
+
+    return iface_tbl.loaded ? 0 : -1;
+}
+
+/**
+ * Retrieves an interface by name.
+ * 
+ * @param name The interface name.
+ * 
+ * @return A pointer to the interface or NULL if not found.
+**/
+const iface_t *iface_get(const char *name)
+{
+    if (iface_load() != 0 || name == NULL)
+    {
+        return NULL;
+    }
+
+    u32 idx = iface_hash(name) & iface_tbl.slot_mask;
+
+    while (iface_tbl.slots[idx] != 0)
+    {
+        const iface_t *iface = &iface_tbl.ifaces[iface_tbl.slots[idx] - 1];
+
+        if (strcmp(iface->name, name) == 0)
+        {
+            return iface;
+        }
+
+        idx = (idx + 1) & iface_tbl.slot_mask;
+    }
+
+    return NULL;
+}
+
+/**
+ * Retrieves an interface by index.
+ * 
+ * @param ifindex The interface index.
+ * 
+ * @return A pointer to the interface or NULL if not found.
+**/
+const iface_t *iface_get_index(int ifindex)
+{
+    if (iface_load() != 0)
+    {
+        return NULL;
+    }
+
+    for (u32 i = 0; i < iface_tbl.count; i++)
+    {
+        if (iface_tbl.ifaces[i].ifindex == ifindex)
+        {
+            return &iface_tbl.ifaces[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Retrieves the amount of interfaces.
+ * 
+ * @return The amount of interfaces.
+**/
+u32 iface_count()
+{
+    if (iface_load() != 0)
+    {
+        return 0;
+    }
+
+    return iface_tbl.count;
+}
+
+/**
+ * Retrieves an interface by position.
+ * 
+ * @param idx The position (below iface_count()).
+ * 
+ * @return A pointer to the interface or NULL if out of range.
+**/
+const iface_t *iface_at(u32 idx)
+{
+    if (idx >= iface_count())
+    {
+        return NULL;
+    }
+
+    return &iface_tbl.ifaces[idx];
+}
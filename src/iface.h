@@ -0,0 +1,27 @@
+#pragma once
+
+#include <net/if.h>
+#include <linux/if_ether.h>
+
+#include "simple_types.h"
+
+typedef struct iface
+{
+    char name[IFNAMSIZ];
+    int ifindex;
+    u8 mac[ETH_ALEN];
+    u32 mtu;
+
+    // Active queue counts (from sysfs, falling back to the allocated counts).
+    u32 tx_queues;
+    u32 rx_queues;
+
+    // NUMA node of the NIC (-1 if unknown or virtual).
+    int numa_node;
+} iface_t;
+
+int iface_load();
+const iface_t *iface_get(const char *name);
+const iface_t *iface_get_index(int ifindex);
+u32 iface_count();
+const iface_t *iface_at(u32 idx);
@@ -0,0 +1,840 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+
+#include "netlink.h"
+
+// Neighbor states that carry a usable link-layer address.
+#define NL_NUD_VALID (NUD_PERMANENT | NUD_NOARP | NUD_REACHABLE | NUD_STALE | NUD_DELAY | NUD_PROBE)
+
+// Neighbor states the kernel is still verifying (usable, but only trusted briefly).
+#define NL_NUD_UNSURE (NUD_STALE | NUD_DELAY | NUD_PROBE)
+
+typedef struct nl_cache_entry
+{
+    // Address family, interface, and address (IPv4 in the first 4 bytes) the entry is keyed on.
+    u8 family;
+    int ifindex;
+    u8 addr[16];
+
+    u8 mac[ETH_ALEN];
+
+    // When the entry stops being trusted (CLOCK_MONOTONIC milliseconds, 0 = dropped). Dropped and expired entries keep their slot so probe chains stay intact.
+    u64 expires;
+    u8 used;
+} nl_cache_entry_t;
+
+typedef struct nl_neigh_ctx
+{
+    int family;
+    u64 now;
+} nl_neigh_ctx_t;
+
+static nl_cache_entry_t nl_cache[NL_CACHE_SIZE];
+static pthread_mutex_t nl_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static u32 nl_seq;
+
+/**
+ * Retrieves the current time for cache expiry.
+ * 
+ * @return CLOCK_MONOTONIC in milliseconds.
+**/
+static u64 nl_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Hashes a neighbor's family and address to its first cache slot. The interface isn't hashed so lookups for any interface find every entry of an address on one probe chain.
+ * 
+ * @param family The address family.
+ * @param addr The address (16 bytes, IPv4 in the first 4).
+ * 
+ * @return The slot index.
+**/
+static u32 nl_cache_hash(int family, const u8 *addr)
+{
+    u32 h = family;
+
+    for (int i = 0; i < 16; i += 4)
+    {
+        u32 w;
+        memcpy(&w, addr + i, sizeof(w));
+
+        h = (h ^ w) * 0x9e3779b1U;
+    }
+
+    return (h >> 16) % NL_CACHE_SIZE;
+}
+
+/**
+ * Stores a neighbor in the cache (open addressing with linear probing), replacing its previous entry.
+ * 
+ * @param family The address family.
+ * @param addr The address (16 bytes, IPv4 in the first 4).
+ * @param ifindex The interface the neighbor is on.
+ * @param mac The neighbor's MAC address (NULL drops the entry).
+ * @param expires When the entry stops being trusted (see nl_cache_entry_t).
+ * 
+ * @return Void
+**/
+static void nl_cache_store(int family, const u8 *addr, int ifindex, const u8 *mac, u64 expires)
+{
+    u32 idx = nl_cache_hash(family, addr);
+    u64 now = nl_now();
+    nl_cache_entry_t *slot = NULL;
+    int exact = 0;
+
+    pthread_mutex_lock(&nl_cache_lock);
+
+    for (int i = 0; i < NL_CACHE_SIZE; i++)
+    {
+        nl_cache_entry_t *ent = &nl_cache[(idx + i) % NL_CACHE_SIZE];
+
+        if (!ent->used)
+        {
+            slot = slot ? slot : ent;
+
+            break;
+        }
+
+        if (ent->family == family && ent->ifindex == ifindex && memcmp(ent->addr, addr, 16) == 0)
+        {
+            slot = ent;
+            exact = 1;
+
+            break;
+        }
+
+        // Reuse the first dead entry unless the neighbor already has one further down the chain.
+        if (slot == NULL && ent->expires <= now)
+        {
+            slot = ent;
+        }
+    }
+
+    // Dropping a neighbor that isn't cached is a no-op.
+    if (slot != NULL && (mac != NULL || exact))
+    {
+        slot->family = family;
+        slot->ifindex = ifindex;
+        memcpy(slot->addr, addr, 16);
+
+        if (mac != NULL)
+        {
+            memcpy(slot->mac, mac, ETH_ALEN);
+        }
+
+        slot->expires = mac != NULL ? expires : 0;
+        slot->used = 1;
+    }
+
+    pthread_mutex_unlock(&nl_cache_lock);
+}
+
+/**
+ * Retrieves a neighbor from the cache.
+ * 
+ * @param family The address family.
+ * @param addr The address (16 bytes, IPv4 in the first 4).
+ * @param ifindex The interface the neighbor is on (0 = any).
+ * @param mac A pointer to store the MAC address in.
+ * 
+ * @return 0 if found or -1 otherwise (not cached or expired).
+**/
+static int nl_cache_get(int family, const u8 *addr, int ifindex, u8 *mac)
+{
+    u32 idx = nl_cache_hash(family, addr);
+    u64 now = nl_now();
+    int ret = -1;
+
+    pthread_mutex_lock(&nl_cache_lock);
+
+    for (int i = 0; i < NL_CACHE_SIZE; i++)
+    {
+        nl_cache_entry_t *ent = &nl_cache[(idx + i) % NL_CACHE_SIZE];
+
+        if (!ent->used)
+        {
+            break;
+        }
+
+        if (ent->family == family && (ifindex == 0 || ent->ifindex == ifindex) && ent->expires > now && memcmp(ent->addr, addr, 16) == 0)
+        {
+            memcpy(mac, ent->mac, ETH_ALEN);
+            ret = 0;
+
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&nl_cache_lock);
+
+    return ret;
+}
+
+/**
+ * Empties the neighbor cache.
+ * 
+ * @return Void
+**/
+void nl_cache_flush()
+{
+    pthread_mutex_lock(&nl_cache_lock);
+
+    memset(nl_cache, 0, sizeof(nl_cache));
+
+    pthread_mutex_unlock(&nl_cache_lock);
+}
+
+/**
+ * Opens a route netlink socket.
+ * 
+ * @return The socket's file descriptor or -1 on failure.
+**/
+static int nl_open()
+{
+    int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    struct sockaddr_nl sa = {0};
+    sa.nl_family = AF_NETLINK;
+
+    struct timeval tv = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)
+    {
+        close(fd);
+
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Appends an attribute to a request.
+ * 
+ * @param req A pointer to the request.
+ * @param type The attribute type.
+ * @param data The attribute's data.
+ * @param len The attribute's data length.
+ * 
+ * @return Void
+**/
+void nl_add_attr(nl_request_t *req, u16 type, const void *data, u16 len)
+{
+    struct rtattr *rta = (struct rtattr *)((char *)req + NLMSG_ALIGN(req->nh.nlmsg_len));
+
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(len);
+    memcpy(RTA_DATA(rta), data, len);
+
+    req->nh.nlmsg_len = NLMSG_ALIGN(req->nh.nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+/**
+ * Sends a request and passes every reply message to a callback until the request is done.
+ * 
+ * @param req A pointer to the request.
+ * @param cb The callback to call for each reply message.
+ * @param ctx The callback's context.
+ * 
+ * @return 0 on success or -1 on failure (socket error or the kernel returned an error).
+**/
+int nl_transact(nl_request_t *req, void (*cb)(struct nlmsghdr *nh, void *ctx), void *ctx)
+{
+    int fd = nl_open();
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    req->nh.nlmsg_seq = __atomic_add_fetch(&nl_seq, 1, __ATOMIC_RELAXED);
+
+    if (send(fd, req, req->nh.nlmsg_len, 0) < 0)
+    {
+        close(fd);
+
+        return -1;
+    }
+
+    char buf[32768] __attribute__((aligned(NLMSG_ALIGNTO)));
+    int ret = -1;
+    int done = 0;
+
+    while (!done)
+    {
+        ssize_t len = recv(fd, buf, sizeof(buf), 0);
+
+        if (len <= 0)
+        {
+            break;
+        }
+
+        for (struct nlmsghdr *nh = (struct nlmsghdr *)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len))
+        {
+            if (nh->nlmsg_seq != req->nh.nlmsg_seq)
+            {
+                continue;
+            }
+
+            if (nh->nlmsg_type == NLMSG_DONE)
+            {
+                ret = 0;
+                done = 1;
+
+                break;
+            }
+
+            if (nh->nlmsg_type == NLMSG_ERROR)
+            {
+                struct nlmsgerr *err = NLMSG_DATA(nh);
+
+                ret = err->error == 0 ? 0 : -1;
+                done = 1;
+
+                break;
+            }
+
+            cb(nh, ctx);
+
+            // Non-dump requests get a single reply.
+            if (!(nh->nlmsg_flags & NLM_F_MULTI))
+            {
+                ret = 0;
+                done = 1;
+
+                break;
+            }
+        }
+    }
+
+    close(fd);
+
+    return ret;
+}
+
+typedef struct nl_route_ctx
+{
+    // Address family and outgoing interface (0 = any) routes must match.
+    int family;
+    int oif;
+
+    // Gateway (IPv4 in the first 4 bytes).
+    u8 gw[16];
+    int ifindex;
+    u32 priority;
+    int found;
+} nl_route_ctx_t;
+
+/**
+ * Parses a route message.
+ * 
+ * @param nh The route message.
+ * @param ctx The route context (nl_route_ctx_t). For dumps, only default routes are considered and the lowest priority wins.
+ * 
+ * @return Void
+**/
+static void nl_route_cb(struct nlmsghdr *nh, void *ctx)
+{
+    nl_route_ctx_t *rc = ctx;
+
+    if (nh->nlmsg_type != RTM_NEWROUTE)
+    {
+        return;
+    }
+
+    struct rtmsg *rt = NLMSG_DATA(nh);
+
+    if (rt->rtm_family != rc->family || ((nh->nlmsg_flags & NLM_F_MULTI) && (rt->rtm_dst_len != 0 || rt->rtm_table != RT_TABLE_MAIN)))
+    {
+        return;
+    }
+
+    u8 gw[16] = {0};
+    int has_gw = 0;
+    int ifindex = 0;
+    u32 priority = 0;
+    int len = RTM_PAYLOAD(nh);
+
+    for (struct rtattr *rta = RTM_RTA(rt); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        switch (rta->rta_type)
+        {
+            case RTA_GATEWAY:
+                if (RTA_PAYLOAD(rta) <= sizeof(gw))
+                {
+                    memcpy(gw, RTA_DATA(rta), RTA_PAYLOAD(rta));
+
+                    has_gw = 1;
+                }
+
+                break;
+
+            case RTA_OIF:
+                ifindex = *(int *)RTA_DATA(rta);
+
+                break;
+
+            case RTA_PRIORITY:
+                priority = *(u32 *)RTA_DATA(rta);
+
+                break;
+        }
+    }
+
+    if ((nh->nlmsg_flags & NLM_F_MULTI) && (!has_gw || (rc->oif != 0 && ifindex != rc->oif) || (rc->found && priority >= rc->priority)))
+    {
+        return;
+    }
+
+    memcpy(rc->gw, gw, sizeof(gw));
+    rc->ifindex = ifindex;
+    rc->priority = priority;
+    rc->found = 1;
+}
+
+/**
+ * Retrieves the default gateway of an address family through an interface (lowest metric default route of the main table).
+ * 
+ * @param family The address family (AF_INET or AF_INET6).
+ * @param oif The outgoing interface index the route must use (0 = any).
+ * @param gw A pointer to store the gateway's address in (4 bytes for IPv4, 16 for IPv6, network byte order).
+ * @param ifindex A pointer to store the outgoing interface index in (may be NULL).
+ * 
+ * @return 0 on success or -1 on failure (no default route).
+**/
+int nl_iface_gw(int family, int oif, void *gw, int *ifindex)
+{
+    nl_request_t req = {0};
+    nl_route_ctx_t rc = {0};
+
+    rc.family = family;
+    rc.oif = oif;
+
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nh.nlmsg_type = RTM_GETROUTE;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.rt.rtm_family = family;
+
+    if (nl_transact(&req, nl_route_cb, &rc) != 0 || !rc.found)
+    {
+        return -1;
+    }
+
+    memcpy(gw, rc.gw, family == AF_INET6 ? 16 : sizeof(be32));
+
+    if (ifindex != NULL)
+    {
+        *ifindex = rc.ifindex;
+    }
+
+    return 0;
+}
+
+/**
+ * Retrieves the host's IPv4 default gateway (lowest metric default route of the main table).
+ * 
+ * @param gw A pointer to store the gateway's address in (network byte order).
+ * @param ifindex A pointer to store the outgoing interface index in (may be NULL).
+ * 
+ * @return 0 on success or -1 on failure (no default route).
+**/
+int nl_default_gw(be32 *gw, int *ifindex)
+{
+    return nl_iface_gw(AF_INET, 0, gw, ifindex);
+}
+
+/**
+ * Retrieves the next hop the kernel would use to reach a destination.
+ * 
+ * @param dst The destination address (network byte order).
+ * @param next_hop A pointer to store the next hop in. This is the destination itself when it's on-link.
+ * @param ifindex A pointer to store the outgoing interface index in (may be NULL).
+ * 
+ * @return 0 on success or -1 on failure (no route).
+**/
+int nl_route_get(be32 dst, be32 *next_hop, int *ifindex)
+{
+    nl_request_t req = {0};
+    nl_route_ctx_t rc = {0};
+
+    rc.family = AF_INET;
+
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    req.nh.nlmsg_type = RTM_GETROUTE;
+    req.nh.nlmsg_flags = NLM_F_REQUEST;
+    req.rt.rtm_family = AF_INET;
+    req.rt.rtm_dst_len = 32;
+
+    nl_add_attr(&req, RTA_DST, &dst, sizeof(dst));
+
+    if (nl_transact(&req, nl_route_cb, &rc) != 0 || !rc.found)
+    {
+        return -1;
+    }
+
+    be32 gw;
+    memcpy(&gw, rc.gw, sizeof(gw));
+
+    *next_hop = gw ? gw : dst;
+
+    if (ifindex != NULL)
+    {
+        *ifindex = rc.ifindex;
+    }
+
+    return 0;
+}
+
+/**
+ * Parses a neighbor message and caches it. Neighbors the kernel no longer has a usable address for are dropped from the cache.
+ * 
+ * @param nh The neighbor message.
+ * @param ctx The dump context (nl_neigh_ctx_t).
+ * 
+ * @return Void
+**/
+static void nl_neigh_cb(struct nlmsghdr *nh, void *ctx)
+{
+    nl_neigh_ctx_t *nc = ctx;
+
+    if (nh->nlmsg_type != RTM_NEWNEIGH)
+    {
+        return;
+    }
+
+    struct ndmsg *nd = NLMSG_DATA(nh);
+
+    if (nd->ndm_family != nc->family)
+    {
+        return;
+    }
+
+    u8 addr[16] = {0};
+    int has_addr = 0;
+    u8 *mac = NULL;
+    unsigned addr_len = nc->family == AF_INET6 ? 16 : sizeof(be32);
+    int len = nh->nlmsg_len - NLMSG_LENGTH(sizeof(*nd));
+
+    for (struct rtattr *rta = (struct rtattr *)((char *)nd + NLMSG_ALIGN(sizeof(*nd))); RTA_OK(rta, len); rta = RTA_NEXT(rta, len))
+    {
+        if (rta->rta_type == NDA_DST && RTA_PAYLOAD(rta) == addr_len)
+        {
+            memcpy(addr, RTA_DATA(rta), addr_len);
+            has_addr = 1;
+        }
+        else if (rta->rta_type == NDA_LLADDR && RTA_PAYLOAD(rta) == ETH_ALEN)
+        {
+            mac = RTA_DATA(rta);
+        }
+    }
+
+    if (!has_addr)
+    {
+        return;
+    }
+
+    if (!(nd->ndm_state & NL_NUD_VALID) || mac == NULL)
+    {
+        nl_cache_store(nc->family, addr, nd->ndm_ifindex, NULL, 0);
+
+        return;
+    }
+
+    // Static entries never expire, confirmed ones are trusted for a while, and ones the kernel is re-verifying only for the current resolution.
+    u64 expires = UINT64_MAX;
+
+    if (nd->ndm_state & NUD_REACHABLE)
+    {
+        expires = nc->now + NL_CACHE_TTL;
+    }
+    else if (nd->ndm_state & NL_NUD_UNSURE)
+    {
+        expires = nc->now + NL_RESOLVE_TIMEOUT;
+    }
+
+    nl_cache_store(nc->family, addr, nd->ndm_ifindex, mac, expires);
+}
+
+/**
+ * Dumps the kernel's neighbor table of an address family into the cache.
+ * 
+ * @param family The address family (AF_INET or AF_INET6).
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int nl_neigh_dump(int family)
+{
+    nl_request_t req = {0};
+    nl_neigh_ctx_t nc = {family, nl_now()};
+
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    req.nh.nlmsg_type = RTM_GETNEIGH;
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nd.ndm_family = family;
+
+    return nl_transact(&req, nl_neigh_cb, &nc);
+}
+
+/**
+ * Retrieves a neighbor's MAC address from the cache, refreshing the cache from the kernel on a miss.
+ * 
+ * @param family The address family (AF_INET or AF_INET6).
+ * @param addr The neighbor's address (4 or 16 bytes, network byte order).
+ * @param ifindex The interface the neighbor is on (0 = any).
+ * @param mac A pointer to store the MAC address in.
+ * 
+ * @return 0 on success or -1 if the kernel has no usable entry.
+**/
+int nl_neigh_lookup(int family, const void *addr, int ifindex, u8 *mac)
+{
+    u8 key[16] = {0};
+    memcpy(key, addr, family == AF_INET6 ? 16 : sizeof(be32));
+
+    if (nl_cache_get(family, key, ifindex, mac) == 0)
+    {
+        return 0;
+    }
+
+    if (nl_neigh_dump(family) != 0)
+    {
+        return -1;
+    }
+
+    return nl_cache_get(family, key, ifindex, mac);
+}
+
+/**
+ * Makes the kernel resolve a neighbor by sending it a datagram (to the discard port). This works without privileges.
+ * 
+ * @param family The address family (AF_INET or AF_INET6).
+ * @param addr The neighbor's address (4 or 16 bytes, network byte order).
+ * @param ifindex The interface the neighbor is on (needed for IPv6 link-local addresses, 0 = any).
+ * 
+ * @return Void
+**/
+static void nl_neigh_trigger(int family, const void *addr, int ifindex)
+{
+    int fd = socket(family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return;
+    }
+
+    if (family == AF_INET6)
+    {
+        struct sockaddr_in6 sin6 = {0};
+        sin6.sin6_family = AF_INET6;
+        sin6.sin6_port = htons(9);
+        sin6.sin6_scope_id = ifindex;
+        memcpy(&sin6.sin6_addr, addr, 16);
+
+        sendto(fd, "", 0, MSG_DONTWAIT, (struct sockaddr *)&sin6, sizeof(sin6));
+    }
+    else
+    {
+        struct sockaddr_in sin = {0};
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(9);
+        memcpy(&sin.sin_addr, addr, sizeof(be32));
+
+        sendto(fd, "", 0, MSG_DONTWAIT, (struct sockaddr *)&sin, sizeof(sin));
+    }
+
+    close(fd);
+}
+
+/**
+ * Resolves the MAC addresses of the next hops for multiple destinations. Resolution is triggered for missing neighbors and all of them are waited on together.
+ * 
+ * @param dsts The destination addresses (network byte order).
+ * @param count The amount of destinations.
+ * @param macs An array to store the MAC addresses in (one per destination).
+ * 
+ * @return The amount of destinations that couldn't be resolved (0 = all resolved) or -1 on failure.
+**/
+int nl_resolve_macs(const be32 *dsts, int count, u8 (*macs)[ETH_ALEN])
+{
+    be32 *hops = malloc(sizeof(be32) * (count > 0 ? count : 1));
+    int *ifindexes = malloc(sizeof(int) * (count > 0 ? count : 1));
+
+    if (hops == NULL || ifindexes == NULL)
+    {
+        free(hops);
+        free(ifindexes);
+
+        return -1;
+    }
+
+    int missing = 0;
+    int dumped = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        u8 key[16] = {0};
+
+        if (nl_route_get(dsts[i], &hops[i], &ifindexes[i]) != 0)
+        {
+            hops[i] = 0;
+            missing++;
+
+            continue;
+        }
+
+        memcpy(key, &hops[i], sizeof(be32));
+
+        if (nl_cache_get(AF_INET, key, ifindexes[i], macs[i]) == 0)
+        {
+            hops[i] = 0;
+
+            continue;
+        }
+
+        // Refresh from the kernel once for the whole batch.
+        if (!dumped)
+        {
+            nl_neigh_dump(AF_INET);
+            dumped = 1;
+        }
+
+        if (nl_cache_get(AF_INET, key, ifindexes[i], macs[i]) == 0)
+        {
+            hops[i] = 0;
+
+            continue;
+        }
+
+        nl_neigh_trigger(AF_INET, &hops[i], ifindexes[i]);
+    }
+
+    // Poll the neighbor table until every triggered neighbor resolves or we time out.
+    for (int waited = 0; waited < NL_RESOLVE_TIMEOUT; waited += 10)
+    {
+        int pending = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            if (hops[i] != 0)
+            {
+                pending = 1;
+
+                break;
+            }
+        }
+
+        if (!pending)
+        {
+            break;
+        }
+
+        struct timespec ts = {0, 10 * 1000 * 1000};
+        nanosleep(&ts, NULL);
+
+        nl_neigh_dump(AF_INET);
+
+        for (int i = 0; i < count; i++)
+        {
+            u8 key[16] = {0};
+            memcpy(key, &hops[i], sizeof(be32));
+
+            if (hops[i] != 0 && nl_cache_get(AF_INET, key, ifindexes[i], macs[i]) == 0)
+            {
+                hops[i] = 0;
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (hops[i] != 0)
+        {
+            missing++;
+        }
+    }
+
+    free(hops);
+    free(ifindexes);
+
+    return missing;
+}
+
+/**
+ * Resolves the MAC address of the next hop for a destination.
+ * 
+ * @param dst The destination address (network byte order).
+ * @param mac A pointer to store the MAC address in.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int nl_resolve_mac(be32 dst, u8 *mac)
+{
+    u8 macs[1][ETH_ALEN];
+
+    if (nl_resolve_macs(&dst, 1, macs) != 0)
+    {
+        return -1;
+    }
+
+    memcpy(mac, macs[0], ETH_ALEN);
+
+    return 0;
+}
+
+/**
+ * Resolves the MAC address of an on-link IPv6 neighbor (e.g. a link-local gateway). Resolution is triggered if the kernel has no entry yet.
+ * 
+ * @param addr The neighbor's address (16 bytes).
+ * @param ifindex The interface the neighbor is on (required for link-local addresses, 0 = any).
+ * @param mac A pointer to store the MAC address in.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int nl_resolve_mac6(const u8 *addr, int ifindex, u8 *mac)
+{
+    if (nl_neigh_lookup(AF_INET6, addr, ifindex, mac) == 0)
+    {
+        return 0;
+    }
+
+    nl_neigh_trigger(AF_INET6, addr, ifindex);
+
+    for (int waited = 0; waited < NL_RESOLVE_TIMEOUT; waited += 10)
+    {
+        struct timespec ts = {0, 10 * 1000 * 1000};
+        nanosleep(&ts, NULL);
+
+        nl_neigh_dump(AF_INET6);
+
+        if (nl_cache_get(AF_INET6, addr, ifindex, mac) == 0)
+        {
+            return 0;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <linux/if_ether.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+
+#include "simple_types.h"
+
+// Maximum amount of cached neighbor entries.
+#define NL_CACHE_SIZE 256
+
+// How long to wait for a triggered neighbor resolution (milliseconds).
+#define NL_RESOLVE_TIMEOUT 1000
+
+// How long a reachable neighbor is trusted before the kernel is asked again (milliseconds). Static entries never expire.
+#define NL_CACHE_TTL 30000
+
+typedef struct nl_request
+{
+    struct nlmsghdr nh;
+
+    union
+    {
+        struct rtmsg rt;
+        struct ndmsg nd;
+        struct ifinfomsg ifi;
+    };
+
+    char attrs[64];
+} nl_request_t;
+
+int nl_transact(nl_request_t *req, void (*cb)(struct nlmsghdr *nh, void *ctx), void *ctx);
+void nl_add_attr(nl_request_t *req, u16 type, const void *data, u16 len);
+int nl_iface_gw(int family, int oif, void *gw, int *ifindex);
+int nl_default_gw(be32 *gw, int *ifindex);
+int nl_route_get(be32 dst, be32 *next_hop, int *ifindex);
+int nl_neigh_lookup(int family, const void *addr, int ifindex, u8 *mac);
+int nl_resolve_mac(be32 dst, u8 *mac);
+int nl_resolve_macs(const be32 *dsts, int count, u8 (*macs)[ETH_ALEN]);
+int nl_resolve_mac6(const u8 *addr, int ifindex, u8 *mac);
+void nl_cache_flush();
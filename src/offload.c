@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+
+#include "offload.h"
+#include "csum.h"
+
+/**
+ * Fills out a virtio-net header so the layer-4 checksum (and optionally segmentation) is offloaded to the kernel or NIC instead of computed in software.
+ * 
+ * @param vh A pointer to the virtio-net header to fill out (sent in front of the frame with PACKET_VNET_HDR or on a tap device with IFF_VNET_HDR).
+ * @param l3 A pointer to the IPv4 or IPv6 header of the packet. The layer-4 checksum field is seeded with the pseudo header sum as CHECKSUM_PARTIAL requires.
+ * @param l2_len The length of the layer-2 header in front of the IP header (e.g. ETH_HLEN). The checksum start is relative to the start of the frame.
+ * @param gso_size The segment size for TCP/UDP segmentation offload (0 = no segmentation).
+ * 
+ * @return 0 on success or -1 if the packet can't be offloaded (not TCP or UDP, or IPv6 extension headers) and the checksum must be computed in software.
+**/
+int build_vnet_hdr(struct virtio_net_hdr *vh, void *l3, u16 l2_len, u16 gso_size)
+{
+    u8 *pkt = l3;
+    u8 proto;
+    u16 l3_len;
+    u16 l4_len;
+    u8 *l4;
+
+    memset(vh, 0, sizeof(*vh));
+
+    if ((pkt[0] >> 4) == 4)
+    {
+        struct iphdr *iph = l3;
+
+        proto = iph->protocol;
+        l3_len = iph->ihl * 4;
+        l4_len = ntohs(iph->tot_len) - l3_len;
+    }
+    else if ((pkt[0] >> 4) == 6)
+    {
+        struct ipv6hdr *ip6h = l3;
+
+        proto = ip6h->nexthdr;
+        l3_len = sizeof(*ip6h);
+        l4_len = ntohs(ip6h->payload_len);
+    }
+    else
+    {
+        return -1;
+    }
+
+    l4 = pkt + l3_len;
+
+    u16 check_off;
+    u8 gso_type;
+
+    switch (proto)
+    {
+        case IPPROTO_TCP:
+            check_off = CSUM_TCP_CHECK_OFF;
+            gso_type = (pkt[0] >> 4) == 4 ? VIRTIO_NET_HDR_GSO_TCPV4 : VIRTIO_NET_HDR_GSO_TCPV6;
+
+            break;
+
+        case IPPROTO_UDP:
+            check_off = CSUM_UDP_CHECK_OFF;
+            gso_type = VIRTIO_NET_HDR_GSO_UDP_L4;
+
+            break;
+
+        default:
+            return -1;
+    }
+
+    // Seed the checksum field with the folded (non-inverted) pseudo header sum.
+    __sum16 seed;
+
+    if ((pkt[0] >> 4) == 4)
+    {
+        struct iphdr *iph = l3;
+
+        seed = ~csum_tcpudp_magic(iph->saddr, iph->daddr, l4_len, proto, 0);
+    }
+    else
+    {
+        struct ipv6hdr *ip6h = l3;
+
+        seed = ~csum_ipv6_magic(&ip6h->saddr, &ip6h->daddr, l4_len, proto, 0);
+    }
+
+    memcpy(l4 + check_off, &seed, sizeof(seed));
+
+    vh->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+    vh->csum_start = l2_len + l3_len;
+    vh->csum_offset = check_off;
+
+    if (gso_size > 0)
+    {
+        u16 l4_hdr_len = proto == IPPROTO_TCP ? (l4[12] >> 4) * 4 : 8;
+
+        vh->gso_type = gso_type;
+        vh->gso_size = gso_size;
+        vh->hdr_len = l2_len + l3_len + l4_hdr_len;
+    }
+
+    return 0;
+}
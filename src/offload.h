@@ -0,0 +1,12 @@
+#pragma once
+
+#include <linux/virtio_net.h>
+
+#include "simple_types.h"
+
+// UDP segmentation offload (not defined by older kernel headers).
+#ifndef VIRTIO_NET_HDR_GSO_UDP_L4
+#define VIRTIO_NET_HDR_GSO_UDP_L4 5
+#endif
+
+int build_vnet_hdr(struct virtio_net_hdr *vh, void *l3, u16 l2_len, u16 gso_size);
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "payload.h"
+#include "decode.h"
+#include "csum.h"
+
+/**
+ * Decodes a static payload's exact string (or file) into the config's payload store and retrieves its partial checksum.
+ * 
+ * @param store A pointer to the payload store (see pl_store.h).
+ * @param pl A pointer to the payload.
+ * 
+ * @return 0 on success, 1 if there's nothing to decode (not static or no exact string), or -1 on failure.
+ * 
+ * @note Payload files are mapped once and string payloads from files are used in place. Identical payloads share one copy and checksum.
+ * @note The partial sum in `pl->data_csum` may be passed as the initial sum to csum_partial() over the layer-4 header, so per-packet layer-4 checksums only cover headers.
+**/
+int load_payload(pl_store_t *store, payload_opt_t *pl)
+{
+    // Drop data decoded earlier even when there's nothing to decode now (e.g. --pstatic 0 on a static payload).
+    free_payload(pl);
+
+    if (!pl->is_static || pl->exact == NULL)
+    {
+        return 1;
+    }
+
+    const u8 *src = (const u8 *)pl->exact;
+    size_t src_len = strlen(pl->exact);
+
+    if (pl->is_file)
+    {
+        src = pl_store_map_file(store, pl->exact, &src_len);
+
+        if (src == NULL)
+        {
+            fprintf(stderr, "Failed to read payload file '%s'.\n", pl->exact);
+
+            return -1;
+        }
+    }
+
+    const u8 *data;
+
+    if (pl->is_string && pl->is_escaped)
+    {
+        // Escapes only ever shorten the string.
+        u8 *buf = malloc(src_len ? src_len : 1);
+
+        if (buf == NULL)
+        {
+            return -1;
+        }
+
+        long len = decode_escapes((const char *)src, src_len, buf, src_len);
+
+        if (len < 0)
+        {
+            fprintf(stderr, "Failed to decode escape sequences in payload '%s'.\n", pl->exact);
+
+            free(buf);
+
+            return -1;
+        }
+
+        data = pl_store_add(store, buf, len, &pl->data_csum);
+
+        free(buf);
+
+        if (data == NULL)
+        {
+            return -1;
+        }
+
+        pl->data_len = len;
+    }
+    else if (pl->is_string)
+    {
+        data = pl->is_file ? pl_store_add_mapped(store, src, src_len, &pl->data_csum) : pl_store_add(store, src, src_len, &pl->data_csum);
+
+        if (data == NULL)
+        {
+            return -1;
+        }
+
+        pl->data_len = src_len;
+    }
+    else
+    {
+        // Hex is at least two characters per byte.
+        u8 *buf = malloc(src_len / 2 + 1);
+
+        if (buf == NULL)
+        {
+            return -1;
+        }
+
+        long len = decode_hex((const char *)src, src_len, buf, src_len / 2 + 1);
+
+        if (len < 0)
+        {
+            fprintf(stderr, "Failed to decode hexadecimal payload '%s'.\n", pl->exact);
+
+            free(buf);
+
+            return -1;
+        }
+
+        data = pl_store_add(store, buf, len, &pl->data_csum);
+
+        free(buf);
+
+        if (data == NULL)
+        {
+            return -1;
+        }
+
+        pl->data_len = len;
+    }
+
+    pl->data = data;
+
+    return 0;
+}
+
+/**
+ * Releases a payload's decoded bytes (the bytes themselves belong to the payload store or a mapped config cache).
+ * 
+ * @param pl A pointer to the payload.
+ * 
+ * @return Void
+**/
+void free_payload(payload_opt_t *pl)
+{
+    pl->data = NULL;
+    pl->data_len = 0;
+    pl->data_csum = 0;
+}
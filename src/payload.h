@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "simple_types.h"
+#include "config.h"
+#include "pl_store.h"
+
+int load_payload(pl_store_t *store, payload_opt_t *pl);
+void free_payload(payload_opt_t *pl);
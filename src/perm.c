@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+
+#include "perm.h"
+
+/**
+ * Mixes a value with a key (the Feistel round function).
+ * 
+ * @param x The value.
+ * @param key The round key.
+ * 
+ * @return The mixed value.
+**/
+static inline u64 perm_round(u64 x, u64 key)
+{
+    x ^= key;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 31;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 29;
+
+    return x;
+}
+
+/**
+ * Initializes a permutation over every address of a compiled range table (and optionally every port of a port range).
+ * 
+ * @param perm A pointer to the permutation to initialize.
+ * @param tbl A pointer to the compiled range table. Must stay valid while the permutation is used.
+ * @param port_min The minimum port (ignored if port_max is 0).
+ * @param port_max The maximum port (0 = don't permute ports).
+ * @param key The key that selects the order. Different keys give different orders.
+ * 
+ * @return 0 on success or -1 on failure (empty table or allocation failure).
+ * 
+ * @note Overlapping ranges are visited once per range they appear in.
+**/
+int perm_init(perm_t *perm, const range_table_t *tbl, u16 port_min, u16 port_max, u64 key)
+{
+    memset(perm, 0, sizeof(*perm));
+
+    if (tbl == NULL || tbl->count < 1)
+    {
+        return -1;
+    }
+
+    perm->offsets = malloc(sizeof(u64) * (tbl->count + 1));
+
+    if (perm->offsets == NULL)
+    {
+        return -1;
+    }
+
+    perm->tbl = tbl;
+
+    for (u16 i = 0; i < tbl->count; i++)
+    {
+        perm->offsets[i] = perm->addr_count;
+        perm->addr_count += (u64)tbl->entries[i].mask + 1;
+    }
+
+    perm->offsets[tbl->count] = perm->addr_count;
+
+    perm->port_min = port_min;
+    perm->port_count = (port_max > 0 && port_max >= port_min) ? (u32)(port_max - port_min) + 1 : 1;
+    perm->size = perm->addr_count * perm->port_count;
+
+    // Smallest even bit width that covers the domain.
+    perm->half_bits = 1;
+
+    while (perm->half_bits < 32 && (1ULL << (perm->half_bits * 2)) < perm->size)
+    {
+        perm->half_bits++;
+    }
+
+    perm->half_mask = (1ULL << perm->half_bits) - 1;
+
+    for (int i = 0; i < PERM_ROUNDS; i++)
+    {
+        perm->keys[i] = perm_round(key + i, 0x9e3779b97f4a7c15ULL);
+    }
+
+    return 0;
+}
+
+/**
+ * Frees a permutation.
+ * 
+ * @param perm A pointer to the permutation.
+ * 
+ * @return Void
+**/
+void perm_free(perm_t *perm)
+{
+    if (perm->offsets != NULL)
+    {
+        free(perm->offsets);
+    }
+
+    perm->offsets = NULL;
+}
+
+/**
+ * Maps an index to its position in the permutation. Every index in [0, size) maps to a distinct value in [0, size).
+ * 
+ * @param perm A pointer to the permutation.
+ * @param i The index (below perm->size).
+ * 
+ * @return The permuted index.
+ * 
+ * @note The order only depends on the permutation's key, so every pass repeats it and thread slices stay disjoint even when threads are in different passes.
+**/
+u64 perm_index(const perm_t *perm, u64 i)
+{
+    // Cycle walk until the Feistel output lands inside the domain (less than four steps on average).
+    do
+    {
+        u64 l = i >> perm->half_bits;
+        u64 r = i & perm->half_mask;
+
+        for (int k = 0; k < PERM_ROUNDS; k++)
+        {
+            u64 t = l ^ (perm_round(r, perm->keys[k]) & perm->half_mask);
+
+            l = r;
+            r = t;
+        }
+
+        i = (l << perm->half_bits) | r;
+    } while (i >= perm->size);
+
+    return i;
+}
+
+/**
+ * Initializes a thread's cursor. Threads take contiguous, non-overlapping slices of the index space so together they cover the whole domain without coordinating.
+ * 
+ * @param perm A pointer to the permutation.
+ * @param cur A pointer to the cursor to initialize.
+ * @param thread The thread's number (0 to threads - 1).
+ * @param threads The total number of threads.
+ * 
+ * @return Void
+**/
+void perm_cursor_init(const perm_t *perm, perm_cursor_t *cur, u32 thread, u32 threads)
+{
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+
+    cur->start = (u64)(((u128)perm->size * thread) / threads);
+    cur->end = (u64)(((u128)perm->size * (thread + 1)) / threads);
+    cur->next = cur->start;
+    cur->pass = 0;
+}
+
+/**
+ * Retrieves the next address (and port) of a thread's slice of the permutation.
+ * 
+ * @param perm A pointer to the permutation.
+ * @param cur A pointer to the thread's cursor.
+ * @param addr A pointer to store the address in (network byte order).
+ * @param port A pointer to store the port in (network byte order, may be NULL).
+ * 
+ * @return 1 if this call wrapped the slice (a pass completed) or 0 otherwise. Returns -1 if the thread's slice is empty.
+ * 
+ * @note Each pass revisits the slice in the same order. Use a permutation with another key for a different order (every thread has to switch at once).
+**/
+int perm_next(const perm_t *perm, perm_cursor_t *cur, be32 *addr, be16 *port)
+{
+    int wrapped = 0;
+
+    if (cur->start >= cur->end)
+    {
+        return -1;
+    }
+
+    if (cur->next >= cur->end)
+    {
+        cur->next = cur->start;
+        cur->pass++;
+
+        wrapped = 1;
+    }
+
+    u64 v = perm_index(perm, cur->next++);
+
+    u64 addr_idx = v / perm->port_count;
+    u32 port_idx = v % perm->port_count;
+
+    // Find the range holding the address (ranges are few, so a binary search over the offsets is cheap).
+    u16 lo = 0;
+    u16 hi = perm->tbl->count - 1;
+
+    while (lo < hi)
+    {
+        u16 mid = (lo + hi + 1) / 2;
+
+        if (perm->offsets[mid] <= addr_idx)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    const ip_range_t *range = &perm->tbl->entries[lo];
+
+    *addr = htonl(range->base + (u32)(addr_idx - perm->offsets[lo]));
+
+    if (port != NULL)
+    {
+        *port = htons((u16)(perm->port_min + port_idx));
+    }
+
+    return wrapped;
+}
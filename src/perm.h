@@ -0,0 +1,40 @@
+#pragma once
+
+#include "simple_types.h"
+#include "ranges.h"
+
+#define PERM_ROUNDS 4
+
+typedef struct perm
+{
+    // Compiled ranges and the number of addresses before each entry (count + 1 values).
+    const range_table_t *tbl;
+    u64 *offsets;
+    u64 addr_count;
+
+    // Optional port range (port_count is 1 when ports aren't permuted).
+    u16 port_min;
+    u32 port_count;
+
+    // Size of the permuted domain (addresses x ports).
+    u64 size;
+
+    // Feistel network over 2 * half_bits bits.
+    int half_bits;
+    u64 half_mask;
+    u64 keys[PERM_ROUNDS];
+} perm_t;
+
+typedef struct perm_cursor
+{
+    u64 start;
+    u64 next;
+    u64 end;
+    u64 pass;
+} perm_cursor_t;
+
+int perm_init(perm_t *perm, const range_table_t *tbl, u16 port_min, u16 port_max, u64 key);
+void perm_free(perm_t *perm);
+u64 perm_index(const perm_t *perm, u64 i);
+void perm_cursor_init(const perm_t *perm, perm_cursor_t *cur, u32 thread, u32 threads);
+int perm_next(const perm_t *perm, perm_cursor_t *cur, be32 *addr, be16 *port);
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "pl_pool.h"
+#include "prng.h"
+#include "csum.h"
+
+/**
+ * Maps memory for a pool, backed by huge pages when available.
+ * 
+ * @param len The amount of memory (rounded up to PL_POOL_HUGE_PAGE).
+ * @param huge A pointer to store whether explicit huge pages were used in.
+ * 
+ * @return A pointer to the memory or NULL on failure.
+**/
+static void *pl_pool_map(size_t len, u8 *huge)
+{
+    void *mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (mem != MAP_FAILED)
+    {
+        *huge = 1;
+
+        return mem;
+    }
+
+    // No reserved huge pages, so ask for transparent ones instead.
+    mem = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (mem == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    madvise(mem, len, MADV_HUGEPAGE);
+
+    *huge = 0;
+
+    return mem;
+}
+
+/**
+ * Pregenerates a pool of random payloads with random lengths and their partial checksums. Senders cycle through the pool instead of generating payloads per packet.
+ * 
+ * @param count The amount of payloads (rounded up to a power of two).
+ * @param min_len The minimum payload length.
+ * @param max_len The maximum payload length.
+ * @param seed The seed for the payloads and lengths.
+ * 
+ * @return A pointer to the pool or NULL on failure (including pools that could exceed PL_POOL_MAX_BYTES).
+ * 
+ * @note Payloads start on a cache line and the pool is read-only once generated.
+**/
+pl_pool_t *pl_pool_create(u32 count, u16 min_len, u16 max_len, u64 seed)
+{
+    if (count < 1 || count > PL_POOL_MAX_COUNT)
+    {
+        fprintf(stderr, "Invalid payload pool size %u (1 - %u).\n", count, PL_POOL_MAX_COUNT);
+
+        return NULL;
+    }
+
+    if (max_len < min_len)
+    {
+        max_len = min_len;
+    }
+
+    u32 cnt = 1;
+
+    while (cnt < count)
+    {
+        cnt <<= 1;
+    }
+
+    size_t ents_len = (sizeof(pl_pool_ent_t) * cnt + 63) & ~(size_t)63;
+
+    // Every payload is generated while the plan compiles (and again on each reload), so bound the worst case up front.
+    if (ents_len + (u64)cnt * (((u64)max_len + 63) & ~63ULL) > PL_POOL_MAX_BYTES)
+    {
+        fprintf(stderr, "Payload pool of %u payloads up to %u bytes exceeds the %llu MB limit (lower the pool size or maximum length).\n", cnt, max_len, PL_POOL_MAX_BYTES >> 20);
+
+        return NULL;
+    }
+
+    prng_t prng;
+    prng_seed(&prng, seed);
+
+    // Pick lengths first to size the mapping exactly.
+    u16 *lens = malloc(sizeof(u16) * cnt);
+
+    if (lens == NULL)
+    {
+        return NULL;
+    }
+
+    size_t data_len = 0;
+
+    for (u32 i = 0; i < cnt; i++)
+    {
+        lens[i] = min_len + prng_bounded(&prng, (u32)max_len - min_len + 1);
+
+        data_len += ((size_t)lens[i] + 63) & ~(size_t)63;
+    }
+
+    pl_pool_t *pool = calloc(1, sizeof(*pool));
+
+    if (pool == NULL)
+    {
+        free(lens);
+
+        return NULL;
+    }
+
+    pool->mem_len = (ents_len + data_len + PL_POOL_HUGE_PAGE - 1) & ~(size_t)(PL_POOL_HUGE_PAGE - 1);
+    pool->mem = pl_pool_map(pool->mem_len, &pool->huge);
+
+    if (pool->mem == NULL)
+    {
+        fprintf(stderr, "Failed to map %zu bytes for a payload pool.\n", pool->mem_len);
+
+        free(lens);
+        free(pool);
+
+        return NULL;
+    }
+
+    pl_pool_ent_t *ents = pool->mem;
+    u8 *data = (u8 *)pool->mem + ents_len;
+
+    // One bulk fill covers every payload (and the padding between them).
+    prng_fill_u8(&prng, data, data_len, 0, UINT8_MAX);
+
+    for (u32 i = 0; i < cnt; i++)
+    {
+        ents[i].data = data;
+        ents[i].len = lens[i];
+        ents[i].csum = csum_partial(data, lens[i], 0);
+
+        data += ((size_t)lens[i] + 63) & ~(size_t)63;
+    }
+
+    free(lens);
+
+    if (mprotect(pool->mem, pool->mem_len, PROT_READ) != 0)
+    {
+        fprintf(stderr, "Failed to make payload pool read-only (%s).\n", strerror(errno));
+
+        munmap(pool->mem, pool->mem_len);
+        free(pool);
+
+        return NULL;
+    }
+
+    pool->ents = ents;
+    pool->count = cnt;
+    pool->mask = cnt - 1;
+
+    return pool;
+}
+
+/**
+ * Initializes a thread's cursor. Each thread starts at its own offset and walks the ring with its own odd stride, so threads cover every payload without sending the same sequence in lockstep.
+ * 
+ * @param pool A pointer to the pool.
+ * @param cur A pointer to the cursor.
+ * @param thread The thread's index.
+ * @param threads The amount of threads.
+ * 
+ * @return Void
+**/
+void pl_pool_cursor(const pl_pool_t *pool, pl_cursor_t *cur, int thread, int threads)
+{
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+
+    cur->idx = (u32)(((u64)pool->count * (thread % threads)) / threads) & pool->mask;
+
+    // Odd strides are coprime with the power of two count, so every entry is visited.
+    cur->step = ((u32)thread * 2 + 1) & pool->mask;
+
+    if (cur->step == 0)
+    {
+        cur->step = 1;
+    }
+}
+
+/**
+ * Frees a payload pool.
+ * 
+ * @param pool A pointer to the pool (may be NULL).
+ * 
+ * @return Void
+**/
+void pl_pool_free(pl_pool_t *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    munmap(pool->mem, pool->mem_len);
+
+    free(pool);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "simple_types.h"
+
+// Huge page size pools are rounded up to.
+#define PL_POOL_HUGE_PAGE (2 * 1024 * 1024)
+
+// Maximum amount of payloads in a pool.
+#define PL_POOL_MAX_COUNT (1 << 20)
+
+// Maximum memory a pool may use (payloads at their maximum length, padded to cache lines).
+#define PL_POOL_MAX_BYTES (1ULL << 30)
+
+typedef struct pl_pool_ent
+{
+    const u8 *data;
+    u32 len;
+
+    // Partial checksum of the payload (see csum_partial()).
+    u32 csum;
+} pl_pool_ent_t;
+
+typedef struct pl_pool
+{
+    // Entries (power of two count) and the payloads they point into (one mapping).
+    const pl_pool_ent_t *ents;
+    u32 count;
+    u32 mask;
+
+    void *mem;
+    size_t mem_len;
+    u8 huge;
+
+    // Pools owned by a config (freed with free_config()).
+    struct pl_pool *next;
+} pl_pool_t;
+
+typedef struct pl_cursor
+{
+    u32 idx;
+    u32 step;
+} pl_cursor_t;
+
+pl_pool_t *pl_pool_create(u32 count, u16 min_len, u16 max_len, u64 seed);
+void pl_pool_cursor(const pl_pool_t *pool, pl_cursor_t *cur, int thread, int threads);
+void pl_pool_free(pl_pool_t *pool);
+
+/**
+ * Retrieves a thread's next payload from a pool.
+ * 
+ * @param pool A pointer to the pool.
+ * @param cur A pointer to the thread's cursor (see pl_pool_cursor()).
+ * 
+ * @return A pointer to the payload's entry.
+**/
+static inline const pl_pool_ent_t *pl_pool_next(const pl_pool_t *pool, pl_cursor_t *cur)
+{
+    const pl_pool_ent_t *ent = &pool->ents[cur->idx];
+
+    cur->idx = (cur->idx + cur->step) & pool->mask;
+
+    return ent;
+}
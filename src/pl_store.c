@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "pl_store.h"
+#include "hash.h"
+#include "csum.h"
+
+// Chunk header size (payloads start on a cache line).
+#define PL_CHUNK_HDR ((sizeof(pl_chunk_t) + 63) & ~(size_t)63)
+
+/**
+ * Allocates 64-byte aligned room for a payload from the store's chunks.
+ * 
+ * @param store A pointer to the store.
+ * @param len The payload length.
+ * 
+ * @return A pointer to the room or NULL on failure.
+**/
+static u8 *pl_store_alloc(pl_store_t *store, size_t len)
+{
+    pl_chunk_t *chunk = store->chunks;
+
+    if (chunk != NULL && !chunk->sealed)
+    {
+        size_t off = (chunk->used + 63) & ~(size_t)63;
+
+        if (off + len <= chunk->size)
+        {
+            chunk->used = off + len;
+
+            return (u8 *)chunk + off;
+        }
+    }
+
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = PL_CHUNK_HDR + len > PL_STORE_CHUNK_SIZE ? (PL_CHUNK_HDR + len + page - 1) & ~(page - 1) : PL_STORE_CHUNK_SIZE;
+
+    // Mapped so it can be sealed read-only; untouched pages cost nothing.
+    chunk = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (chunk == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    chunk->size = size;
+    chunk->used = PL_CHUNK_HDR + len;
+    chunk->sealed = 0;
+    chunk->next = store->chunks;
+    store->chunks = chunk;
+
+    return (u8 *)chunk + PL_CHUNK_HDR;
+}
+
+/**
+ * Looks up a payload by content and inserts it if it isn't stored yet.
+ * 
+ * @param store A pointer to the store.
+ * @param data The payload.
+ * @param len The payload length.
+ * @param csum A pointer to store the payload's partial checksum in.
+ * @param copy Whether to copy new payloads into the store or reference them in place.
+ * 
+ * @return A pointer to the stored payload or NULL on failure.
+**/
+static const u8 *pl_store_insert(pl_store_t *store, const u8 *data, size_t len, u32 *csum, int copy)
+{
+    if (len > UINT32_MAX)
+    {
+        return NULL;
+    }
+
+    u64 hash = hash64(data, len, 0);
+
+    // Keep chains short (at most one entry per slot on average).
+    if (store->entry_cnt >= store->slot_cnt)
+    {
+        u32 cnt = store->slot_cnt ? store->slot_cnt * 2 : 256;
+        pl_entry_t **slots = calloc(cnt, sizeof(pl_entry_t *));
+
+        if (slots == NULL)
+        {
+            return NULL;
+        }
+
+        for (u32 i = 0; i < store->slot_cnt; i++)
+        {
+            pl_entry_t *ent = store->slots[i];
+
+            while (ent != NULL)
+            {
+                pl_entry_t *next = ent->next;
+
+                ent->next = slots[ent->hash & (cnt - 1)];
+                slots[ent->hash & (cnt - 1)] = ent;
+
+                ent = next;
+            }
+        }
+
+        free(store->slots);
+
+        store->slots = slots;
+        store->slot_cnt = cnt;
+    }
+
+    pl_entry_t **slot = &store->slots[hash & (store->slot_cnt - 1)];
+
+    for (pl_entry_t *ent = *slot; ent != NULL; ent = ent->next)
+    {
+        if (ent->hash == hash && ent->len == len && memcmp(ent->data, data, len) == 0)
+        {
+            *csum = ent->csum;
+
+            return ent->data;
+        }
+    }
+
+    pl_entry_t *ent = malloc(sizeof(*ent));
+
+    if (ent == NULL)
+    {
+        return NULL;
+    }
+
+    if (copy)
+    {
+        u8 *room = pl_store_alloc(store, len);
+
+        if (room == NULL)
+        {
+            free(ent);
+
+            return NULL;
+        }
+
+        memcpy(room, data, len);
+
+        data = room;
+    }
+
+    ent->hash = hash;
+    ent->len = len;
+    ent->csum = csum_partial(data, len, 0);
+    ent->data = data;
+    ent->next = *slot;
+
+    *slot = ent;
+    store->entry_cnt++;
+
+    *csum = ent->csum;
+
+    return data;
+}
+
+/**
+ * Adds a payload to the store unless an identical one is already stored. Its partial checksum is computed once per distinct payload.
+ * 
+ * @param store A pointer to the store.
+ * @param data The payload.
+ * @param len The payload length.
+ * @param csum A pointer to store the payload's partial checksum in (see csum_partial()).
+ * 
+ * @return A pointer to the stored (64-byte aligned, read-only once sealed) payload or NULL on failure.
+**/
+const u8 *pl_store_add(pl_store_t *store, const u8 *data, size_t len, u32 *csum)
+{
+    return pl_store_insert(store, data, len, csum, 1);
+}
+
+/**
+ * Adds a payload that lives in a mapped payload file without copying it (see pl_store_map_file()). Identical payloads already stored are returned instead.
+ * 
+ * @param store A pointer to the store.
+ * @param data The payload (must stay mapped as long as the store).
+ * @param len The payload length.
+ * @param csum A pointer to store the payload's partial checksum in.
+ * 
+ * @return A pointer to the stored payload or NULL on failure.
+**/
+const u8 *pl_store_add_mapped(pl_store_t *store, const u8 *data, size_t len, u32 *csum)
+{
+    return pl_store_insert(store, data, len, csum, 0);
+}
+
+/**
+ * Maps a payload file read-only. Each file is mapped once no matter how many payloads use it.
+ * 
+ * @param store A pointer to the store.
+ * @param path The file's path.
+ * @param len A pointer to store the file's length in.
+ * 
+ * @return A pointer to the file's contents (page-aligned) or NULL on failure.
+ * 
+ * @note Empty files return a pointer to an empty string.
+**/
+const u8 *pl_store_map_file(pl_store_t *store, const char *path, size_t *len)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+
+        return NULL;
+    }
+
+    for (pl_file_t *file = store->files; file != NULL; file = file->next)
+    {
+        if (file->dev == st.st_dev && file->ino == st.st_ino)
+        {
+            close(fd);
+
+            *len = file->len;
+
+            return file->data;
+        }
+    }
+
+    pl_file_t *file = malloc(sizeof(*file));
+
+    if (file == NULL)
+    {
+        close(fd);
+
+        return NULL;
+    }
+
+    file->dev = st.st_dev;
+    file->ino = st.st_ino;
+    file->len = st.st_size;
+    file->data = (const u8 *)"";
+
+    if (file->len > 0)
+    {
+        void *data = mmap(NULL, file->len, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            free(file);
+
+            return NULL;
+        }
+
+        file->data = data;
+    }
+
+    close(fd);
+
+    file->next = store->files;
+    store->files = file;
+
+    *len = file->len;
+
+    return file->data;
+}
+
+/**
+ * Makes every payload added so far read-only. Payloads added later go into new chunks.
+ * 
+ * @param store A pointer to the store.
+ * 
+ * @return Void
+**/
+void pl_store_seal(pl_store_t *store)
+{
+    for (pl_chunk_t *chunk = store->chunks; chunk != NULL && !chunk->sealed; chunk = chunk->next)
+    {
+        chunk->sealed = 1;
+
+        mprotect(chunk, chunk->size, PROT_READ);
+    }
+}
+
+/**
+ * Frees the store along with every payload and mapped file.
+ * 
+ * @param store A pointer to the store.
+ * 
+ * @return Void
+**/
+void pl_store_free(pl_store_t *store)
+{
+    for (u32 i = 0; i < store->slot_cnt; i++)
+    {
+        pl_entry_t *ent = store->slots[i];
+
+        while (ent != NULL)
+        {
+            pl_entry_t *next = ent->next;
+
+            free(ent);
+
+            ent = next;
+        }
+    }
+
+    free(store->slots);
+
+    while (store->chunks != NULL)
+    {
+        pl_chunk_t *chunk = store->chunks;
+
+        store->chunks = chunk->next;
+
+        munmap(chunk, chunk->size);
+    }
+
+    while (store->files != NULL)
+    {
+        pl_file_t *file = store->files;
+
+        store->files = file->next;
+
+        if (file->len > 0)
+        {
+            munmap((void *)file->data, file->len);
+        }
+
+        free(file);
+    }
+
+    memset(store, 0, sizeof(*store));
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "simple_types.h"
+
+// Size of each store chunk (larger payloads get a chunk of their own).
+#define PL_STORE_CHUNK_SIZE (2 * 1024 * 1024)
+
+typedef struct pl_entry
+{
+    u64 hash;
+    u32 len;
+    u32 csum;
+    const u8 *data;
+    struct pl_entry *next;
+} pl_entry_t;
+
+typedef struct pl_chunk
+{
+    struct pl_chunk *next;
+    size_t size;
+    size_t used;
+    u8 sealed;
+} pl_chunk_t;
+
+typedef struct pl_file
+{
+    dev_t dev;
+    ino_t ino;
+    const u8 *data;
+    size_t len;
+    struct pl_file *next;
+} pl_file_t;
+
+typedef struct pl_store
+{
+    // Entries by content hash (chained).
+    pl_entry_t **slots;
+    u32 slot_cnt;
+    u32 entry_cnt;
+
+    // Page-aligned chunks holding the payloads (made read-only by pl_store_seal()).
+    pl_chunk_t *chunks;
+
+    // Mapped payload files (by device and inode).
+    pl_file_t *files;
+} pl_store_t;
+
+const u8 *pl_store_add(pl_store_t *store, const u8 *data, size_t len, u32 *csum);
+const u8 *pl_store_add_mapped(pl_store_t *store, const u8 *data, size_t len, u32 *csum);
+const u8 *pl_store_map_file(pl_store_t *store, const char *path, size_t *len);
+void pl_store_seal(pl_store_t *store);
+void pl_store_free(pl_store_t *store);
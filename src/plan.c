@@ -0,0 +1,401 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "plan.h"
+#include "iface.h"
+#include "prng.h"
+
+/**
+ * Parses a MAC address string (e.g. "AA:BB:CC:DD:EE:FF").
+ * 
+ * @param str The MAC address string.
+ * @param mac A pointer to store the MAC address in.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int parse_mac(const char *str, u8 *mac)
+{
+    char extra;
+
+    if (sscanf(str, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx%c", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5], &extra) != 6)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Parses a protocol name.
+ * 
+ * @param protocol The protocol name (case-insensitive).
+ * 
+ * @return The IP protocol number or -1 if unsupported.
+**/
+static int parse_protocol(const char *protocol)
+{
+    if (protocol == NULL)
+    {
+        return -1;
+    }
+
+    if (strcasecmp(protocol, "udp") == 0)
+    {
+        return IPPROTO_UDP;
+    }
+
+    if (strcasecmp(protocol, "tcp") == 0)
+    {
+        return IPPROTO_TCP;
+    }
+
+    if (strcasecmp(protocol, "icmp") == 0)
+    {
+        return IPPROTO_ICMP;
+    }
+
+    return -1;
+}
+
+/**
+ * Compiles a single sequence into its hot and cold plan.
+ * 
+ * @param cfg A pointer to the config structure.
+ * @param idx The sequence's index.
+ * @param hot A pointer to the hot plan to fill out.
+ * @param cold A pointer to the cold plan to fill out.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int compile_sequence(config_t *cfg, int idx, seq_plan_t *hot, seq_plan_cold_t *cold)
+{
+    sequence_t *seq = &cfg->seq[idx];
+
+    cold->interface = seq->interface ? seq->interface : cfg->interface;
+    cold->cpus = seq->cpus;
+    cold->numa = seq->numa;
+
+    const iface_t *iface = iface_get(cold->interface);
+
+    cold->ifindex = iface ? iface->ifindex : 0;
+
+    // Protocol.
+    int proto = parse_protocol(seq->ip.protocol);
+
+    if (proto < 0)
+    {
+        fprintf(stderr, "Invalid protocol '%s' in sequence #%d.\n", seq->ip.protocol ? seq->ip.protocol : "N/A", idx);
+
+        return -1;
+    }
+
+    hot->proto = proto;
+
+    // Flags.
+    hot->flags = (seq->ip.is_ipv6 ? PLAN_F_IPV6 : 0) | (seq->ip.csum ? PLAN_F_L3_CSUM : 0) | (seq->l4_csum ? PLAN_F_L4_CSUM : 0) |
+                 (seq->csum_offload ? PLAN_F_CSUM_OFFLOAD : 0) | (seq->block ? PLAN_F_BLOCK : 0) | (seq->track ? PLAN_F_TRACK : 0) |
+                 (seq->tcp.cooked ? PLAN_F_TCP_COOKED : 0) | (seq->tcp.one_connection ? PLAN_F_TCP_ONE_CONN : 0);
+
+    // IP header fields.
+    hot->tos = seq->ip.tos;
+    hot->min_ttl = seq->ip.min_ttl;
+    hot->max_ttl = seq->ip.max_ttl;
+    hot->min_id = seq->ip.min_id;
+    hot->max_id = seq->ip.max_id;
+
+    // Layer-4 fields.
+    switch (proto)
+    {
+        case IPPROTO_UDP:
+            hot->src_port = seq->udp.src_port;
+            hot->dst_port = seq->udp.dst_port;
+
+            break;
+
+        case IPPROTO_TCP:
+            hot->src_port = seq->tcp.src_port;
+            hot->dst_port = seq->tcp.dst_port;
+
+            hot->tcp_flags = (seq->tcp.fin ? PLAN_TCP_FIN : 0) | (seq->tcp.syn ? PLAN_TCP_SYN : 0) | (seq->tcp.rst ? PLAN_TCP_RST : 0) | (seq->tcp.psh ? PLAN_TCP_PSH : 0) |
+                             (seq->tcp.ack ? PLAN_TCP_ACK : 0) | (seq->tcp.urg ? PLAN_TCP_URG : 0) | (seq->tcp.ece ? PLAN_TCP_ECE : 0) | (seq->tcp.cwr ? PLAN_TCP_CWR : 0);
+
+            break;
+
+        case IPPROTO_ICMP:
+            hot->icmp_type = seq->icmp.type;
+            hot->icmp_code = seq->icmp.code;
+
+            break;
+    }
+
+    hot->gso_size = seq->gso_size;
+
+    // MAC addresses (falling back to the interface's MAC and the default gateway's).
+    if (seq->eth.src_mac != NULL)
+    {
+        if (parse_mac(seq->eth.src_mac, hot->src_mac) != 0)
+        {
+            fprintf(stderr, "Invalid source MAC '%s' in sequence #%d.\n", seq->eth.src_mac, idx);
+
+            return -1;
+        }
+    }
+    else if (iface != NULL)
+    {
+        memcpy(hot->src_mac, iface->mac, ETH_ALEN);
+    }
+
+    if (seq->eth.dst_mac != NULL)
+    {
+        if (parse_mac(seq->eth.dst_mac, hot->dst_mac) != 0)
+        {
+            fprintf(stderr, "Invalid destination MAC '%s' in sequence #%d.\n", seq->eth.dst_mac, idx);
+
+            return -1;
+        }
+    }
+    else if (get_gw_mac(hot->dst_mac, cold->ifindex, seq->ip.is_ipv6 ? AF_INET6 : AF_INET) != 0)
+    {
+        fprintf(stderr, "Failed to resolve the %s default gateway's MAC on '%s' in sequence #%d (set a destination MAC instead).\n", seq->ip.is_ipv6 ? "IPv6" : "IPv4", cold->interface ? cold->interface : "N/A", idx);
+
+        return -1;
+    }
+
+    // Addresses.
+    if (seq->ip.is_ipv6)
+    {
+        if (seq->ip.dst_ip == NULL || inet_pton(AF_INET6, seq->ip.dst_ip, hot->dst_ip6) != 1)
+        {
+            fprintf(stderr, "Invalid destination IP '%s' in sequence #%d.\n", seq->ip.dst_ip ? seq->ip.dst_ip : "N/A", idx);
+
+            return -1;
+        }
+
+        if (seq->ip.src_ip != NULL && inet_pton(AF_INET6, seq->ip.src_ip, hot->src_ip6) != 1)
+        {
+            fprintf(stderr, "Invalid source IP '%s' in sequence #%d.\n", seq->ip.src_ip, idx);
+
+            return -1;
+        }
+
+        if (seq->ip.range_count > 0)
+        {
+            ip6_range_t *ranges = arena_alloc(&cfg->arena, sizeof(ip6_range_t) * seq->ip.range_count, 64);
+
+            if (ranges == NULL)
+            {
+                return -1;
+            }
+
+            for (u16 i = 0; i < seq->ip.range_count; i++)
+            {
+                if (parse_ip6_range(seq->ip.ranges[i], &ranges[i]) != 0)
+                {
+                    fprintf(stderr, "Invalid IPv6 range '%s' in sequence #%d.\n", seq->ip.ranges[i], idx);
+
+                    return -1;
+                }
+            }
+
+            hot->src_ranges6 = ranges;
+            hot->src_range6_count = seq->ip.range_count;
+        }
+    }
+    else
+    {
+        if (seq->ip.dst_ip == NULL || inet_pton(AF_INET, seq->ip.dst_ip, &hot->dst_ip) != 1)
+        {
+            fprintf(stderr, "Invalid destination IP '%s' in sequence #%d.\n", seq->ip.dst_ip ? seq->ip.dst_ip : "N/A", idx);
+
+            return -1;
+        }
+
+        if (seq->ip.src_ip != NULL && inet_pton(AF_INET, seq->ip.src_ip, &hot->src_ip) != 1)
+        {
+            fprintf(stderr, "Invalid source IP '%s' in sequence #%d.\n", seq->ip.src_ip, idx);
+
+            return -1;
+        }
+
+        // A fixed source skips the range table entirely. The table is copied so the plan doesn't point back into the sequences.
+        if (seq->ip.range_count > 0 && seq->ip.range_tbl.count > 0)
+        {
+            const range_table_t *tbl = &seq->ip.range_tbl;
+            ip_range_t *entries = arena_alloc(&cfg->arena, sizeof(ip_range_t) * tbl->count, 64);
+
+            if (entries == NULL)
+            {
+                return -1;
+            }
+
+            memcpy(entries, tbl->entries, sizeof(ip_range_t) * tbl->count);
+
+            hot->src_ranges.entries = entries;
+            hot->src_ranges.count = tbl->count;
+            hot->src_ranges.mapped = 1;
+        }
+    }
+
+    // Payloads.
+    if (seq->pl_cnt > 0)
+    {
+        plan_payload_t *pls = arena_alloc(&cfg->arena, sizeof(plan_payload_t) * seq->pl_cnt, 64);
+
+        if (pls == NULL)
+        {
+            return -1;
+        }
+
+        for (int i = 0; i < seq->pl_cnt; i++)
+        {
+            payload_opt_t *pl = &seq->pls[i];
+
+            pls[i].data = pl->data;
+            pls[i].data_len = pl->data_len;
+            pls[i].data_csum = pl->data_csum;
+            pls[i].min_len = pl->min_len;
+            pls[i].max_len = pl->max_len;
+            pls[i].pool = NULL;
+
+            // Random payloads come from a pool generated once here instead of per packet.
+            if (!pl->is_static && pl->data == NULL && pl->pool > 0 && pl->max_len > 0)
+            {
+                pl_pool_t *pool = pl_pool_create(pl->pool, pl->min_len, pl->max_len, prng_next(prng_thread()));
+
+                if (pool == NULL)
+                {
+                    fprintf(stderr, "Failed to create payload pool for payload #%d in sequence #%d.\n", i, idx);
+
+                    return -1;
+                }
+
+                pool->next = cfg->pools;
+                cfg->pools = pool;
+
+                pls[i].pool = pool;
+            }
+        }
+
+        hot->pls = pls;
+        hot->pl_cnt = seq->pl_cnt;
+    }
+
+    // Limits.
+    hot->max_pckts = seq->max_pckts;
+    hot->max_bytes = seq->max_bytes;
+    hot->pps = seq->pps;
+    hot->bps = seq->bps;
+    hot->time = seq->time;
+    hot->delay = seq->delay;
+    hot->threads = seq->threads;
+
+    return 0;
+}
+
+/**
+ * Compiles parsed sequences into a plan. Senders read the hot half, which holds only binary, per-packet data and no strings. Everything else is in the cold half.
+ * 
+ * @param plan A pointer to the plan to fill out.
+ * @param cfg A pointer to the parsed config. The plan is allocated from its arena and lives as long as the config.
+ * @param seq_cnt The amount of parsed sequences.
+ * 
+ * @return 0 on success or -1 on failure (invalid sequence or allocation failure).
+ * 
+ * @note Missing MAC addresses are resolved here (interface MAC and default gateway), not at send time.
+**/
+int compile_plan(plan_t *plan, config_t *cfg, int seq_cnt)
+{
+    memset(plan, 0, sizeof(*plan));
+
+    if (seq_cnt > cfg->seq_cap)
+    {
+        seq_cnt = cfg->seq_cap;
+    }
+
+    if (seq_cnt < 1)
+    {
+        return 0;
+    }
+
+    plan->hot = arena_alloc(&cfg->arena, sizeof(seq_plan_t) * seq_cnt, 64);
+    plan->cold = arena_calloc(&cfg->arena, seq_cnt, sizeof(seq_plan_cold_t));
+
+    if (plan->hot == NULL || plan->cold == NULL)
+    {
+        fprintf(stderr, "Failed to allocate sequence plan.\n");
+
+        return -1;
+    }
+
+    memset(plan->hot, 0, sizeof(seq_plan_t) * seq_cnt);
+
+    for (int i = 0; i < seq_cnt; i++)
+    {
+        if (compile_sequence(cfg, i, &plan->hot[i], &plan->cold[i]) != 0)
+        {
+            return -1;
+        }
+    }
+
+    plan->count = seq_cnt;
+
+    return 0;
+}
+
+/**
+ * Prints a compiled plan (for diagnostics).
+ * 
+ * @param plan A pointer to the plan.
+ * 
+ * @return Void
+**/
+void print_plan(const plan_t *plan)
+{
+    char src[INET6_ADDRSTRLEN];
+    char dst[INET6_ADDRSTRLEN];
+
+    for (int i = 0; i < plan->count; i++)
+    {
+        const seq_plan_t *hot = &plan->hot[i];
+        const seq_plan_cold_t *cold = &plan->cold[i];
+
+        if (hot->flags & PLAN_F_IPV6)
+        {
+            inet_ntop(AF_INET6, hot->src_ip6, src, sizeof(src));
+            inet_ntop(AF_INET6, hot->dst_ip6, dst, sizeof(dst));
+        }
+        else
+        {
+            inet_ntop(AF_INET, &hot->src_ip, src, sizeof(src));
+            inet_ntop(AF_INET, &hot->dst_ip, dst, sizeof(dst));
+        }
+
+        fprintf(stdout, "Plan #%d:\n", i);
+        fprintf(stdout, "\tInterface => %s (index %d)\n", cold->interface ? cold->interface : "N/A", cold->ifindex);
+        fprintf(stdout, "\tProtocol => %u\n", hot->proto);
+        fprintf(stdout, "\tFlags => 0x%04x\n", hot->flags);
+        fprintf(stdout, "\tSource MAC => %02x:%02x:%02x:%02x:%02x:%02x\n", hot->src_mac[0], hot->src_mac[1], hot->src_mac[2], hot->src_mac[3], hot->src_mac[4], hot->src_mac[5]);
+        fprintf(stdout, "\tDestination MAC => %02x:%02x:%02x:%02x:%02x:%02x\n", hot->dst_mac[0], hot->dst_mac[1], hot->dst_mac[2], hot->dst_mac[3], hot->dst_mac[4], hot->dst_mac[5]);
+        fprintf(stdout, "\tSource IP => %s (%u ranges)\n", src, (hot->flags & PLAN_F_IPV6) ? hot->src_range6_count : hot->src_ranges.count);
+        fprintf(stdout, "\tDestination IP => %s\n", dst);
+        fprintf(stdout, "\tPorts => %u -> %u\n", hot->src_port, hot->dst_port);
+        fprintf(stdout, "\tTCP Flags => 0x%02x\n", hot->tcp_flags);
+        fprintf(stdout, "\tPayloads => %u\n", hot->pl_cnt);
+
+        for (u32 j = 0; j < hot->pl_cnt; j++)
+        {
+            const pl_pool_t *pool = hot->pls[j].pool;
+
+            if (pool != NULL)
+            {
+                fprintf(stdout, "\tPayload #%u Pool => %u payloads (%zu bytes, %s pages)\n", j, pool->count, pool->mem_len, pool->huge ? "huge" : "transparent huge");
+            }
+        }
+        fprintf(stdout, "\n");
+    }
+}
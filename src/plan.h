@@ -0,0 +1,110 @@
+#pragma once
+
+#include <linux/if_ether.h>
+
+#include "simple_types.h"
+#include "config.h"
+#include "utils.h"
+
+// Sequence plan flags.
+#define PLAN_F_IPV6 (1 << 0)
+#define PLAN_F_L3_CSUM (1 << 1)
+#define PLAN_F_L4_CSUM (1 << 2)
+#define PLAN_F_CSUM_OFFLOAD (1 << 3)
+#define PLAN_F_BLOCK (1 << 4)
+#define PLAN_F_TRACK (1 << 5)
+#define PLAN_F_TCP_COOKED (1 << 6)
+#define PLAN_F_TCP_ONE_CONN (1 << 7)
+
+// TCP flags as they appear in the header.
+#define PLAN_TCP_FIN 0x01
+#define PLAN_TCP_SYN 0x02
+#define PLAN_TCP_RST 0x04
+#define PLAN_TCP_PSH 0x08
+#define PLAN_TCP_ACK 0x10
+#define PLAN_TCP_URG 0x20
+#define PLAN_TCP_ECE 0x40
+#define PLAN_TCP_CWR 0x80
+
+typedef struct plan_payload
+{
+    // Decoded static payload and its partial checksum (data is NULL for random payloads).
+    const u8 *data;
+    u32 data_len;
+    u32 data_csum;
+
+    // Random payload length.
+    u16 min_len;
+    u16 max_len;
+
+    // Pregenerated random payloads (NULL to generate per packet, see pl_pool_next()).
+    const pl_pool_t *pool;
+} plan_payload_t;
+
+typedef struct seq_plan
+{
+    // Per-packet fields (first cache line).
+    u8 proto;
+    u8 tos;
+    u8 min_ttl;
+    u8 max_ttl;
+    u16 flags;
+    u8 tcp_flags;
+    u8 icmp_type;
+    u8 icmp_code;
+    u16 min_id;
+    u16 max_id;
+
+    // Layer-4 ports for the protocol (host byte order, 0 = random).
+    u16 src_port;
+    u16 dst_port;
+    u16 gso_size;
+
+    u8 src_mac[ETH_ALEN];
+    u8 dst_mac[ETH_ALEN];
+
+    // IPv4 addresses (network byte order). Sources come from src_ranges when it has entries (copied into the plan).
+    be32 src_ip;
+    be32 dst_ip;
+    range_table_t src_ranges;
+
+    const plan_payload_t *pls;
+    u32 pl_cnt;
+
+    // IPv6 addresses (network byte order). Sources come from src_ranges6 when set.
+    u8 src_ip6[16];
+    u8 dst_ip6[16];
+    const ip6_range_t *src_ranges6;
+    u16 src_range6_count;
+
+    // Limits (checked per batch, 0 = unlimited).
+    u64 max_pckts;
+    u64 max_bytes;
+    u64 pps;
+    u64 bps;
+    u64 time;
+    u64 delay;
+    u16 threads;
+} __attribute__((aligned(64))) seq_plan_t;
+
+typedef struct seq_plan_cold
+{
+    // Effective interface (sequence override or global) and its index (0 if unknown).
+    const char *interface;
+    int ifindex;
+
+    // Thread placement.
+    const char *cpus;
+    s16 numa;
+} seq_plan_cold_t;
+
+typedef struct plan
+{
+    // Hot and cold halves of each sequence (same index).
+    seq_plan_t *hot;
+    seq_plan_cold_t *cold;
+    int count;
+} plan_t;
+
+int compile_plan(plan_t *plan, config_t *cfg, int seq_cnt);
+void print_plan(const plan_t *plan);
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/random.h>
+#include <sys/syscall.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "prng.h"
+
+// Amount of 64-bit numbers generated per batch block (a multiple of PRNG_LANES).
+#define PRNG_BLOCK 64
+
+/**
+ * Steps a splitmix64 generator. Used to expand seeds into full generator states.
+ * 
+ * @param x A pointer to the splitmix64 state.
+ * 
+ * @return A 64-bit random number.
+**/
+static u64 splitmix64(u64 *x)
+{
+    u64 z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seeds a generator (both the scalar state and the batch lanes).
+ * 
+ * @param p A pointer to the generator.
+ * @param seed The seed.
+ * 
+ * @return Void
+**/
+void prng_seed(prng_t *p, u64 seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        p->s[i] = splitmix64(&seed);
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < PRNG_LANES; j++)
+        {
+            p->lanes[i][j] = splitmix64(&seed);
+        }
+    }
+}
+
+/**
+ * Retrieves the calling thread's generator, seeding it from the kernel's random pool on first use.
+ * 
+ * @return A pointer to the calling thread's generator.
+**/
+prng_t *prng_thread(void)
+{
+    static __thread prng_t prng;
+    static __thread int seeded;
+
+    if (!seeded)
+    {
+        u64 seed;
+
+        if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed))
+        {
+            seed = (u64)time(NULL) ^ ((u64)syscall(SYS_gettid) << 32) ^ (u64)(unsigned long)&prng;
+        }
+
+        prng_seed(&prng, seed);
+        seeded = 1;
+    }
+
+    return &prng;
+}
+
+/**
+ * Generates PRNG_BLOCK numbers from the batch lanes (portable version, vectorized by the compiler where possible).
+ * 
+ * @param p A pointer to the generator.
+ * @param out The output buffer (PRNG_BLOCK numbers).
+ * 
+ * @return Void
+**/
+static void prng_block_generic(prng_t *p, u64 *out)
+{
+    u64 (*s)[PRNG_LANES] = p->lanes;
+
+    for (int i = 0; i < PRNG_BLOCK; i += PRNG_LANES)
+    {
+        for (int j = 0; j < PRNG_LANES; j++)
+        {
+            out[i + j] = prng_rotl(s[1][j] * 5, 7) * 9;
+
+            u64 t = s[1][j] << 17;
+
+            s[2][j] ^= s[0][j];
+            s[3][j] ^= s[1][j];
+            s[1][j] ^= s[2][j];
+            s[0][j] ^= s[3][j];
+            s[2][j] ^= t;
+            s[3][j] = prng_rotl(s[3][j], 45);
+        }
+    }
+}
+
+#if defined(__x86_64__)
+/**
+ * Generates PRNG_BLOCK numbers from the batch lanes with AVX2 (one lane per 64-bit element).
+ * 
+ * @param p A pointer to the generator.
+ * @param out The output buffer (PRNG_BLOCK numbers).
+ * 
+ * @return Void
+**/
+__attribute__((target("avx2")))
+static void prng_block_avx2(prng_t *p, u64 *out)
+{
+    __m256i s0 = _mm256_loadu_si256((const __m256i *)p->lanes[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i *)p->lanes[1]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i *)p->lanes[2]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i *)p->lanes[3]);
+
+    for (int i = 0; i < PRNG_BLOCK; i += PRNG_LANES)
+    {
+        // rotl(s1 * 5, 7) * 9 without 64-bit vector multiplies.
+        __m256i x = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);
+        x = _mm256_or_si256(_mm256_slli_epi64(x, 7), _mm256_srli_epi64(x, 57));
+        x = _mm256_add_epi64(_mm256_slli_epi64(x, 3), x);
+
+        _mm256_storeu_si256((__m256i *)&out[i], x);
+
+        __m256i t = _mm256_slli_epi64(s1, 17);
+
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+    }
+
+    _mm256_storeu_si256((__m256i *)p->lanes[0], s0);
+    _mm256_storeu_si256((__m256i *)p->lanes[1], s1);
+    _mm256_storeu_si256((__m256i *)p->lanes[2], s2);
+    _mm256_storeu_si256((__m256i *)p->lanes[3], s3);
+}
+#endif
+
+static void prng_block_resolve(prng_t *p, u64 *out);
+
+// The block generator, resolved once on first use.
+static void (*prng_block)(prng_t *p, u64 *out) = prng_block_resolve;
+
+static void prng_block_resolve(prng_t *p, u64 *out)
+{
+    prng_block = prng_block_generic;
+
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        prng_block = prng_block_avx2;
+    }
+#endif
+
+    prng_block(p, out);
+}
+
+/**
+ * Maps 32-bit random numbers into [min, min + range) without bias and stores them.
+ * 
+ * @param p A pointer to the generator (used to redraw the rare rejected values).
+ * @param rnd The 32-bit random numbers.
+ * @param n The amount of numbers.
+ * @param range The range (0 means the full 32-bit range).
+ * @param min The minimum number.
+ * @param out The output buffer.
+ * @param size The size of each output element (1 or 2 bytes).
+ * 
+ * @return Void
+**/
+static void prng_map(prng_t *p, const u32 *rnd, size_t n, u32 range, u32 min, void *out, int size)
+{
+    u32 t = range ? -range % range : 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        u64 m = (u64)rnd[i] * range;
+
+        if ((u32)m < t)
+        {
+            m = (u64)prng_bounded(p, range) << 32;
+        }
+
+        u32 val = min + (u32)(m >> 32);
+
+        if (size == 1)
+        {
+            ((u8 *)out)[i] = (u8)val;
+        }
+        else
+        {
+            ((u16 *)out)[i] = (u16)val;
+        }
+    }
+}
+
+/**
+ * Fills an array with random numbers between min and max (inclusive) using the batch lanes.
+ * 
+ * @param p A pointer to the generator.
+ * @param out The output buffer.
+ * @param n The amount of numbers.
+ * @param min The minimum number.
+ * @param max The maximum number.
+ * @param size The size of each output element (1 or 2 bytes).
+ * 
+ * @return Void
+**/
+static void prng_fill(prng_t *p, void *out, size_t n, u32 min, u32 max, int size)
+{
+    u64 block[PRNG_BLOCK];
+    u32 range = max > min ? max - min + 1 : 1;
+
+    while (n > 0)
+    {
+        prng_block(p, block);
+
+        // Each 64-bit number gives two 32-bit numbers.
+        size_t cnt = n < PRNG_BLOCK * 2 ? n : PRNG_BLOCK * 2;
+
+        prng_map(p, (const u32 *)block, cnt, range, min, out, size);
+
+        out = (u8 *)out + cnt * size;
+        n -= cnt;
+    }
+}
+
+/**
+ * Fills an array of 8-bit numbers (e.g. TTLs) with random values between min and max (inclusive).
+ * 
+ * @param p A pointer to the generator.
+ * @param out The output array.
+ * @param n The amount of numbers.
+ * @param min The minimum number.
+ * @param max The maximum number.
+ * 
+ * @return Void
+**/
+void prng_fill_u8(prng_t *p, u8 *out, size_t n, u8 min, u8 max)
+{
+    prng_fill(p, out, n, min, max, 1);
+}
+
+/**
+ * Fills an array of 16-bit numbers (e.g. IP IDs, ports, or payload lengths) with random values between min and max (inclusive).
+ * 
+ * @param p A pointer to the generator.
+ * @param out The output array.
+ * @param n The amount of numbers.
+ * @param min The minimum number.
+ * @param max The maximum number.
+ * 
+ * @return Void
+**/
+void prng_fill_u16(prng_t *p, u16 *out, size_t n, u16 min, u16 max)
+{
+    prng_fill(p, out, n, min, max, 2);
+}
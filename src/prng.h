@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "simple_types.h"
+
+#define PRNG_LANES 4
+
+/*
+ * xoshiro256** generator. The scalar state is used by prng_next() and the
+ * bounded helpers below, and four independent lanes are used by the batch
+ * fill functions so they can be stepped in parallel with SIMD.
+ */
+typedef struct prng
+{
+    u64 s[4];
+
+    // Batch lanes, stored word-major (lanes[word][lane]).
+    u64 lanes[4][PRNG_LANES];
+} prng_t;
+
+void prng_seed(prng_t *p, u64 seed);
+prng_t *prng_thread(void);
+void prng_fill_u8(prng_t *p, u8 *out, size_t n, u8 min, u8 max);
+void prng_fill_u16(prng_t *p, u16 *out, size_t n, u16 min, u16 max);
+
+static inline u64 prng_rotl(u64 x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Returns the next 64-bit random number.
+ * 
+ * @param p A pointer to the generator.
+ * 
+ * @return A 64-bit random number.
+**/
+static inline u64 prng_next(prng_t *p)
+{
+    u64 *s = p->s;
+    u64 result = prng_rotl(s[1] * 5, 7) * 9;
+    u64 t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = prng_rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Returns an unbiased random number in [0, range) using Lemire's multiply and reject method.
+ * 
+ * @param p A pointer to the generator.
+ * @param range The exclusive upper bound (must be greater than 0).
+ * 
+ * @return A random number below range.
+**/
+static inline u32 prng_bounded(prng_t *p, u32 range)
+{
+    u64 m = (prng_next(p) >> 32) * range;
+    u32 l = (u32)m;
+
+    if (l < range)
+    {
+        u32 t = -range % range;
+
+        while (l < t)
+        {
+            m = (prng_next(p) >> 32) * range;
+            l = (u32)m;
+        }
+    }
+
+    return m >> 32;
+}
+
+/**
+ * Returns an unbiased random number between min and max (inclusive).
+ * 
+ * @param p A pointer to the generator.
+ * @param min The minimum number.
+ * @param max The maximum number.
+ * 
+ * @return A random number between min and max. Returns min if max isn't above min.
+**/
+static inline u32 prng_range(prng_t *p, u32 min, u32 max)
+{
+    if (max <= min)
+    {
+        return min;
+    }
+
+    u32 range = max - min + 1;
+
+    // The full 32-bit range.
+    if (range == 0)
+    {
+        return prng_next(p) >> 32;
+    }
+
+    return min + prng_bounded(p, range);
+}
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <arpa/inet.h>
+
+#include "ranges.h"
+
+/**
+ * Parses an IPv4 address or range in IP/CIDR format (e.g. 10.0.0.0/24). An address without a CIDR is treated as /32.
+ * 
+ * @param range The address or range string.
+ * @param out A pointer to the range to fill in.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int parse_ip_range(const char *range, ip_range_t *out)
+{
+    char ip[INET_ADDRSTRLEN];
+    unsigned int cidr = 32;
+
+    const char *slash = strchr(range, '/');
+    size_t ip_len = slash ? (size_t)(slash - range) : strlen(range);
+
+    if (ip_len >= sizeof(ip))
+    {
+        return -1;
+    }
+
+    memcpy(ip, range, ip_len);
+    ip[ip_len] = '\0';
+
+    if (slash != NULL)
+    {
+        char *end;
+        cidr = strtoul(slash + 1, &end, 10);
+
+        if (end == slash + 1 || *end != '\0' || cidr > 32)
+        {
+            return -1;
+        }
+    }
+
+    struct in_addr addr;
+
+    if (inet_pton(AF_INET, ip, &addr) != 1)
+    {
+        return -1;
+    }
+
+    out->mask = cidr == 0 ? 0xffffffff : ((1U << (32 - cidr)) - 1);
+    out->base = ntohl(addr.s_addr) & ~out->mask;
+
+    return 0;
+}
+
+/**
+ * Builds the alias table columns of a compiled range table using Vose's method.
+ * 
+ * @param tbl A pointer to the table.
+ * @param weights The weight of each entry.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+static int build_alias(range_table_t *tbl, const double *weights)
+{
+    u16 n = tbl->count;
+    double total = 0;
+
+    for (u16 i = 0; i < n; i++)
+    {
+        total += weights[i];
+    }
+
+    double *scaled = malloc(sizeof(double) * n);
+    u16 *small = malloc(sizeof(u16) * n);
+    u16 *large = malloc(sizeof(u16) * n);
+
+    if (scaled == NULL || small == NULL || large == NULL)
+    {
+        free(scaled);
+        free(small);
+        free(large);
+
+        return -1;
+    }
+
+    u16 small_cnt = 0;
+    u16 large_cnt = 0;
+
+    for (u16 i = 0; i < n; i++)
+    {
+        scaled[i] = weights[i] * n / total;
+
+        if (scaled[i] < 1.0)
+        {
+            small[small_cnt++] = i;
+        }
+        else
+        {
+            large[large_cnt++] = i;
+        }
+    }
+
+    while (small_cnt > 0 && large_cnt > 0)
+    {
+        u16 s = small[--small_cnt];
+        u16 l = large[large_cnt - 1];
+
+        tbl->entries[s].prob = (u32)(scaled[s] * 4294967296.0);
+        tbl->entries[s].alias = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+
+        if (scaled[l] < 1.0)
+        {
+            large_cnt--;
+            small[small_cnt++] = l;
+        }
+    }
+
+    // Whatever is left (rounding leftovers included) always keeps its own column.
+    while (large_cnt > 0)
+    {
+        u16 l = large[--large_cnt];
+
+        tbl->entries[l].prob = 0xffffffff;
+        tbl->entries[l].alias = l;
+    }
+
+    while (small_cnt > 0)
+    {
+        u16 s = small[--small_cnt];
+
+        tbl->entries[s].prob = 0xffffffff;
+        tbl->entries[s].alias = s;
+    }
+
+    free(scaled);
+    free(small);
+    free(large);
+
+    return 0;
+}
+
+/**
+ * Compiles a sequence's source ranges (or single source IP/range if there are no ranges) into a table of base/mask entries with alias columns for weighted selection.
+ * 
+ * @param tbl A pointer to the table to fill in. Any previous entries are freed.
+ * @param ranges The ranges array in IP/CIDR format.
+ * @param weights The explicit weight of each range (may be NULL). A weight of 0 weighs the range by its address count.
+ * @param range_count The number of ranges.
+ * @param src_ip The source IP or range used when there are no ranges (may be NULL).
+ * 
+ * @return The number of entries compiled or -1 if one or more ranges are invalid (valid ranges are still compiled).
+**/
+int compile_ranges(range_table_t *tbl, char **ranges, const u32 *weights, u16 range_count, const char *src_ip)
+{
+    int ret = 0;
+
+    free_ranges(tbl);
+
+    u16 cnt = range_count;
+
+    if (cnt < 1)
+    {
+        if (src_ip == NULL)
+        {
+            return 0;
+        }
+
+        ranges = (char **)&src_ip;
+        cnt = 1;
+    }
+
+    tbl->entries = malloc(sizeof(ip_range_t) * cnt);
+    double *w = malloc(sizeof(double) * cnt);
+
+    if (tbl->entries == NULL || w == NULL)
+    {
+        free(w);
+        free_ranges(tbl);
+
+        return -1;
+    }
+
+    for (u16 i = 0; i < cnt; i++)
+    {
+        ip_range_t *range = &tbl->entries[tbl->count];
+
+        if (ranges[i] == NULL || parse_ip_range(ranges[i], range) != 0)
+        {
+            fprintf(stderr, "Invalid IPv4 range '%s'.\n", ranges[i] ? ranges[i] : "N/A");
+
+            ret = -1;
+
+            continue;
+        }
+
+        // Weigh by address count unless an explicit weight is given.
+        w[tbl->count] = (weights != NULL && range_count > 0 && weights[i] > 0) ? (double)weights[i] : (double)range->mask + 1.0;
+
+        tbl->count++;
+    }
+
+    if (tbl->count < 1 || build_alias(tbl, w) != 0)
+    {
+        free_ranges(tbl);
+    }
+
+    free(w);
+
+    return ret < 0 ? ret : tbl->count;
+}
+
+/**
+ * Frees a compiled range table.
+ * 
+ * @param tbl A pointer to the table.
+ * 
+ * @return Void
+**/
+void free_ranges(range_table_t *tbl)
+{
+    if (tbl->entries != NULL && !tbl->mapped)
+    {
+        free(tbl->entries);
+    }
+
+    tbl->entries = NULL;
+    tbl->count = 0;
+    tbl->mapped = 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <arpa/inet.h>
+
+#include "simple_types.h"
+
+typedef struct ip_range
+{
+    // Network address and host mask (host byte order).
+    u32 base;
+    u32 mask;
+
+    // Alias table column: keep this range with probability prob / 2^32, otherwise use the alias range.
+    u32 prob;
+    u16 alias;
+} ip_range_t;
+
+typedef struct range_table
+{
+    ip_range_t *entries;
+    u16 count;
+
+    // Entries are owned elsewhere (mapped config cache or a plan's arena) and aren't freed.
+    u8 mapped;
+} range_table_t;
+
+int parse_ip_range(const char *range, ip_range_t *out);
+int compile_ranges(range_table_t *tbl, char **ranges, const u32 *weights, u16 range_count, const char *src_ip);
+void free_ranges(range_table_t *tbl);
+
+/**
+ * Chooses a random IPv4 address from a compiled range table.
+ * 
+ * @param tbl A pointer to the compiled range table (must have at least one entry).
+ * @param rnd A 64-bit random number. The upper 32 bits pick the range and the lower 32 bits pick the host.
+ * 
+ * @return The address in network byte order.
+ * 
+ * @note Ranges are picked in constant time through the table's alias columns, weighted by address count (or explicit weight).
+ * @note No allocations, strings, or shared state, so this is safe to call from any thread.
+**/
+static inline be32 range_table_rand(const range_table_t *tbl, u64 rnd)
+{
+    // The integer part picks a column and the fractional part is the coin for that column.
+    u64 m = (rnd >> 32) * tbl->count;
+    const ip_range_t *range = &tbl->entries[m >> 32];
+
+    if ((u32)m >= range->prob)
+    {
+        range = &tbl->entries[range->alias];
+    }
+
+    return htonl(range->base | ((u32)rnd & range->mask));
+}
@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <limits.h>
+#include <time.h>
+
+#include <sys/inotify.h>
+
+#include "reload.h"
+#include "cfg_cache.h"
+
+/**
+ * Retrieves a monotonic timestamp.
+ * 
+ * @return The timestamp in milliseconds.
+**/
+static u64 reload_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Frees a snapshot along with its config and plan.
+ * 
+ * @param snap A pointer to the snapshot.
+ * 
+ * @return Void
+**/
+static void reload_snap_free(reload_snap_t *snap)
+{
+    free_config(&snap->cfg);
+
+    free(snap);
+}
+
+/**
+ * Loads, prepares, and compiles a config into a new snapshot.
+ * 
+ * @param rl A pointer to the reload state.
+ * 
+ * @return A pointer to the snapshot or NULL on failure.
+**/
+static reload_snap_t *reload_build(reload_t *rl)
+{
+    reload_snap_t *snap = calloc(1, sizeof(*snap));
+
+    if (snap == NULL)
+    {
+        fprintf(stderr, "Failed to allocate config snapshot.\n");
+
+        return NULL;
+    }
+
+    init_config(&snap->cfg);
+
+    if (load_config(rl->file_name, rl->cache, 0, &snap->cfg, &snap->seq_cnt, rl->log) != 0)
+    {
+        fprintf(stderr, "Failed to load config file '%s'.\n", rl->file_name);
+
+        goto fail;
+    }
+
+    if (rl->prepare != NULL && rl->prepare(&snap->cfg, snap->seq_cnt, rl->ctx) != 0)
+    {
+        goto fail;
+    }
+
+    if (compile_plan(&snap->plan, &snap->cfg, snap->seq_cnt) != 0)
+    {
+        fprintf(stderr, "Failed to compile config file '%s'.\n", rl->file_name);
+
+        goto fail;
+    }
+
+    return snap;
+
+fail:
+    reload_snap_free(snap);
+
+    return NULL;
+}
+
+/**
+ * Loads the initial config snapshot. Call reload_start() to watch the config for changes.
+ * 
+ * @param rl A pointer to the reload state.
+ * @param file_name The config file.
+ * @param cache The binary config cache (NULL = default path, see load_config()).
+ * @param prepare Called on every config before it's compiled (may be NULL).
+ * @param ctx Passed to the prepare callback.
+ * @param log Whether to log parsing and reloads.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int reload_init(reload_t *rl, const char *file_name, const char *cache, reload_prepare_cb prepare, void *ctx, u8 log)
+{
+    memset(rl, 0, sizeof(*rl));
+
+    rl->file_name = file_name;
+    rl->cache = cache;
+    rl->prepare = prepare;
+    rl->ctx = ctx;
+    rl->log = log;
+    rl->epoch = 1;
+    rl->inotify_fd = -1;
+
+    pthread_mutex_init(&rl->lock, NULL);
+
+    rl->cur = reload_build(rl);
+
+    if (rl->cur == NULL)
+    {
+        pthread_mutex_destroy(&rl->lock);
+
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Registers a sender thread as a snapshot reader.
+ * 
+ * @param rl A pointer to the reload state.
+ * 
+ * @return The reader slot or -1 if all slots are taken.
+**/
+int reload_register(reload_t *rl)
+{
+    int reader = __atomic_fetch_add(&rl->reader_cnt, 1, __ATOMIC_ACQ_REL);
+
+    if (reader >= RELOAD_MAX_READERS)
+    {
+        __atomic_fetch_sub(&rl->reader_cnt, 1, __ATOMIC_ACQ_REL);
+
+        fprintf(stderr, "Too many config readers (max %d).\n", RELOAD_MAX_READERS);
+
+        return -1;
+    }
+
+    // Sequentially consistent so reload_reclaim() sees the slot before the reader's first reload_acquire() (see there).
+    __atomic_store_n(&rl->readers[reader].epoch, __atomic_load_n(&rl->epoch, __ATOMIC_ACQUIRE), __ATOMIC_SEQ_CST);
+
+    return reader;
+}
+
+/**
+ * Marks a sender thread as no longer holding a snapshot (e.g. when it exits).
+ * 
+ * @param rl A pointer to the reload state.
+ * @param reader The thread's reader slot.
+ * 
+ * @return Void
+**/
+void reload_unregister(reload_t *rl, int reader)
+{
+    __atomic_store_n(&rl->readers[reader].epoch, RELOAD_OFFLINE, __ATOMIC_RELEASE);
+}
+
+/**
+ * Frees retired snapshots that no sender thread can still hold. A snapshot is safe to free once every online reader has observed the epoch it was retired in.
+ * 
+ * @param rl A pointer to the reload state.
+ * 
+ * @return Void
+**/
+void reload_reclaim(reload_t *rl)
+{
+    pthread_mutex_lock(&rl->lock);
+
+    u64 min = UINT64_MAX;
+    int cnt = __atomic_load_n(&rl->reader_cnt, __ATOMIC_ACQUIRE);
+
+    if (cnt > RELOAD_MAX_READERS)
+    {
+        cnt = RELOAD_MAX_READERS;
+    }
+
+    for (int i = 0; i < cnt; i++)
+    {
+        u64 epoch = __atomic_load_n(&rl->readers[i].epoch, __ATOMIC_SEQ_CST);
+
+        if (epoch != RELOAD_OFFLINE && epoch < min)
+        {
+            min = epoch;
+        }
+    }
+
+    reload_snap_t **prev = &rl->retired;
+
+    while (*prev != NULL)
+    {
+        reload_snap_t *snap = *prev;
+
+        if (snap->retire_epoch <= min)
+        {
+            *prev = snap->next;
+
+            reload_snap_free(snap);
+
+            continue;
+        }
+
+        prev = &snap->next;
+    }
+
+    pthread_mutex_unlock(&rl->lock);
+}
+
+/**
+ * Re-reads the config and publishes it to sender threads with an atomic pointer swap. The previous snapshot is retired and freed by reload_reclaim().
+ * 
+ * @param rl A pointer to the reload state.
+ * 
+ * @return 0 on success or -1 on failure (the current snapshot stays in use).
+ * 
+ * @note Thread placement, interfaces, and thread counts are only applied at startup. A reload that changes the amount of sequences is rejected.
+**/
+int reload_config(reload_t *rl)
+{
+    pthread_mutex_lock(&rl->lock);
+
+    reload_snap_t *old = rl->cur;
+    reload_snap_t *snap = reload_build(rl);
+
+    if (snap == NULL)
+    {
+        pthread_mutex_unlock(&rl->lock);
+
+        return -1;
+    }
+
+    if (snap->seq_cnt != old->seq_cnt)
+    {
+        fprintf(stderr, "Ignoring reload of '%s': sequence count changed from %d to %d (restart required).\n", rl->file_name, old->seq_cnt, snap->seq_cnt);
+
+        reload_snap_free(snap);
+
+        pthread_mutex_unlock(&rl->lock);
+
+        return -1;
+    }
+
+    snap->generation = old->generation + 1;
+
+    // Readers that observe the new epoch are guaranteed to load the new snapshot.
+    __atomic_store_n(&rl->cur, snap, __ATOMIC_SEQ_CST);
+
+    old->retire_epoch = __atomic_add_fetch(&rl->epoch, 1, __ATOMIC_SEQ_CST);
+    old->next = rl->retired;
+    rl->retired = old;
+
+    pthread_mutex_unlock(&rl->lock);
+
+    if (rl->log)
+    {
+        fprintf(stdout, "Reloaded config '%s' (generation %llu).\n", rl->file_name, (unsigned long long)snap->generation);
+    }
+
+    return 0;
+}
+
+/**
+ * Watches the config file's directory and reloads once changes settle.
+ * 
+ * @param arg A pointer to the reload state.
+ * 
+ * @return NULL
+ * 
+ * @note The directory is watched instead of the file so editors that replace files (rename over) are caught too.
+**/
+static void *reload_watch(void *arg)
+{
+    reload_t *rl = arg;
+    const char *base = strrchr(rl->file_name, '/');
+    base = base ? base + 1 : rl->file_name;
+
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    u64 pending = 0;
+
+    while (!__atomic_load_n(&rl->stop, __ATOMIC_ACQUIRE))
+    {
+        struct pollfd pfd = { .fd = rl->inotify_fd, .events = POLLIN };
+
+        if (poll(&pfd, 1, pending ? RELOAD_DEBOUNCE : RELOAD_POLL) > 0)
+        {
+            ssize_t len;
+
+            while ((len = read(rl->inotify_fd, buf, sizeof(buf))) > 0)
+            {
+                for (char *ptr = buf; ptr < buf + len; )
+                {
+                    struct inotify_event *ev = (struct inotify_event *)ptr;
+
+                    if (ev->len > 0 && strcmp(ev->name, base) == 0)
+                    {
+                        pending = reload_now();
+                    }
+
+                    ptr += sizeof(struct inotify_event) + ev->len;
+                }
+            }
+        }
+
+        if (pending && reload_now() - pending >= RELOAD_DEBOUNCE)
+        {
+            pending = 0;
+
+            reload_config(rl);
+        }
+
+        reload_reclaim(rl);
+    }
+
+    return NULL;
+}
+
+/**
+ * Starts watching the config file for changes (inotify) on a background thread.
+ * 
+ * @param rl A pointer to the reload state (see reload_init()).
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int reload_start(reload_t *rl)
+{
+    char dir[PATH_MAX];
+    const char *slash = strrchr(rl->file_name, '/');
+
+    if (slash == NULL)
+    {
+        snprintf(dir, sizeof(dir), ".");
+    }
+    else
+    {
+        snprintf(dir, sizeof(dir), "%.*s", slash == rl->file_name ? 1 : (int)(slash - rl->file_name), rl->file_name);
+    }
+
+    rl->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (rl->inotify_fd < 0)
+    {
+        fprintf(stderr, "Failed to create inotify instance (%s).\n", strerror(errno));
+
+        return -1;
+    }
+
+    if (inotify_add_watch(rl->inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        fprintf(stderr, "Failed to watch '%s' (%s).\n", dir, strerror(errno));
+
+        goto fail;
+    }
+
+    rl->stop = 0;
+
+    if (pthread_create(&rl->thread, NULL, reload_watch, rl) != 0)
+    {
+        fprintf(stderr, "Failed to create config watcher thread.\n");
+
+        goto fail;
+    }
+
+    rl->running = 1;
+
+    return 0;
+
+fail:
+    close(rl->inotify_fd);
+    rl->inotify_fd = -1;
+
+    return -1;
+}
+
+/**
+ * Stops the watcher and frees every snapshot.
+ * 
+ * @param rl A pointer to the reload state.
+ * 
+ * @return Void
+ * 
+ * @note Sender threads must have stopped reading snapshots.
+**/
+void reload_free(reload_t *rl)
+{
+    if (rl->running)
+    {
+        __atomic_store_n(&rl->stop, 1, __ATOMIC_RELEASE);
+
+        pthread_join(rl->thread, NULL);
+
+        rl->running = 0;
+    }
+
+    if (rl->inotify_fd >= 0)
+    {
+        close(rl->inotify_fd);
+        rl->inotify_fd = -1;
+    }
+
+    while (rl->retired != NULL)
+    {
+        reload_snap_t *snap = rl->retired;
+        rl->retired = snap->next;
+
+        reload_snap_free(snap);
+    }
+
+    if (rl->cur != NULL)
+    {
+        reload_snap_free(rl->cur);
+        rl->cur = NULL;
+    }
+
+    pthread_mutex_destroy(&rl->lock);
+}
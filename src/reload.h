@@ -0,0 +1,96 @@
+#pragma once
+
+#include <pthread.h>
+
+#include "simple_types.h"
+#include "config.h"
+#include "plan.h"
+
+// Maximum amount of sender threads that can read snapshots.
+#define RELOAD_MAX_READERS 256
+
+// Quiet period after the last change before reloading and the watcher's poll interval (milliseconds).
+#define RELOAD_DEBOUNCE 50
+#define RELOAD_POLL 100
+
+// Reader slot value while a thread holds no snapshot.
+#define RELOAD_OFFLINE 0
+
+typedef struct reload_snap
+{
+    // Parsed config and its compiled plan (allocated from the config's arena).
+    config_t cfg;
+    plan_t plan;
+    int seq_cnt;
+
+    // Incremented on every successful reload (0 = initial load).
+    u64 generation;
+
+    // Retired snapshots waiting for readers (epoch the swap happened in).
+    struct reload_snap *next;
+    u64 retire_epoch;
+} reload_snap_t;
+
+typedef struct reload_reader
+{
+    // Last epoch the thread observed at a batch boundary (RELOAD_OFFLINE = none).
+    u64 epoch;
+} __attribute__((aligned(64))) reload_reader_t;
+
+// Called on every new config before it's compiled (e.g. to apply command line overrides).
+typedef int (*reload_prepare_cb)(config_t *cfg, int seq_cnt, void *ctx);
+
+typedef struct reload
+{
+    // Current snapshot and global epoch (read by senders without locks).
+    reload_snap_t *cur;
+    u64 epoch;
+
+    reload_reader_t readers[RELOAD_MAX_READERS];
+    int reader_cnt;
+
+    // Config source.
+    const char *file_name;
+    const char *cache;
+    reload_prepare_cb prepare;
+    void *ctx;
+    u8 log;
+
+    // Serializes reloads and guards the retired list.
+    pthread_mutex_t lock;
+    reload_snap_t *retired;
+
+    // Watcher thread.
+    pthread_t thread;
+    int inotify_fd;
+    int stop;
+    u8 running;
+} reload_t;
+
+/**
+ * Publishes that a sender thread reached a batch boundary and retrieves the current snapshot.
+ * 
+ * @param rl A pointer to the reload state.
+ * @param reader The thread's reader slot (see reload_register()).
+ * 
+ * @return The snapshot to use until the next batch boundary.
+ * 
+ * @note The previously returned snapshot may be freed once this returns. This is two loads and a store, with no locks.
+ * @note The slot store and the snapshot load are sequentially consistent. Otherwise the load could complete before the store is visible to reload_reclaim(), which would then free the snapshot being returned.
+**/
+static inline const reload_snap_t *reload_acquire(reload_t *rl, int reader)
+{
+    u64 epoch = __atomic_load_n(&rl->epoch, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(&rl->readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+
+    return __atomic_load_n(&rl->cur, __ATOMIC_SEQ_CST);
+}
+
+int reload_init(reload_t *rl, const char *file_name, const char *cache, reload_prepare_cb prepare, void *ctx, u8 log);
+int reload_start(reload_t *rl);
+int reload_register(reload_t *rl);
+void reload_unregister(reload_t *rl, int reader);
+int reload_config(reload_t *rl);
+void reload_reclaim(reload_t *rl);
+void reload_free(reload_t *rl);
@@ -0,0 +1,546 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+
+#include "topology.h"
+#include "iface.h"
+
+#define TOPO_SYSFS "/sys/devices/system/cpu"
+
+// Maximum amount of CPUs we handle.
+#define TOPO_MAX_CPUS 4096
+
+/**
+ * Parses a CPU list (e.g. "0-3,8,10-11" as used by sysfs and isolcpus).
+ * 
+ * @param list The CPU list.
+ * @param cpus An array to store the CPUs in (may be NULL to only count).
+ * @param max The size of the array.
+ * 
+ * @return The amount of CPUs in the list or -1 if the list is invalid (including CPUs at or above TOPO_MAX_CPUS).
+**/
+int topo_parse_cpu_list(const char *list, int *cpus, int max)
+{
+    int count = 0;
+    const char *p = list;
+
+    while (*p != '\0' && *p != '\n')
+    {
+        char *end;
+        long start = strtol(p, &end, 10);
+        long stop = start;
+
+        if (end == p || start < 0)
+        {
+            return -1;
+        }
+
+        p = end;
+
+        if (*p == '-')
+        {
+            p++;
+            stop = strtol(p, &end, 10);
+
+            if (end == p || stop < start)
+            {
+                return -1;
+            }
+
+            p = end;
+        }
+
+        // Bounding the range also keeps a huge range end from looping for a long time.
+        if (stop >= TOPO_MAX_CPUS)
+        {
+            return -1;
+        }
+
+        for (long cpu = start; cpu <= stop; cpu++)
+        {
+            if (cpus != NULL && count < max)
+            {
+                cpus[count] = (int)cpu;
+            }
+
+            count++;
+        }
+
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p != '\0' && *p != '\n')
+        {
+            return -1;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Parses a NUMA policy.
+ * 
+ * @param policy The policy ("auto" = the interface's node, "none" = ignore NUMA, or a node number).
+ * 
+ * @return The policy (TOPO_NUMA_AUTO, TOPO_NUMA_NONE, or a node) or TOPO_NUMA_INVALID.
+**/
+int topo_parse_numa(const char *policy)
+{
+    if (policy == NULL || strcmp(policy, "auto") == 0)
+    {
+        return TOPO_NUMA_AUTO;
+    }
+
+    if (strcmp(policy, "none") == 0)
+    {
+        return TOPO_NUMA_NONE;
+    }
+
+    char *end;
+    long node = strtol(policy, &end, 10);
+
+    if (end == policy || *end != '\0' || node < 0 || node > 32767)
+    {
+        return TOPO_NUMA_INVALID;
+    }
+
+    return (int)node;
+}
+
+/**
+ * Reads a single integer from a sysfs file.
+ * 
+ * @param path The file's path.
+ * @param def The value to return if the file can't be read.
+ * 
+ * @return The integer.
+**/
+static int topo_read_int(const char *path, int def)
+{
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL)
+    {
+        return def;
+    }
+
+    int val;
+
+    if (fscanf(fp, "%d", &val) != 1)
+    {
+        val = def;
+    }
+
+    fclose(fp);
+
+    return val;
+}
+
+/**
+ * Reads a CPU list from a sysfs file.
+ * 
+ * @param path The file's path.
+ * @param cpus An array to store the CPUs in.
+ * @param max The size of the array.
+ * 
+ * @return The amount of CPUs (0 if the file is missing or empty) or -1 if invalid.
+**/
+static int topo_read_list(const char *path, int *cpus, int max)
+{
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL)
+    {
+        return 0;
+    }
+
+    char buf[4096];
+    int count = 0;
+
+    if (fgets(buf, sizeof(buf), fp) != NULL)
+    {
+        count = topo_parse_cpu_list(buf, cpus, max);
+    }
+
+    fclose(fp);
+
+    return count;
+}
+
+/**
+ * Retrieves the NUMA node of a CPU.
+ * 
+ * @param cpu The CPU.
+ * 
+ * @return The node (0 if the system isn't NUMA).
+**/
+static int topo_cpu_node(int cpu)
+{
+    char path[255];
+    snprintf(path, sizeof(path) - 1, TOPO_SYSFS "/cpu%d", cpu);
+
+    DIR *dir = opendir(path);
+
+    if (dir == NULL)
+    {
+        return 0;
+    }
+
+    int node = 0;
+    struct dirent *ent;
+
+    while ((ent = readdir(dir)) != NULL)
+    {
+        if (strncmp(ent->d_name, "node", 4) == 0 && isdigit((unsigned char)ent->d_name[4]))
+        {
+            node = atoi(ent->d_name + 4);
+
+            break;
+        }
+    }
+
+    closedir(dir);
+
+    return node;
+}
+
+/**
+ * Loads the CPU topology (online CPUs, packages, cores, SMT siblings, NUMA nodes, and isolated CPUs) from sysfs.
+ * 
+ * @param topo A pointer to the topology to fill out.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int topo_load(topology_t *topo)
+{
+    memset(topo, 0, sizeof(*topo));
+
+    // Scratch lists live on the heap (not in statics) so concurrent loads don't share them.
+    int *list = malloc(sizeof(int) * TOPO_MAX_CPUS * 3);
+
+    if (list == NULL)
+    {
+        return -1;
+    }
+
+    int *isolated = list + TOPO_MAX_CPUS;
+    int *siblings = isolated + TOPO_MAX_CPUS;
+    int ret = -1;
+
+    int count = topo_read_list(TOPO_SYSFS "/online", list, TOPO_MAX_CPUS);
+
+    if (count < 1)
+    {
+        goto out;
+    }
+
+    if (count > TOPO_MAX_CPUS)
+    {
+        count = TOPO_MAX_CPUS;
+    }
+
+    int iso_count = topo_read_list(TOPO_SYSFS "/isolated", isolated, TOPO_MAX_CPUS);
+
+    topo->cpus = calloc(count, sizeof(cpu_info_t));
+
+    if (topo->cpus == NULL)
+    {
+        goto out;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        cpu_info_t *info = &topo->cpus[i];
+        char path[255];
+
+        info->cpu = list[i];
+
+        snprintf(path, sizeof(path) - 1, TOPO_SYSFS "/cpu%d/topology/physical_package_id", info->cpu);
+        info->package = topo_read_int(path, 0);
+
+        snprintf(path, sizeof(path) - 1, TOPO_SYSFS "/cpu%d/topology/core_id", info->cpu);
+        info->core = topo_read_int(path, info->cpu);
+
+        info->node = topo_cpu_node(info->cpu);
+
+        // The sibling list is sorted, so our position in it is our thread number on the core.
+        snprintf(path, sizeof(path) - 1, TOPO_SYSFS "/cpu%d/topology/thread_siblings_list", info->cpu);
+        int sib_count = topo_read_list(path, siblings, TOPO_MAX_CPUS);
+
+        for (int j = 0; j < sib_count && j < TOPO_MAX_CPUS; j++)
+        {
+            if (siblings[j] == info->cpu)
+            {
+                info->sibling = j;
+
+                break;
+            }
+        }
+
+        for (int j = 0; j < iso_count && j < TOPO_MAX_CPUS; j++)
+        {
+            if (isolated[j] == info->cpu)
+            {
+                info->isolated = 1;
+
+                break;
+            }
+        }
+    }
+
+    topo->count = count;
+
+    ret = 0;
+
+out:
+    free(list);
+
+    return ret;
+}
+
+/**
+ * Frees a topology.
+ * 
+ * @param topo A pointer to the topology.
+ * 
+ * @return Void
+**/
+void topo_free(topology_t *topo)
+{
+    if (topo->cpus != NULL)
+    {
+        free(topo->cpus);
+    }
+
+    topo->cpus = NULL;
+    topo->count = 0;
+}
+
+/**
+ * Ranks a CPU for placement (lower is better).
+ * 
+ * @param info The CPU.
+ * @param node The preferred node (-1 = none).
+ * 
+ * @return The rank.
+**/
+static int topo_rank(const cpu_info_t *info, int node)
+{
+    int remote = node >= 0 && info->node != node;
+
+    // Local physical cores, local SMT siblings, remote physical cores, remote SMT siblings.
+    return remote * 2 + (info->sibling > 0);
+}
+
+/**
+ * Compares two CPUs for placement.
+ * 
+ * @param a The first CPU.
+ * @param b The second CPU.
+ * @param ctx A pointer to the preferred node.
+ * 
+ * @return The comparison result.
+**/
+static int topo_cmp(const void *a, const void *b, void *ctx)
+{
+    const cpu_info_t *x = a;
+    const cpu_info_t *y = b;
+
+    int node = *(int *)ctx;
+
+    int rx = topo_rank(x, node);
+    int ry = topo_rank(y, node);
+
+    if (rx != ry)
+    {
+        return rx - ry;
+    }
+
+    // Spread over the remaining tiers in node, package, then core order.
+    if (x->node != y->node)
+    {
+        return x->node - y->node;
+    }
+
+    if (x->package != y->package)
+    {
+        return x->package - y->package;
+    }
+
+    if (x->core != y->core)
+    {
+        return x->core - y->core;
+    }
+
+    return x->cpu - y->cpu;
+}
+
+/**
+ * Checks whether a CPU is online.
+ * 
+ * @param topo A pointer to the topology.
+ * @param cpu The CPU.
+ * 
+ * @return 1 if the CPU is online or 0 otherwise.
+**/
+static int topo_online(const topology_t *topo, int cpu)
+{
+    for (int i = 0; i < topo->count; i++)
+    {
+        if (topo->cpus[i].cpu == cpu)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Plans which CPUs a sequence's threads are pinned to.
+ * 
+ * @param topo A pointer to the topology.
+ * @param cpus An explicit CPU list (e.g. "0-3,8") or NULL. An explicit list is used as-is (isolated CPUs included), but every CPU in it must be online.
+ * @param numa The NUMA policy (TOPO_NUMA_AUTO, TOPO_NUMA_NONE, or a node to restrict to).
+ * @param nic_node The interface's NUMA node (-1 if unknown). Used with TOPO_NUMA_AUTO.
+ * @param threads The amount of threads (0 = one per physical core of the preferred node, or of the system).
+ * @param out An array to store one CPU per thread in.
+ * @param max The size of the array.
+ * 
+ * @return The amount of threads planned or -1 on failure (invalid CPU list, offline CPU, or no usable CPU). CPUs are reused in order when there are more threads than CPUs.
+ * 
+ * @note CPUs listed in isolcpus are only used when listed explicitly.
+**/
+int topo_plan(const topology_t *topo, const char *cpus, int numa, int nic_node, u16 threads, int *out, int max)
+{
+    int *list = NULL;
+    int count = 0;
+
+    if (cpus != NULL && *cpus != '\0')
+    {
+        count = topo_parse_cpu_list(cpus, NULL, 0);
+
+        if (count < 1 || (list = malloc(sizeof(int) * count)) == NULL)
+        {
+            return -1;
+        }
+
+        topo_parse_cpu_list(cpus, list, count);
+
+        for (int i = 0; i < count; i++)
+        {
+            if (!topo_online(topo, list[i]))
+            {
+                free(list);
+
+                return -1;
+            }
+        }
+
+        if (threads == 0)
+        {
+            threads = count;
+        }
+    }
+    else
+    {
+        int node = numa >= 0 ? numa : (numa == TOPO_NUMA_AUTO ? nic_node : -1);
+        cpu_info_t *cand = malloc(sizeof(cpu_info_t) * (topo->count > 0 ? topo->count : 1));
+
+        if (cand == NULL)
+        {
+            return -1;
+        }
+
+        for (int i = 0; i < topo->count; i++)
+        {
+            const cpu_info_t *info = &topo->cpus[i];
+
+            // An explicit node is a hard restriction; the interface's node is only a preference.
+            if (info->isolated || (numa >= 0 && info->node != numa))
+            {
+                continue;
+            }
+
+            cand[count++] = *info;
+        }
+
+        if (count < 1)
+        {
+            free(cand);
+
+            return -1;
+        }
+
+        qsort_r(cand, count, sizeof(cpu_info_t), topo_cmp, &node);
+
+        if (threads == 0)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                if (topo_rank(&cand[i], node) == 0)
+                {
+                    threads++;
+                }
+            }
+
+            if (threads == 0)
+            {
+                threads = count;
+            }
+        }
+
+        list = malloc(sizeof(int) * count);
+
+        if (list == NULL)
+        {
+            free(cand);
+
+            return -1;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            list[i] = cand[i].cpu;
+        }
+
+        free(cand);
+    }
+
+    int planned = threads < max ? threads : max;
+
+    for (int i = 0; i < planned; i++)
+    {
+        out[i] = list[i % count];
+    }
+
+    free(list);
+
+    return planned;
+}
+
+/**
+ * Plans which CPUs a sequence's threads are pinned to, using the NUMA node of the interface it sends out of.
+ * 
+ * @param topo A pointer to the topology.
+ * @param cpus An explicit CPU list or NULL.
+ * @param numa The NUMA policy.
+ * @param dev The interface name (may be NULL).
+ * @param threads The amount of threads (0 = automatic).
+ * @param out An array to store one CPU per thread in.
+ * @param max The size of the array.
+ * 
+ * @return The amount of threads planned or -1 on failure.
+**/
+int topo_plan_sequence(const topology_t *topo, const char *cpus, int numa, const char *dev, u16 threads, int *out, int max)
+{
+    const iface_t *iface = dev != NULL ? iface_get(dev) : NULL;
+
+    return topo_plan(topo, cpus, numa, iface != NULL ? iface->numa_node : -1, threads, out, max);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "simple_types.h"
+
+// NUMA policies (values 0 and up pin to that node).
+#define TOPO_NUMA_AUTO -1
+#define TOPO_NUMA_NONE -2
+#define TOPO_NUMA_INVALID -3
+
+typedef struct cpu_info
+{
+    int cpu;
+    int package;
+    int core;
+    int node;
+
+    // Position among the core's SMT siblings (0 = first thread of the physical core).
+    int sibling;
+
+    unsigned int isolated : 1;
+} cpu_info_t;
+
+typedef struct topology
+{
+    cpu_info_t *cpus;
+    int count;
+} topology_t;
+
+int topo_load(topology_t *topo);
+void topo_free(topology_t *topo);
+int topo_parse_cpu_list(const char *list, int *cpus, int max);
+int topo_parse_numa(const char *policy);
+int topo_plan(const topology_t *topo, const char *cpus, int numa, int nic_node, u16 threads, int *out, int max);
+int topo_plan_sequence(const topology_t *topo, const char *cpus, int numa, const char *dev, u16 threads, int *out, int max);
@@ -7,47 +7,81 @@
 #include <arpa/inet.h>
 
 #include "simple_types.h"
+#include "utils.h"
+#include "ranges.h"
+#include "prng.h"
+#include "netlink.h"
+#include "iface.h"
 
 /**
- * Retrieves the Ethernet MAC of the host's default gateway and stores it in `mac` (u8 *).
+ * Retrieves the Ethernet MAC of the default gateway reached through an interface and stores it in `mac` (u8 *). Resolution is triggered if the kernel has no neighbor entry yet.
  * 
  * @param mac The variable to store the MAC address in. Must be an u8 * array with the length of ETH_ALEN (6).
+ * @param ifindex The outgoing interface's index (0 = any interface).
+ * @param family The address family of the traffic (AF_INET or AF_INET6).
  * 
- * @return Void
+ * @return 0 on success or -1 on failure (no default route or the gateway didn't resolve).
 **/
-void get_gw_mac(u8 *mac)
+int get_gw_mac(u8 *mac, int ifindex, int family)
 {
-    char cmd[] = "ip neigh | grep \"$(ip -4 route list 0/0|cut -d' ' -f3) \"|cut -d' ' -f5|tr '[a-f]' '[A-F]'";
-
-    FILE *fp =  popen(cmd, "r");
-
-    if (fp != NULL)
+    if (family == AF_INET6)
     {
-        char line[18];
+        u8 gw6[16];
 
-        if (fgets(line, sizeof(line), fp) != NULL)
+        if (nl_iface_gw(AF_INET6, ifindex, gw6, &ifindex) != 0)
         {
-            sscanf(line, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
+            return -1;
         }
 
-        pclose(fp);
+        return nl_resolve_mac6(gw6, ifindex, mac);
+    }
+
+    be32 gw;
+
+    if (nl_iface_gw(AF_INET, ifindex, &gw, NULL) != 0)
+    {
+        return -1;
     }
+
+    return nl_resolve_mac(gw, mac);
 }
 
 /**
- * Returns a random integer between min and max using rand_r(), a thread-safe function. 
+ * Retrieves the calling thread's generator for the legacy seed-based helpers below.
+ * 
+ * @param seed The seed to use if this is the thread's first call.
+ * 
+ * @return A pointer to the calling thread's generator.
+**/
+static prng_t *seeded_prng(unsigned int seed)
+{
+    static __thread prng_t prng;
+    static __thread int seeded;
+
+    if (!seeded)
+    {
+        prng_seed(&prng, seed);
+        seeded = 1;
+    }
+
+    return &prng;
+}
+
+/**
+ * Returns an unbiased random integer between min and max using the calling thread's generator.
  * 
  * @param min The minimum number to choose from.
  * @param max The maximum number to choose from.
- * @param seed The seed to pass to the rand_r() function.
+ * @param seed The seed for the calling thread's generator (only used on the thread's first call).
  * 
  * @return A 16-bit integer (u16).
  * 
- * @note If you're trying to return an integer within the 8-bit range, I'd recommend casting as u8 or similar.
+ * @note The generator advances on each call, so repeated calls with the same seed return different numbers.
+ * @note Use prng_thread() with prng_range() or prng_fill_u8()/prng_fill_u16() in per-packet paths.
 **/
 u16 rand_num(u16 min, u16 max, unsigned int seed)
 {
-    return (rand_r(&seed) % (max - min + 1)) + min;
+    return prng_range(seeded_prng(seed), min, max);
 }
 
 /**
@@ -71,92 +105,63 @@ char *lower_str(char *str)
  * Chooses a random IP from a specific CIDR range.
  * 
  * @param range The range in IP/CIDR format.
+ * @param seed The seed for the calling thread's generator (only used on the thread's first call).
  * 
  * @return The pointer to a string with the random IP within the CIDR range.
  * 
+ * @note The string is stored in a per-thread buffer that's overwritten on the next call.
+ * @note This parses the range on each call. Use compile_ranges() and range_table_rand() in per-packet paths.
  * @note Thanks for the help on https://stackoverflow.com/questions/64542446/choosing-a-random-ip-from-any-specific-cidr-range-in-c.
 **/
 char *rand_ip(char *range, unsigned int seed)
 {
-    // Split the <ip>/<cidr> and assign both values.
-    char *split;
-
-    char *s_ip = NULL;    
-    char *cidr_str = NULL;
+    static __thread char ip_str[INET_ADDRSTRLEN];
 
-    char *str = malloc(sizeof(char) * (strlen(range) + 1));
-    strcpy(str, range);
-
-    split = strtok(str, "/");
-
-    // Check to ensure split isn't NULL.
-    if (split != NULL)
-    {
-        // Get network IP.
-        s_ip = strdup(split);
-
-        // Split again based off of '/'.
-        split = strtok(NULL, "/");
-
-        // Check to ensure split isn't NULL and get CIDR.
-        if (split != NULL)
-        {
-            cidr_str = strdup(split);
-        }
-    }
+    ip_range_t r;
 
-    // Check to ensure CIDR string and source IP isn't NULL.
-    if (cidr_str == NULL || s_ip == NULL)
+    if (parse_ip_range(range, &r) != 0)
     {
         return "127.0.0.1";
     }
 
-    // Free the temporary string (str).
-    free(str);
-
-    u8 cidr = (u8) atoi(cidr_str);
-
-    // Create in_addr and convert the IP string to a 32-bit integer.
-    struct in_addr in_addr;
-    inet_aton(s_ip, &in_addr);
-    u32 ip_addr = ntohl(in_addr.s_addr);
-
-    // Get the mask (the complement of 2 to the power of the CIDR minus one).
-    u32 mask = (1 << (32 - cidr)) - 1;
-
-    // Generate a random number using rand_r(&seed).
-    u32 rand_num = rand_r(&seed);
-
     // Generate new 32-bit IPv4 address from IP/CIDR range above.
-    u32 rand_ip = (ip_addr & ~mask) | (mask & rand_num);
+    u32 rand_ip = r.base | (r.mask & (u32)prng_next(seeded_prng(seed)));
 
-    // Convert the new IP to a string and print it.
+    // Convert the new IP to a string.
     struct in_addr rand_ip_str;
     rand_ip_str.s_addr = htonl(rand_ip);
 
-    // Free pointers we longer need.
-    if (s_ip != NULL)
-        free(s_ip);
+    inet_ntop(AF_INET, &rand_ip_str, ip_str, sizeof(ip_str));
 
-    if (cidr_str != NULL)
-        free(cidr_str);
-
-    return inet_ntoa(rand_ip_str);
+    return ip_str;
 }
 
 /**
- * Retrieves the source MAC address of an interface.
+ * Retrieves the source MAC address of an interface. Interfaces missing from the interface table (e.g. created after it was built) are read from sysfs.
  * 
  * @param dev The interface/device name.
  * @param src_mac A pointer to the source MAC address (u8).
  * 
- * @return 0 on success or -1 on failure (path not found).
+ * @return 0 on success or -1 on failure (interface not found).
 **/
 int get_src_mac_address(const char *dev, u8 *src_mac)
 {
+    const iface_t *iface = iface_get(dev);
+
+    if (iface != NULL)
+    {
+        memcpy(src_mac, iface->mac, ETH_ALEN);
+
+        return 0;
+    }
+
     // Format path to source MAC on file system using network class.
     char path[255];
-    snprintf(path, sizeof(path) - 1, "/sys/class/net/%s/address", dev);
+
+    if (snprintf(path, sizeof(path), "/sys/class/net/%s/address", dev) >= (int)sizeof(path))
+    {
+        return -1;
+    }
 
     // Attempt to open path/file and check.
     FILE *fp = fopen(path, "r");
@@ -166,17 +171,128 @@ int get_src_mac_address(const char *dev, u8 *src_mac)
         return -1;
     }
 
-    // Create buffer to copy contents of file to.
+    // Copy contents of file to buffer and scan MAC address.
     char buffer[255];
+    int ret = -1;
 
-    // Copy contents of file to buffer.
-    fgets(buffer, sizeof(buffer), fp);
-
-    // Scan MAC address.
-    sscanf(buffer, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &src_mac[0], &src_mac[1], &src_mac[2], &src_mac[3], &src_mac[4], &src_mac[5]);
+    if (fgets(buffer, sizeof(buffer), fp) != NULL && sscanf(buffer, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &src_mac[0], &src_mac[1], &src_mac[2], &src_mac[3], &src_mac[4], &src_mac[5]) == ETH_ALEN)
+    {
+        ret = 0;
+    }
 
-    // Close file.
     fclose(fp);
 
+    return ret;
+}
+
+/**
+ * Checks whether an IP address or range string is IPv6.
+ * 
+ * @param ip The IP address or range (may be NULL).
+ * 
+ * @return 1 if the string is IPv6 or 0 otherwise.
+**/
+int is_ipv6(const char *ip)
+{
+    return ip != NULL && strchr(ip, ':') != NULL;
+}
+
+/**
+ * Converts an IPv6 address in network byte order to a host byte order 128-bit integer.
+ * 
+ * @param addr The address (16 bytes).
+ * 
+ * @return The address as a 128-bit integer.
+**/
+static u128 ip6_to_u128(const u8 *addr)
+{
+    u128 val = 0;
+
+    for (int i = 0; i < 16; i++)
+    {
+        val = (val << 8) | addr[i];
+    }
+
+    return val;
+}
+
+/**
+ * Parses an IPv6 address or range in IP/CIDR format (e.g. fd00::/64). An address without a CIDR is treated as /128.
+ * 
+ * @param range The address or range string.
+ * @param out A pointer to the range structure to fill in.
+ * 
+ * @return 0 on success or -1 on failure.
+**/
+int parse_ip6_range(const char *range, ip6_range_t *out)
+{
+    char ip[INET6_ADDRSTRLEN];
+    unsigned int cidr = 128;
+
+    const char *slash = strchr(range, '/');
+    size_t ip_len = slash ? (size_t)(slash - range) : strlen(range);
+
+    if (ip_len >= sizeof(ip))
+    {
+        return -1;
+    }
+
+    memcpy(ip, range, ip_len);
+    ip[ip_len] = '\0';
+
+    if (slash != NULL)
+    {
+        char *end;
+        cidr = strtoul(slash + 1, &end, 10);
+
+        if (end == slash + 1 || *end != '\0' || cidr > 128)
+        {
+            return -1;
+        }
+    }
+
+    u8 addr[16];
+
+    if (inet_pton(AF_INET6, ip, addr) != 1)
+    {
+        return -1;
+    }
+
+    out->mask = cidr == 0 ? ~(u128)0 : (((u128)1 << (128 - cidr)) - 1);
+    out->base = ip6_to_u128(addr) & ~out->mask;
+
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Chooses a random IPv6 address from a pre-parsed range.
+ * 
+ * @param range A pointer to the range (see parse_ip6_range()).
+ * @param seed A pointer to the caller's 64-bit generator state, advanced on each call.
+ * @param addr The 16-byte buffer to store the address in (network byte order).
+ * 
+ * @return Void
+**/
+void rand_ip6(const ip6_range_t *range, u64 *seed, u8 *addr)
+{
+    u128 rnd = 0;
+
+    // Two rounds of splitmix64 give 128 random bits.
+    for (int i = 0; i < 2; i++)
+    {
+        u64 z = (*seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z ^= z >> 31;
+
+        rnd = (rnd << 64) | z;
+    }
+
+    u128 ip = range->base | (rnd & range->mask);
+
+    for (int i = 15; i >= 0; i--)
+    {
+        addr[i] = (u8)ip;
+        ip >>= 8;
+    }
+}
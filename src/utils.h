@@ -2,8 +2,18 @@
 
 #include "simple_types.h"
 
-void get_gw_mac(u8 *mac);
+typedef struct ip6_range
+{
+    // Network address and host mask (host byte order).
+    u128 base;
+    u128 mask;
+} ip6_range_t;
+
+int get_gw_mac(u8 *mac, int ifindex, int family);
 int get_src_mac_address(const char *dev, u8 *src_mac);
 u16 rand_num(u16 min, u16 max, unsigned int seed);
 char *lower_str(char *str);
-char *rand_ip(char *range, unsigned int seed);
\ No newline at end of file
+char *rand_ip(char *range, unsigned int seed);
+int is_ipv6(const char *ip);
+int parse_ip6_range(const char *range, ip6_range_t *out);
+void rand_ip6(const ip6_range_t *range, u64 *seed, u8 *addr);
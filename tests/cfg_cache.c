@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <config.h>
+#include <cfg_cache.h>
+
+// Output of print_config() for one config.
+#define PRINT_MAX 32768
+
+// Fixtures copied into the scratch directory (edited there, never in place).
+static const char *fixtures[] = { "cache_main.json", "cache_frag.json", "cache_payload.hex" };
+
+#define FIXTURE_CNT (sizeof(fixtures) / sizeof(fixtures[0]))
+
+#define CFG_FILE "cache_main.json"
+
+#define EXPECT(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            fprintf(stdout, "\t%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+            \
+            return 1; \
+        } \
+    } while (0)
+
+/**
+ * Writes or appends data to a file.
+ *
+ * @param path The file.
+ * @param mode The fopen() mode ("wb" or "ab").
+ * @param data The data.
+ * @param len The data length.
+ *
+ * @return 0 on success or -1 on failure.
+**/
+static int write_file(const char *path, const char *mode, const void *data, size_t len)
+{
+    FILE *fp = fopen(path, mode);
+
+    if (fp == NULL)
+    {
+        return -1;
+    }
+
+    size_t written = fwrite(data, 1, len, fp);
+
+    return fclose(fp) == 0 && written == len ? 0 : -1;
+}
+
+/**
+ * Copies a file.
+ *
+ * @param src The source file.
+ * @param dst The destination file.
+ *
+ * @return 0 on success or -1 on failure.
+**/
+static int copy_file(const char *src, const char *dst)
+{
+    char buf[4096];
+    FILE *fp = fopen(src, "rb");
+
+    if (fp == NULL)
+    {
+        return -1;
+    }
+
+    size_t len = fread(buf, 1, sizeof(buf), fp);
+
+    fclose(fp);
+
+    return write_file(dst, "wb", buf, len);
+}
+
+/**
+ * Prints a config with print_config() and captures the output.
+ *
+ * @param cfg A pointer to the config.
+ * @param seq_cnt The amount of sequences.
+ * @param out A buffer to store the output in (PRINT_MAX bytes).
+ *
+ * @return 0 on success or -1 if stdout couldn't be captured.
+**/
+static int capture_print(config_t *cfg, int seq_cnt, char *out)
+{
+    FILE *tmp = tmpfile();
+
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+
+    fflush(stdout);
+
+    int saved = dup(STDOUT_FILENO);
+
+    dup2(fileno(tmp), STDOUT_FILENO);
+
+    print_config(cfg, seq_cnt);
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    rewind(tmp);
+
+    size_t len = fread(out, 1, PRINT_MAX - 1, tmp);
+    out[len] = '\0';
+
+    fclose(tmp);
+
+    return 0;
+}
+
+/**
+ * Checks whether a pointer points into a config's mapped cache.
+ *
+ * @param cfg A pointer to the config.
+ * @param ptr The pointer.
+ *
+ * @return 1 if it does or 0 otherwise.
+**/
+static int in_map(const config_t *cfg, const void *ptr)
+{
+    const u8 *p = ptr;
+    const u8 *map = cfg->map;
+
+    return p >= map && p < map + cfg->map_len;
+}
+
+/**
+ * Checks a config loaded from the cache matches the config it was saved from.
+ *
+ * @param fresh A pointer to the config parsed from JSON.
+ * @param fresh_cnt The amount of parsed sequences.
+ * @param cached A pointer to the config loaded from the cache.
+ * @param cached_cnt The amount of cached sequences.
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_round_trip(config_t *fresh, int fresh_cnt, config_t *cached, int cached_cnt)
+{
+    EXPECT(cached->map != NULL);
+    EXPECT(cached_cnt == fresh_cnt && cached_cnt == 2);
+    EXPECT(in_map(cached, cached->seq) && in_map(cached, cached->interface));
+
+    for (int i = 0; i < fresh_cnt; i++)
+    {
+        const sequence_t *a = &fresh->seq[i];
+        const sequence_t *b = &cached->seq[i];
+
+        // Relocated pointers land inside the mapping.
+        EXPECT(b->include_count == a->include_count && in_map(cached, b->includes) && in_map(cached, b->includes[0]));
+        EXPECT(strcmp(b->includes[0], a->includes[0]) == 0);
+
+        // Compiled range tables are shared with the mapping instead of being rebuilt.
+        EXPECT(b->ip.range_tbl.mapped && b->ip.range_tbl.count == a->ip.range_tbl.count && a->ip.range_tbl.count > 0);
+        EXPECT(in_map(cached, b->ip.range_tbl.entries));
+        EXPECT(memcmp(b->ip.range_tbl.entries, a->ip.range_tbl.entries, sizeof(ip_range_t) * a->ip.range_tbl.count) == 0);
+
+        EXPECT(b->ip.range_count == a->ip.range_count);
+
+        for (int j = 0; j < a->ip.range_count; j++)
+        {
+            EXPECT(strcmp(b->ip.ranges[j], a->ip.ranges[j]) == 0 && b->ip.range_weights[j] == a->ip.range_weights[j]);
+        }
+
+        // Decoded payloads keep their bytes and partial checksums.
+        EXPECT(b->pl_cnt == a->pl_cnt);
+
+        for (int j = 0; j < a->pl_cnt; j++)
+        {
+            const payload_opt_t *pa = &a->pls[j];
+            const payload_opt_t *pb = &b->pls[j];
+
+            EXPECT(pb->data_len == pa->data_len && pb->data_csum == pa->data_csum);
+            EXPECT((pa->data == NULL) == (pb->data == NULL));
+            EXPECT(pb->data == NULL || (in_map(cached, pb->data) && memcmp(pb->data, pa->data, pa->data_len) == 0));
+        }
+    }
+
+    // Static payloads were actually loaded (hex file and escaped string), so the comparison above covers them.
+    EXPECT(fresh->seq[0].pl_cnt == 3 && fresh->seq[0].pls[0].data_len == 24 && fresh->seq[0].pls[1].data_len == 18);
+
+    // Everything else (every scalar option and string) prints the same.
+    char *a_out = malloc(PRINT_MAX);
+    char *b_out = malloc(PRINT_MAX);
+    int same = a_out != NULL && b_out != NULL && capture_print(fresh, fresh_cnt, a_out) == 0 && capture_print(cached, cached_cnt, b_out) == 0 && strcmp(a_out, b_out) == 0;
+
+    free(a_out);
+    free(b_out);
+
+    EXPECT(same);
+
+    return 0;
+}
+
+/**
+ * Edits a file the cache depends on and checks the cache goes stale, then recompiles it and checks the new contents are picked up.
+ *
+ * @param file The file to edit.
+ * @param mode The fopen() mode ("wb" to replace or "ab" to append).
+ * @param data The data to write.
+ * @param check Checks the recompiled config reflects the edit.
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_stale(const char *file, const char *mode, const char *data, int (*check)(const config_t *cfg))
+{
+    char cache[512];
+    config_t cfg;
+    int seq_cnt = 0;
+
+    EXPECT(config_cache_path(CFG_FILE, cache, sizeof(cache)) == 0);
+
+    // The cache is fresh before the edit.
+    init_config(&cfg);
+    EXPECT(load_config_cache(cache, CFG_FILE, &cfg, &seq_cnt) == 0);
+    free_config(&cfg);
+
+    EXPECT(write_file(file, mode, data, strlen(data)) == 0);
+
+    // A stale cache leaves the config untouched.
+    init_config(&cfg);
+    EXPECT(load_config_cache(cache, CFG_FILE, &cfg, &seq_cnt) == 1);
+    EXPECT(cfg.map == NULL && cfg.seq == NULL && cfg.seq_cap == 0);
+
+    // Parsing appends after *seq_num, so start over like a fresh run.
+    seq_cnt = 0;
+
+    EXPECT(load_config(CFG_FILE, NULL, 1, &cfg, &seq_cnt, 0) == 0);
+    free_config(&cfg);
+
+    init_config(&cfg);
+    EXPECT(load_config_cache(cache, CFG_FILE, &cfg, &seq_cnt) == 0);
+
+    int ret = check(&cfg);
+
+    free_config(&cfg);
+
+    EXPECT(ret == 0);
+
+    return 0;
+}
+
+static int check_include_edit(const config_t *cfg)
+{
+    EXPECT(cfg->seq[0].time == 6 && cfg->seq[1].time == 3);
+
+    return 0;
+}
+
+static int check_payload_edit(const config_t *cfg)
+{
+    EXPECT(cfg->seq[0].pl_cnt == 3 && cfg->seq[0].pls[0].data_len == 27);
+    EXPECT(memcmp(cfg->seq[0].pls[0].data + 24, "\xab\xcd\xef", 3) == 0);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *dir = argc > 1 ? argv[1] : "./tests/fixtures/cfg";
+    char scratch[] = "/tmp/pb_cfg_cache.XXXXXX";
+
+    if (mkdtemp(scratch) == NULL)
+    {
+        fprintf(stderr, "Failed to create a scratch directory.\n");
+
+        return EXIT_FAILURE;
+    }
+
+    int failed = 0;
+
+    for (unsigned i = 0; i < FIXTURE_CNT; i++)
+    {
+        char src[512];
+        char dst[512];
+
+        snprintf(src, sizeof(src), "%s/%s", dir, fixtures[i]);
+        snprintf(dst, sizeof(dst), "%s/%s", scratch, fixtures[i]);
+
+        if (copy_file(src, dst) != 0)
+        {
+            fprintf(stderr, "Failed to copy '%s'.\n", src);
+
+            failed = 1;
+        }
+    }
+
+    // Payload file paths are relative to the working directory.
+    if (failed || chdir(scratch) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    char cache[512];
+    config_cache_path(CFG_FILE, cache, sizeof(cache));
+
+    config_t fresh;
+    config_t cached;
+    int fresh_cnt = 0;
+    int cached_cnt = 0;
+
+    init_config(&fresh);
+    init_config(&cached);
+
+    fprintf(stdout, "round trip: ");
+
+    if (parse_config(CFG_FILE, &fresh, 0, &fresh_cnt, 0) != 0 || save_config_cache(cache, CFG_FILE, &fresh, fresh_cnt) != 0 || load_config_cache(cache, CFG_FILE, &cached, &cached_cnt) != 0)
+    {
+        fprintf(stdout, "failed to build and load the cache\n");
+
+        failed = 1;
+    }
+    else if (check_round_trip(&fresh, fresh_cnt, &cached, cached_cnt) != 0)
+    {
+        failed = 1;
+    }
+    else
+    {
+        fprintf(stdout, "ok\n");
+    }
+
+    free_config(&cached);
+    free_config(&fresh);
+
+    // A cache only belongs to the config it was built from.
+    init_config(&cached);
+
+    fprintf(stdout, "other config: ");
+
+    if (load_config_cache(cache, "other.json", &cached, &cached_cnt) != 1)
+    {
+        fprintf(stdout, "cache was loaded\n");
+
+        failed = 1;
+    }
+    else
+    {
+        fprintf(stdout, "ok\n");
+    }
+
+    free_config(&cached);
+
+    const char *frag = "{\n    \"time\": 6,\n    \"ip\": {\n        \"protocol\": \"udp\"\n    }\n}\n";
+
+    fprintf(stdout, "include edit: ");
+
+    if (check_stale("cache_frag.json", "wb", frag, check_include_edit) != 0)
+    {
+        failed = 1;
+    }
+    else
+    {
+        fprintf(stdout, "ok\n");
+    }
+
+    fprintf(stdout, "payload edit: ");
+
+    if (check_stale("cache_payload.hex", "ab", "abcdef", check_payload_edit) != 0)
+    {
+        failed = 1;
+    }
+    else
+    {
+        fprintf(stdout, "ok\n");
+    }
+
+    for (unsigned i = 0; i < FIXTURE_CNT; i++)
+    {
+        unlink(fixtures[i]);
+    }
+
+    unlink(cache);
+
+    if (chdir("/") == 0)
+    {
+        rmdir(scratch);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
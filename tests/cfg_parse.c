@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <config.h>
+
+// Diagnostics printed while parsing a fixture.
+#define LOG_MAX 8192
+
+typedef struct cfg_case
+{
+    const char *file;
+    int (*check)(const config_t *cfg, int seq_cnt, const char *log);
+
+    // Parsed first when set, with `file` then appended through parse_config(..., only_seq=1, ...).
+    const char *first;
+} cfg_case_t;
+
+// Defaults of a sequence that sets nothing.
+static sequence_t defaults;
+
+#define EXPECT(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            fprintf(stdout, "\t%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+            \
+            return 1; \
+        } \
+    } while (0)
+
+/**
+ * Parses a fixture with logging on and captures everything it prints to stderr.
+ *
+ * @param path The fixture.
+ * @param cfg A pointer to the config.
+ * @param only_seq Whether to only append the fixture's sequences.
+ * @param seq_cnt A pointer to the amount of sequences.
+ * @param log A buffer to store the diagnostics in (LOG_MAX bytes).
+ *
+ * @return parse_config()'s return value or -1 if stderr couldn't be captured.
+**/
+static int parse_fixture(const char *path, config_t *cfg, int only_seq, int *seq_cnt, char *log)
+{
+    FILE *tmp = tmpfile();
+
+    if (tmp == NULL)
+    {
+        return -1;
+    }
+
+    fflush(stderr);
+
+    int saved = dup(STDERR_FILENO);
+
+    dup2(fileno(tmp), STDERR_FILENO);
+
+    int ret = parse_config(path, cfg, only_seq, seq_cnt, 1);
+
+    fflush(stderr);
+    dup2(saved, STDERR_FILENO);
+    close(saved);
+
+    rewind(tmp);
+
+    size_t len = fread(log, 1, LOG_MAX - 1, tmp);
+    log[len] = '\0';
+
+    fclose(tmp);
+
+    return ret;
+}
+
+static int check_unknown(const config_t *cfg, int seq_cnt, const char *log)
+{
+    // Unknown keys are reported (at every level) and skipped; known keys around them still apply.
+    EXPECT(strstr(log, "Unknown key 'bogus_root' in config") != NULL);
+    EXPECT(strstr(log, "Unknown key 'bogus_seq' in sequence") != NULL);
+    EXPECT(strstr(log, "Unknown key 'bogus_ip' in ip") != NULL);
+    EXPECT(strstr(log, "Unknown key 'bogus_udp' in udp") != NULL);
+
+    EXPECT(seq_cnt == 1);
+    EXPECT(cfg->interface != NULL && strcmp(cfg->interface, "lo") == 0);
+    EXPECT(cfg->seq[0].threads == 2);
+    EXPECT(cfg->seq[0].udp.dst_port == 53);
+    EXPECT(strcmp(cfg->seq[0].ip.dst_ip, "10.0.0.1") == 0);
+
+    return 0;
+}
+
+static int check_invalid(const config_t *cfg, int seq_cnt, const char *log)
+{
+    const sequence_t *seq = &cfg->seq[0];
+
+    // Out of range values.
+    EXPECT(strstr(log, "'threads' in sequence of sequence #0 (out of range)") != NULL);
+    EXPECT(strstr(log, "'pps' in sequence of sequence #0 (out of range)") != NULL);
+    EXPECT(strstr(log, "'min' in ttl of sequence #0 (out of range)") != NULL);
+    EXPECT(strstr(log, "'sport' in udp of sequence #0 (out of range)") != NULL);
+
+    // Wrong types.
+    EXPECT(strstr(log, "'time' in sequence of sequence #0 (expected integer)") != NULL);
+    EXPECT(strstr(log, "'block' in sequence of sequence #0 (expected boolean)") != NULL);
+    EXPECT(strstr(log, "'interface' in sequence of sequence #0 (expected string)") != NULL);
+    EXPECT(strstr(log, "'min' in length of sequence #0 (expected integer)") != NULL);
+
+    // Invalid values keep their defaults and valid neighbours still apply.
+    EXPECT(seq_cnt == 1);
+    EXPECT(seq->threads == defaults.threads);
+    EXPECT(seq->pps == defaults.pps);
+    EXPECT(seq->time == defaults.time);
+    EXPECT(seq->block == defaults.block);
+    EXPECT(seq->interface == NULL);
+    EXPECT(seq->ip.min_ttl == defaults.ip.min_ttl);
+    EXPECT(seq->ip.max_ttl == 64);
+    EXPECT(seq->udp.src_port == defaults.udp.src_port);
+    EXPECT(seq->udp.dst_port == 80);
+    EXPECT(seq->pl_cnt == 1 && seq->pls[0].max_len == 100);
+
+    return 0;
+}
+
+static int check_fragments(const config_t *cfg, int seq_cnt, const char *log)
+{
+    EXPECT(seq_cnt == 3);
+
+    // Nested fragments apply before the fragment including them, later includes override earlier ones, and the sequence's own keys win.
+    EXPECT(cfg->seq[0].threads == 4);
+    EXPECT(cfg->seq[0].udp.dst_port == 53);
+    EXPECT(cfg->seq[1].threads == 3);
+    EXPECT(cfg->seq[2].threads == 2);
+
+    for (int i = 0; i < seq_cnt; i++)
+    {
+        const sequence_t *seq = &cfg->seq[i];
+
+        EXPECT(seq->time == 5);
+        EXPECT(seq->udp.src_port == 1);
+        EXPECT(i == 0 || seq->udp.dst_port == 9);
+        EXPECT(strcmp(seq->ip.dst_ip, "10.0.0.1") == 0);
+
+        // Every file a sequence depends on is listed once.
+        EXPECT(seq->include_count == 3);
+    }
+
+    return 0;
+}
+
+static int check_duplicates(const config_t *cfg, int seq_cnt, const char *log)
+{
+    // Both sequences include the same sequence file (and a copy of it) through different paths; its sequences are appended once.
+    EXPECT(seq_cnt == 4);
+    EXPECT(cfg->seq[0].time == 1);
+    EXPECT(cfg->seq[1].time == 2);
+    EXPECT(cfg->seq[2].time == 10);
+    EXPECT(cfg->seq[3].time == 11);
+
+    return 0;
+}
+
+static int check_cycle(const config_t *cfg, int seq_cnt, const char *log)
+{
+    // The fragment cycle is reported and each fragment applied once; the sequence file including the config back doesn't append it again.
+    EXPECT(strstr(log, "Skipping include cycle through") != NULL);
+    EXPECT(strstr(log, "nested too deeply") == NULL);
+
+    EXPECT(seq_cnt == 2);
+    EXPECT(cfg->seq[0].time == 1);
+    EXPECT(cfg->seq[0].threads == 6);
+    EXPECT(cfg->seq[1].time == 20);
+
+    return 0;
+}
+
+static int check_cycle_root(const config_t *cfg, int seq_cnt, const char *log)
+{
+    // The same cycle entered from the other file.
+    EXPECT(seq_cnt == 2);
+    EXPECT(cfg->seq[0].time == 20);
+    EXPECT(cfg->seq[1].time == 1);
+    EXPECT(cfg->seq[1].threads == 6);
+
+    return 0;
+}
+
+static int check_append(const config_t *cfg, int seq_cnt, const char *log)
+{
+    // Sequences appended with only_seq follow the ones already parsed, which survive the sequence array growing.
+    EXPECT(seq_cnt == 7);
+    EXPECT(cfg->seq[0].threads == 4 && cfg->seq[0].udp.dst_port == 53);
+    EXPECT(cfg->seq[2].threads == 2);
+    EXPECT(cfg->seq[3].time == 1);
+    EXPECT(cfg->seq[6].time == 11);
+
+    return 0;
+}
+
+static int check_ipv6(const config_t *cfg, int seq_cnt, const char *log)
+{
+    // Invalid IPv6 ranges and IPv6 weights are reported and skipped.
+    EXPECT(strstr(log, "'ranges' in ip of sequence #0 (invalid IPv6 range)") != NULL);
+    EXPECT(strstr(log, "'weight' in ip of sequence #0 (not supported for IPv6 ranges)") != NULL);
+
+    // Sequences mixing address families are reported and dropped.
+    EXPECT(strstr(log, "'ranges' in ip of sequence #1 (mixes IPv4 and IPv6 addresses)") != NULL);
+    EXPECT(strstr(log, "'sip' in ip of sequence #2 (mixes IPv4 and IPv6 addresses)") != NULL);
+
+    EXPECT(seq_cnt == 2);
+
+    const sequence_t *seq = &cfg->seq[0];
+
+    EXPECT(seq->time == 1 && seq->ip.is_ipv6);
+    EXPECT(seq->ip.range_count == 2);
+    EXPECT(strcmp(seq->ip.ranges[1], "2001:db8:2::/64") == 0 && seq->ip.range_weights[1] == 0);
+
+    seq = &cfg->seq[1];
+
+    EXPECT(seq->time == 4 && !seq->ip.is_ipv6);
+    EXPECT(seq->ip.range_tbl.count == 1 && seq->pl_cnt == 0);
+
+    return 0;
+}
+
+static const cfg_case_t cases[] =
+{
+    {"unknown.json", check_unknown},
+    {"invalid.json", check_invalid},
+    {"frag_main.json", check_fragments},
+    {"dup_main.json", check_duplicates},
+    {"cycle_main.json", check_cycle},
+    {"cycle_seqs.json", check_cycle_root},
+    {"ipv6.json", check_ipv6},
+    {"dup_main.json", check_append, "frag_main.json"},
+};
+
+int main(int argc, char *argv[])
+{
+    const char *dir = argc > 1 ? argv[1] : "./tests/fixtures/cfg";
+
+    config_t def;
+    init_config(&def);
+
+    if (reserve_sequences(&def, 1) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    defaults = def.seq[0];
+
+    int failed = 0;
+    char *log = malloc(LOG_MAX);
+
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, cases[i].file);
+
+        config_t cfg;
+        init_config(&cfg);
+
+        int seq_cnt = 0;
+        int ret = 0;
+
+        if (cases[i].first != NULL)
+        {
+            char first[512];
+            snprintf(first, sizeof(first), "%s/%s", dir, cases[i].first);
+
+            ret = parse_fixture(first, &cfg, 0, &seq_cnt, log);
+        }
+
+        if (ret == 0)
+        {
+            ret = parse_fixture(path, &cfg, cases[i].first != NULL, &seq_cnt, log);
+        }
+
+        fprintf(stdout, "%s: ", cases[i].file);
+
+        if (ret != 0)
+        {
+            fprintf(stdout, "parse failed (%d)\n%s", ret, log);
+
+            failed = 1;
+        }
+        else if (cases[i].check(&cfg, seq_cnt, log) != 0)
+        {
+            fprintf(stdout, "Diagnostics:\n%s", log);
+
+            failed = 1;
+        }
+        else
+        {
+            fprintf(stdout, "ok\n");
+        }
+
+        free_config(&cfg);
+    }
+
+    free(log);
+    free_config(&def);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -29,24 +29,18 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Create config structure.
-    struct config *cfg = malloc(sizeof(struct config));
-    memset(cfg, 0, sizeof(*cfg));
+    // Create config structure (sequences are allocated and set to their defaults while parsing).
+    struct config cfg;
+    init_config(&cfg);
 
     int seq_cnt = 0;
 
-    // Set default values on each sequence.
-    for (int i = 0; i < MAX_SEQUENCES; i++)
-    {
-        clear_sequence(cfg, i);
-    }
-
     // Attempt to parse config.
-    parse_config(cmd.config, cfg, 0, &seq_cnt, 0);
+    parse_config(cmd.config, &cfg, 0, &seq_cnt, 0);
 
-    print_config(cfg, seq_cnt);
+    print_config(&cfg, seq_cnt);
 
-    free(cfg);
+    free_config(&cfg);
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,481 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <csum.h>
+
+#define MAX_LEN 4096
+#define MAX_ALIGN 64
+
+static const char *kernel_names[CSUM_KERNEL_MAX] = { "auto", "generic", "x86", "avx2", "avx512" };
+
+// Packets for the header checksum tests (IPv4 header with options plus layer-4 data).
+#define PKT_MAX_L4 1400
+#define PKT_SIZE ((MAX_ALIGN + 60 + PKT_MAX_L4 + 63) & ~63)
+
+static const u8 pkt_protos[] = { IPPROTO_TCP, IPPROTO_UDP, IPPROTO_ICMP };
+
+/**
+ * Adds bytes to a reference one's complement sum as big-endian 16-bit words (RFC 1071).
+ *
+ * @param sum The running sum.
+ * @param p The bytes.
+ * @param len The amount of bytes.
+ *
+ * @return The new running sum.
+**/
+static u32 ref_add(u32 sum, const unsigned char *p, unsigned len)
+{
+    for (unsigned i = 0; i + 1 < len; i += 2)
+    {
+        sum += (p[i] << 8) | p[i + 1];
+    }
+
+    if (len & 1)
+    {
+        sum += p[len - 1] << 8;
+    }
+
+    return sum;
+}
+
+/**
+ * Folds and inverts a reference sum.
+ *
+ * @param sum The running sum.
+ *
+ * @return The checksum (host byte order).
+**/
+static u16 ref_fold(u32 sum)
+{
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return ~sum & 0xffff;
+}
+
+/**
+ * Retrieves a packet's layer-4 checksum offset.
+ *
+ * @param iph A pointer to the IPv4 header.
+ *
+ * @return The offset from the start of the layer-4 header.
+**/
+static unsigned ref_l4_check_off(const struct iphdr *iph)
+{
+    return iph->protocol == IPPROTO_TCP ? CSUM_TCP_CHECK_OFF : (iph->protocol == IPPROTO_UDP ? CSUM_UDP_CHECK_OFF : CSUM_ICMP_CHECK_OFF);
+}
+
+/**
+ * Computes a packet's IPv4 header and layer-4 checksums from scratch.
+ *
+ * @param iph A pointer to the IPv4 header (checksum fields are ignored).
+ * @param l3 A pointer to store the header checksum in (network byte order).
+ * @param l4 A pointer to store the layer-4 checksum in (network byte order).
+ *
+ * @return Void
+**/
+static void ref_csums(const struct iphdr *iph, u16 *l3, u16 *l4)
+{
+    unsigned char buf[PKT_SIZE];
+    unsigned hlen = iph->ihl * 4;
+    unsigned len = ntohs(iph->tot_len) - hlen;
+
+    memcpy(buf, iph, hlen + len);
+
+    struct iphdr *copy = (struct iphdr *)buf;
+    unsigned char *l4_hdr = buf + hlen;
+
+    copy->check = 0;
+    memset(l4_hdr + ref_l4_check_off(iph), 0, 2);
+
+    *l3 = htons(ref_fold(ref_add(0, buf, hlen)));
+
+    u32 sum = 0;
+
+    if (iph->protocol != IPPROTO_ICMP)
+    {
+        unsigned char pseudo[12];
+
+        memcpy(pseudo, &iph->saddr, 4);
+        memcpy(pseudo + 4, &iph->daddr, 4);
+        pseudo[8] = 0;
+        pseudo[9] = iph->protocol;
+        pseudo[10] = len >> 8;
+        pseudo[11] = len & 0xff;
+
+        sum = ref_add(sum, pseudo, sizeof(pseudo));
+    }
+
+    u16 check = ref_fold(ref_add(sum, l4_hdr, len));
+
+    if (check == 0 && iph->protocol == IPPROTO_UDP)
+    {
+        check = 0xffff;
+    }
+
+    *l4 = htons(check);
+}
+
+/**
+ * Builds a random IPv4 packet with valid checksums.
+ *
+ * @param buf The buffer to build the packet in (at least PKT_SIZE bytes).
+ * @param options Whether the header may carry options.
+ *
+ * @return A pointer to the IPv4 header.
+**/
+static struct iphdr *build_pkt(unsigned char *buf, int options)
+{
+    // Headers follow an Ethernet header, so they're only 2-byte aligned.
+    struct iphdr *iph = (struct iphdr *)(buf + (rand() % (MAX_ALIGN / 2)) * 2);
+    u8 proto = pkt_protos[rand() % sizeof(pkt_protos)];
+    unsigned hlen = (5 + (options ? rand() % 11 : 0)) * 4;
+    unsigned len = 20 + rand() % (PKT_MAX_L4 - 20 + 1);
+
+    for (unsigned i = 0; i < hlen + len; i++)
+    {
+        ((unsigned char *)iph)[i] = (unsigned char) rand();
+    }
+
+    iph->version = 4;
+    iph->ihl = hlen / 4;
+    iph->tot_len = htons(hlen + len);
+    iph->protocol = proto;
+
+    u16 l3, l4;
+    ref_csums(iph, &l3, &l4);
+
+    iph->check = l3;
+    memcpy((unsigned char *)iph + hlen + ref_l4_check_off(iph), &l4, 2);
+
+    return iph;
+}
+
+/**
+ * Checks a packet's checksums against ones computed from scratch.
+ *
+ * @param iph A pointer to the IPv4 header.
+ * @param what What produced the checksums (for the error message).
+ * @param check_l3 Whether to check the header checksum.
+ * @param check_l4 Whether to check the layer-4 checksum.
+ *
+ * @return 0 if they match or 1 otherwise.
+**/
+static int verify_pkt(const struct iphdr *iph, const char *what, int check_l3, int check_l4)
+{
+    u16 l3, l4, got_l4;
+    ref_csums(iph, &l3, &l4);
+
+    memcpy(&got_l4, (const unsigned char *)iph + iph->ihl * 4 + ref_l4_check_off(iph), 2);
+
+    if ((check_l3 && iph->check != l3) || (check_l4 && got_l4 != l4))
+    {
+        fprintf(stderr, "%s mismatch (proto => %u, ihl => %u, len => %u, l3 => %04x/%04x, l4 => %04x/%04x).\n", what, iph->protocol, iph->ihl, ntohs(iph->tot_len),
+            ntohs(iph->check), ntohs(l3), ntohs(got_l4), ntohs(l4));
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Checks that incrementally patched checksums (RFC 1624) match recomputing them over the patched packet.
+ *
+ * @return 0 if every case matched or 1 otherwise.
+**/
+static int check_patch()
+{
+    unsigned char *buf = aligned_alloc(64, PKT_SIZE);
+    int failed = 0;
+
+    for (int i = 0; i < 20000 && !failed; i++)
+    {
+        struct iphdr *iph = build_pkt(buf, 1);
+        unsigned hlen = iph->ihl * 4;
+        struct csum_patch patches[6];
+        int n = 0;
+
+        // Patch a random subset of the usual fields with random values.
+        while (n == 0)
+        {
+            if (rand() & 1)
+            {
+                patches[n++] = (struct csum_patch){ CSUM_PATCH_OFF_IP_ID, 2, (u16) rand() };
+            }
+
+            if (rand() & 1)
+            {
+                // TTL only, the protocol stays.
+                u16 word;
+                memcpy(&word, (unsigned char *)iph + CSUM_PATCH_OFF_IP_TTL, 2);
+                ((unsigned char *)&word)[0] = (unsigned char) rand();
+
+                patches[n++] = (struct csum_patch){ CSUM_PATCH_OFF_IP_TTL, 2, word };
+            }
+
+            if (rand() & 1)
+            {
+                patches[n++] = (struct csum_patch){ CSUM_PATCH_OFF_IP_SADDR, 4, (u32) rand() * 2654435761u };
+            }
+
+            if (rand() & 1)
+            {
+                patches[n++] = (struct csum_patch){ CSUM_PATCH_OFF_IP_DADDR, 4, (u32) rand() * 2246822519u };
+            }
+
+            if (iph->protocol != IPPROTO_ICMP && (rand() & 1))
+            {
+                patches[n++] = (struct csum_patch){ CSUM_PATCH_OFF_L4_SPORT(iph->ihl), 2, (u16) rand() };
+            }
+
+            if (iph->protocol != IPPROTO_ICMP && (rand() & 1))
+            {
+                patches[n++] = (struct csum_patch){ CSUM_PATCH_OFF_L4_DPORT(iph->ihl), 2, (u16) rand() };
+            }
+        }
+
+        // A disabled UDP checksum must stay disabled.
+        int udp_off = iph->protocol == IPPROTO_UDP && (rand() % 8) == 0;
+
+        if (udp_off)
+        {
+            memset((unsigned char *)iph + hlen + CSUM_UDP_CHECK_OFF, 0, 2);
+        }
+
+        csum_patch_ipv4(iph, patches, n, CSUM_PATCH_L3 | CSUM_PATCH_L4);
+
+        if (udp_off)
+        {
+            u16 check;
+            memcpy(&check, (unsigned char *)iph + hlen + CSUM_UDP_CHECK_OFF, 2);
+
+            if (check != 0)
+            {
+                fprintf(stderr, "csum_patch_ipv4 enabled a disabled UDP checksum.\n");
+
+                failed = 1;
+            }
+
+            failed |= verify_pkt(iph, "csum_patch_ipv4", 1, 0);
+        }
+        else
+        {
+            failed |= verify_pkt(iph, "csum_patch_ipv4", 1, 1);
+        }
+    }
+
+    if (!failed)
+    {
+        fprintf(stdout, "Incremental checksum patching checked.\n");
+    }
+
+    free(buf);
+
+    return failed;
+}
+
+/**
+ * Checks that the fused copy-and-checksum functions copy exactly and return what csum_partial() returns over the copy (bit for bit). The folded sum must also match the source's, which may sit at another alignment.
+ *
+ * @param src A source buffer of MAX_LEN + MAX_ALIGN random bytes.
+ * @param dst A destination buffer of the same size.
+ *
+ * @return 0 if every case matched or 1 otherwise.
+**/
+static int check_copy(const unsigned char *src, unsigned char *dst)
+{
+    int failed = 0;
+
+    for (int i = 0; i < 20000; i++)
+    {
+        unsigned len = rand() % (MAX_LEN + 1);
+        unsigned src_align = rand() % MAX_ALIGN;
+        unsigned dst_align = rand() % MAX_ALIGN;
+        __wsum sum = (__wsum)((unsigned)rand() * 2654435761u);
+
+        for (int nt = 0; nt < 2; nt++)
+        {
+            memset(dst, 0, MAX_LEN + MAX_ALIGN);
+
+            __wsum got = nt ? csum_partial_copy_nt(dst + dst_align, src + src_align, len, sum) : csum_partial_copy(dst + dst_align, src + src_align, len, sum);
+            __wsum exp = csum_partial(dst + dst_align, len, sum);
+
+            if (memcmp(dst + dst_align, src + src_align, len) != 0 || got != exp || csum_fold(csum_partial(src + src_align, len, sum)) != csum_fold(exp))
+            {
+                fprintf(stderr, "%s mismatch (src align => %u, dst align => %u, len => %u, expected => %08x, got => %08x).\n", nt ? "csum_partial_copy_nt" : "csum_partial_copy", src_align, dst_align, len, (unsigned)exp, (unsigned)got);
+
+                failed = 1;
+            }
+        }
+    }
+
+    if (!failed)
+    {
+        fprintf(stdout, "Copy and checksum checked.\n");
+    }
+
+    return failed;
+}
+
+/**
+ * Checks the batch checksum functions against computing each packet's checksums from scratch.
+ *
+ * @return 0 if every case matched or 1 otherwise.
+**/
+static int check_batch()
+{
+    enum { BATCH_MAX = 17 };
+
+    unsigned char *bufs[BATCH_MAX];
+    struct iphdr *hdrs[BATCH_MAX];
+    int failed = 0;
+
+    for (int i = 0; i < BATCH_MAX; i++)
+    {
+        bufs[i] = aligned_alloc(64, PKT_SIZE);
+    }
+
+    for (int iter = 0; iter < 3000 && !failed; iter++)
+    {
+        // Odd batch sizes cover the lanes left over after full SIMD groups.
+        int n = 1 + rand() % BATCH_MAX;
+        int kind = iter % 4;
+
+        for (int i = 0; i < n; i++)
+        {
+            // Only the header batch takes options (they use the fallback path); layer-4 batches share one protocol.
+            do
+            {
+                hdrs[i] = build_pkt(bufs[i], kind == 0 && (rand() % 4) == 0);
+            } while (kind > 0 && hdrs[i]->protocol != pkt_protos[kind - 1]);
+
+            // Scramble the checksums so stale values can't pass.
+            hdrs[i]->check = (u16) rand();
+
+            u16 junk = (u16) rand();
+            memcpy((unsigned char *)hdrs[i] + hdrs[i]->ihl * 4 + ref_l4_check_off(hdrs[i]), &junk, 2);
+        }
+
+        const char *what;
+
+        switch (kind)
+        {
+            case 0:
+                csum_batch_ipv4_hdr(hdrs, n);
+                what = "csum_batch_ipv4_hdr";
+
+                break;
+
+            case 1:
+                csum_batch_tcp(hdrs, n);
+                what = "csum_batch_tcp";
+
+                break;
+
+            case 2:
+                csum_batch_udp(hdrs, n);
+                what = "csum_batch_udp";
+
+                break;
+
+            default:
+                csum_batch_icmp(hdrs, n);
+                what = "csum_batch_icmp";
+
+                break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            failed |= verify_pkt(hdrs[i], what, kind == 0, kind > 0);
+        }
+    }
+
+    if (!failed)
+    {
+        fprintf(stdout, "Batch checksums checked.\n");
+    }
+
+    for (int i = 0; i < BATCH_MAX; i++)
+    {
+        free(bufs[i]);
+    }
+
+    return failed;
+}
+
+int main(int argc, char *argv[])
+{
+    // Reference kernel is the x86 assembly path when built in, the generic one otherwise.
+    csum_kernel_fn ref = csum_kernel_get(CSUM_KERNEL_X86);
+
+    if (ref == NULL)
+    {
+        ref = csum_kernel_get(CSUM_KERNEL_GENERIC);
+    }
+
+    unsigned char *buff = aligned_alloc(64, MAX_LEN + MAX_ALIGN);
+    int failed = 0;
+
+    // Run over random data first and all 0xFF bytes second to stress the carries.
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < MAX_LEN + MAX_ALIGN; i++)
+        {
+            buff[i] = pass ? 0xFF : (unsigned char) rand();
+        }
+
+        for (int k = CSUM_KERNEL_GENERIC; k < CSUM_KERNEL_MAX; k++)
+        {
+            csum_kernel_fn fn = csum_kernel_get(k);
+
+            if (fn == NULL)
+            {
+                continue;
+            }
+
+            for (unsigned align = 0; align < MAX_ALIGN; align++)
+            {
+                for (unsigned len = 0; len <= MAX_LEN; len++)
+                {
+                    unsigned exp = ref(buff + align, len);
+                    unsigned got = fn(buff + align, len);
+
+                    if (exp != got)
+                    {
+                        fprintf(stderr, "Kernel %s mismatch (align => %u, len => %u, expected => %08x, got => %08x).\n", kernel_names[k], align, len, exp, got);
+
+                        failed = 1;
+                    }
+                }
+            }
+
+            if (pass == 0)
+            {
+                fprintf(stdout, "Kernel %s checked.\n", kernel_names[k]);
+            }
+        }
+    }
+
+    // Random data for the functions built on top of the kernels.
+    for (int i = 0; i < MAX_LEN + MAX_ALIGN; i++)
+    {
+        buff[i] = (unsigned char) rand();
+    }
+
+    unsigned char *dst = aligned_alloc(64, MAX_LEN + MAX_ALIGN);
+
+    failed |= check_copy(buff, dst);
+    failed |= check_patch();
+    failed |= check_batch();
+
+    free(dst);
+    free(buff);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <decode.h>
+
+#define MAX_BYTES 1024
+
+static const char *kernel_names[HEX_KERNEL_MAX] = { "auto", "generic", "ssse3", "avx2" };
+
+/**
+ * Encodes bytes as hexadecimal in one of several layouts.
+ * 
+ * @param in The bytes.
+ * @param len The amount of bytes.
+ * @param out The output buffer (large enough for 4 characters per byte).
+ * @param layout 0 = contiguous, 1 = spaced, 2 = spaced with a newline every 16 bytes, 3 = random whitespace and case.
+ * 
+ * @return The string's length.
+**/
+static size_t encode(const unsigned char *in, size_t len, char *out, int layout)
+{
+    static const char upper[] = "0123456789ABCDEF";
+    static const char lower[] = "0123456789abcdef";
+    static const char spaces[] = " \t\n\r\v\f";
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        const char *digits = layout == 3 && (rand() & 1) ? lower : upper;
+
+        out[n++] = digits[in[i] >> 4];
+        out[n++] = digits[in[i] & 15];
+
+        if (layout == 1 || layout == 2)
+        {
+            out[n++] = layout == 2 && (i & 15) == 15 ? '\n' : ' ';
+        }
+        else if (layout == 3)
+        {
+            for (int j = rand() % 3; j > 0; j--)
+            {
+                out[n++] = spaces[rand() % 6];
+            }
+        }
+    }
+
+    return n;
+}
+
+int main(int argc, char *argv[])
+{
+    hex_kernel_fn ref = hex_kernel_get(HEX_KERNEL_GENERIC);
+
+    unsigned char *bytes = malloc(MAX_BYTES);
+    unsigned char *exp = malloc(MAX_BYTES);
+    unsigned char *got = malloc(MAX_BYTES);
+    char *hex = malloc(MAX_BYTES * 4 + 1);
+    int failed = 0;
+
+    for (int k = HEX_KERNEL_GENERIC; k < HEX_KERNEL_MAX; k++)
+    {
+        hex_kernel_fn fn = hex_kernel_get(k);
+
+        if (fn == NULL)
+        {
+            continue;
+        }
+
+        for (int layout = 0; layout < 4; layout++)
+        {
+            for (size_t len = 0; len <= MAX_BYTES; len += len < 100 ? 1 : 37)
+            {
+                for (size_t i = 0; i < len; i++)
+                {
+                    bytes[i] = (unsigned char) rand();
+                }
+
+                size_t hex_len = encode(bytes, len, hex, layout);
+
+                // Valid input decodes to the original bytes and counts without an output buffer.
+                long ret = fn(hex, hex_len, got, MAX_BYTES);
+
+                if (ret != (long)len || memcmp(got, bytes, len) != 0 || fn(hex, hex_len, NULL, 0) != (long)len)
+                {
+                    fprintf(stderr, "Kernel %s failed to decode (layout => %d, len => %zu, got => %ld).\n", kernel_names[k], layout, len, ret);
+
+                    failed = 1;
+                }
+
+                if (len > 0 && fn(hex, hex_len, got, len - 1) != -1)
+                {
+                    fprintf(stderr, "Kernel %s overflowed its output (layout => %d, len => %zu).\n", kernel_names[k], layout, len);
+
+                    failed = 1;
+                }
+
+                if (hex_len == 0)
+                {
+                    continue;
+                }
+
+                // Invalid characters, NULs, and odd digit counts must match the portable kernel.
+                size_t pos = rand() % hex_len;
+                char saved = hex[pos];
+                const char bad[] = { 'g', 'G', '\0', ' ', 'x', '\x80' };
+
+                hex[pos] = bad[rand() % sizeof(bad)];
+
+                long exp_ret = ref(hex, hex_len, exp, MAX_BYTES);
+                ret = fn(hex, hex_len, got, MAX_BYTES);
+
+                if (ret != exp_ret || (ret > 0 && memcmp(got, exp, ret) != 0))
+                {
+                    fprintf(stderr, "Kernel %s mismatch on bad input (layout => %d, len => %zu, pos => %zu, expected => %ld, got => %ld).\n", kernel_names[k], layout, len, pos, exp_ret, ret);
+
+                    failed = 1;
+                }
+
+                hex[pos] = saved;
+
+                if (fn(hex, hex_len - 1, got, MAX_BYTES) != ref(hex, hex_len - 1, exp, MAX_BYTES))
+                {
+                    fprintf(stderr, "Kernel %s mismatch on truncated input (layout => %d, len => %zu).\n", kernel_names[k], layout, len);
+
+                    failed = 1;
+                }
+            }
+        }
+
+        fprintf(stdout, "Kernel %s checked.\n", kernel_names[k]);
+    }
+
+    // Escape sequences.
+    const char esc[] = "a\\r\\n\\t\\\\\\\"\\x41\\x4\\101\\0\\7z";
+    const unsigned char esc_exp[] = { 'a', '\r', '\n', '\t', '\\', '"', 'A', 4, 'A', 0, 7, 'z' };
+    long esc_len = decode_escapes(esc, strlen(esc), got, MAX_BYTES);
+
+    if (esc_len != sizeof(esc_exp) || memcmp(got, esc_exp, sizeof(esc_exp)) != 0)
+    {
+        fprintf(stderr, "Escape decoding mismatch (got => %ld).\n", esc_len);
+
+        failed = 1;
+    }
+
+    if (decode_escapes("\\q", 2, got, MAX_BYTES) != -1 || decode_escapes("abc\\", 4, got, MAX_BYTES) != -1 || decode_escapes("abcd", 4, got, 3) != -1)
+    {
+        fprintf(stderr, "Escape decoding accepted invalid input.\n");
+
+        failed = 1;
+    }
+
+    free(bytes);
+    free(exp);
+    free(got);
+    free(hex);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <perm.h>
+
+typedef struct perm_case
+{
+    const char *ranges[4];
+    u16 port_min;
+    u16 port_max;
+} perm_case_t;
+
+static const perm_case_t cases[] =
+{
+    { { "10.0.0.1" }, 0, 0 },
+    { { "10.0.0.0/24" }, 0, 0 },
+    { { "10.0.0.0/30", "192.168.1.7", "172.16.0.0/22" }, 0, 0 },
+    { { "10.0.0.0/29", "10.1.0.0/28" }, 1000, 1012 },
+    { { "10.0.0.0/16" }, 0, 0 },
+};
+
+static const u32 thread_counts[] = { 1, 2, 3, 5, 8, 17 };
+
+// Passes each thread walks through.
+#define PASSES 3
+
+#define CASE_CNT (sizeof(cases) / sizeof(cases[0]))
+#define THREAD_CNT (sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+/**
+ * Maps an address and port back to their index in the permutation's domain.
+ *
+ * @param perm A pointer to the permutation.
+ * @param addr The address (network byte order).
+ * @param port The port (network byte order).
+ *
+ * @return The index or perm->size if the address or port isn't part of the domain.
+**/
+static u64 domain_index(const perm_t *perm, be32 addr, be16 port)
+{
+    u32 a = ntohl(addr);
+    u32 p = ntohs(port) - perm->port_min;
+
+    if (perm->port_count > 1 && p >= perm->port_count)
+    {
+        return perm->size;
+    }
+
+    for (u16 i = 0; i < perm->tbl->count; i++)
+    {
+        const ip_range_t *range = &perm->tbl->entries[i];
+
+        if ((a & ~range->mask) == range->base)
+        {
+            return (perm->offsets[i] + (a - range->base)) * perm->port_count + (perm->port_count > 1 ? p : 0);
+        }
+    }
+
+    return perm->size;
+}
+
+/**
+ * Checks perm_index() is a bijection over the domain.
+ *
+ * @param perm A pointer to the permutation.
+ * @param seen A zeroed buffer of perm->size bytes.
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_bijection(const perm_t *perm, u8 *seen)
+{
+    for (u64 i = 0; i < perm->size; i++)
+    {
+        u64 v = perm_index(perm, i);
+
+        if (v >= perm->size || seen[v])
+        {
+            fprintf(stderr, "Index %llu maps to %llu (size %llu).\n", (unsigned long long)i, (unsigned long long)v, (unsigned long long)perm->size);
+
+            return 1;
+        }
+
+        seen[v] = 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Walks every thread's slice for several passes, one thread after another so each thread ends up passes ahead of the ones still to run. Checks that the first
+ * pass of all slices together covers the domain exactly once and that later passes of a thread stay inside its own slice.
+ *
+ * @param perm A pointer to the permutation.
+ * @param threads The amount of threads.
+ * @param owner A zeroed buffer of perm->size u32s.
+ * @param visits A zeroed buffer of perm->size u8s.
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_slices(const perm_t *perm, u32 threads, u32 *owner, u8 *visits)
+{
+    for (u32 t = 0; t < threads; t++)
+    {
+        perm_cursor_t cur;
+        perm_cursor_init(perm, &cur, t, threads);
+
+        u64 slice = cur.end - cur.start;
+
+        for (u64 n = 0; n < slice * PASSES; n++)
+        {
+            be32 addr;
+            be16 port = 0;
+
+            int ret = perm_next(perm, &cur, &addr, perm->port_count > 1 ? &port : NULL);
+
+            if (ret != (n > 0 && n % slice == 0))
+            {
+                fprintf(stderr, "Thread %u of %u: perm_next() returned %d at step %llu of a %llu slice.\n", t, threads, ret, (unsigned long long)n, (unsigned long long)slice);
+
+                return 1;
+            }
+
+            u64 idx = domain_index(perm, addr, port);
+
+            if (idx >= perm->size)
+            {
+                fprintf(stderr, "Thread %u of %u: address %08x port %u is outside the domain.\n", t, threads, ntohl(addr), ntohs(port));
+
+                return 1;
+            }
+
+            // The first pass claims indexes, later passes may only revisit the thread's own.
+            if (n < slice ? owner[idx] != 0 : owner[idx] != t + 1)
+            {
+                fprintf(stderr, "Thread %u of %u (pass %llu): index %llu is outside its slice.\n", t, threads, (unsigned long long)(n / slice), (unsigned long long)idx);
+
+                return 1;
+            }
+
+            owner[idx] = t + 1;
+            visits[idx]++;
+        }
+    }
+
+    for (u64 i = 0; i < perm->size; i++)
+    {
+        if (visits[i] != PASSES)
+        {
+            fprintf(stderr, "Index %llu visited %u times with %u threads (expected %d).\n", (unsigned long long)i, visits[i], threads, PASSES);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int failed = 0;
+
+    for (unsigned i = 0; i < CASE_CNT; i++)
+    {
+        const perm_case_t *c = &cases[i];
+        u16 cnt = 0;
+
+        while (cnt < 4 && c->ranges[cnt] != NULL)
+        {
+            cnt++;
+        }
+
+        range_table_t tbl = {0};
+        perm_t perm;
+
+        if (compile_ranges(&tbl, (char **)c->ranges, NULL, cnt, NULL) < 0 || perm_init(&perm, &tbl, c->port_min, c->port_max, 0x1234 + i) != 0)
+        {
+            fprintf(stderr, "Failed to set up case #%u.\n", i);
+
+            failed = 1;
+
+            continue;
+        }
+
+        u8 *visits = calloc(perm.size, 1);
+        u32 *owner = calloc(perm.size, sizeof(u32));
+
+        if (check_bijection(&perm, visits) != 0)
+        {
+            failed = 1;
+        }
+
+        for (unsigned j = 0; j < THREAD_CNT; j++)
+        {
+            memset(visits, 0, perm.size);
+            memset(owner, 0, perm.size * sizeof(u32));
+
+            failed |= check_slices(&perm, thread_counts[j], owner, visits);
+        }
+
+        fprintf(stdout, "Case #%u (%llu addresses x %u ports) checked.\n", i, (unsigned long long)perm.addr_count, perm.port_count);
+
+        free(visits);
+        free(owner);
+
+        perm_free(&perm);
+        free_ranges(&tbl);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
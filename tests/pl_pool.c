@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <pl_pool.h>
+#include <csum.h>
+
+static const u32 counts[] = { 1, 3, 64, 1000, 4096 };
+static const int thread_counts[] = { 1, 2, 3, 4, 7, 8, 16, 64 };
+
+#define COUNT_CNT (sizeof(counts) / sizeof(counts[0]))
+#define THREAD_CNT (sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+/**
+ * Checks every entry's length, alignment, and partial checksum.
+ *
+ * @param pool A pointer to the pool.
+ * @param min_len The minimum payload length.
+ * @param max_len The maximum payload length.
+ *
+ * @return The amount of bad entries.
+**/
+static int check_entries(const pl_pool_t *pool, u16 min_len, u16 max_len)
+{
+    int bad = 0;
+
+    for (u32 i = 0; i < pool->count; i++)
+    {
+        const pl_pool_ent_t *ent = &pool->ents[i];
+
+        if (ent->len < min_len || ent->len > max_len || ((unsigned long)ent->data & 63) != 0 || ent->csum != csum_partial(ent->data, ent->len, 0))
+        {
+            fprintf(stderr, "Bad entry #%u (len => %u, data => %p).\n", i, ent->len, (const void *)ent->data);
+
+            bad++;
+        }
+    }
+
+    return bad;
+}
+
+/**
+ * Checks that every thread's cursor visits every entry exactly once per cycle.
+ *
+ * @param pool A pointer to the pool.
+ * @param threads The amount of threads.
+ *
+ * @return The amount of threads with incomplete coverage.
+**/
+static int check_cursors(const pl_pool_t *pool, int threads)
+{
+    u8 *seen = malloc(pool->count);
+    int bad = 0;
+
+    for (int t = 0; t < threads; t++)
+    {
+        pl_cursor_t cur;
+        pl_pool_cursor(pool, &cur, t, threads);
+
+        memset(seen, 0, pool->count);
+
+        u32 visited = 0;
+
+        for (u32 i = 0; i < pool->count; i++)
+        {
+            u32 idx = pl_pool_next(pool, &cur) - pool->ents;
+
+            if (idx >= pool->count || seen[idx])
+            {
+                break;
+            }
+
+            seen[idx] = 1;
+            visited++;
+        }
+
+        if (visited != pool->count)
+        {
+            fprintf(stderr, "Thread %d of %d visited %u of %u entries.\n", t, threads, visited, pool->count);
+
+            bad++;
+        }
+    }
+
+    free(seen);
+
+    return bad;
+}
+
+int main(int argc, char *argv[])
+{
+    int failed = 0;
+
+    for (unsigned i = 0; i < COUNT_CNT; i++)
+    {
+        pl_pool_t *pool = pl_pool_create(counts[i], 20, 1400, i + 1);
+
+        if (pool == NULL)
+        {
+            fprintf(stderr, "Failed to create pool of %u payloads.\n", counts[i]);
+
+            failed = 1;
+
+            continue;
+        }
+
+        if (pool->count < counts[i] || (pool->count & pool->mask) != 0)
+        {
+            fprintf(stderr, "Pool of %u payloads has %u entries.\n", counts[i], pool->count);
+
+            failed = 1;
+        }
+
+        failed |= check_entries(pool, 20, 1400) != 0;
+
+        for (unsigned j = 0; j < THREAD_CNT; j++)
+        {
+            failed |= check_cursors(pool, thread_counts[j]) != 0;
+        }
+
+        fprintf(stdout, "Pool of %u payloads (%u entries, %zu bytes) checked.\n", counts[i], pool->count, pool->mem_len);
+
+        pl_pool_free(pool);
+    }
+
+    // Pools that are empty, too large, or over the byte limit are rejected.
+    if (pl_pool_create(0, 1, 2, 1) != NULL || pl_pool_create(PL_POOL_MAX_COUNT + 1, 1, 2, 1) != NULL || pl_pool_create(PL_POOL_MAX_COUNT, 65535, 65535, 1) != NULL)
+    {
+        fprintf(stderr, "Invalid pool wasn't rejected.\n");
+
+        failed = 1;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <prng.h>
+
+// Amount of numbers filled per case (not a multiple of the batch block so partial blocks are covered).
+#define FILL_CNT 10007
+
+// Draws for the distribution checks.
+#define DRAWS 1000000
+
+typedef struct fill_case
+{
+    int size;
+    u32 min;
+    u32 max;
+} fill_case_t;
+
+static const fill_case_t fills[] =
+{
+    { 1, 0, 255 },
+    { 1, 64, 64 },
+    { 1, 1, 6 },
+    { 1, 30, 128 },
+    { 2, 0, 65535 },
+    { 2, 1000, 1999 },
+    { 2, 20, 1400 },
+    { 2, 5, 3 },
+};
+
+#define FILL_CASE_CNT (sizeof(fills) / sizeof(fills[0]))
+
+/**
+ * Steps a reference xoshiro256** state.
+ *
+ * @param s The state.
+ *
+ * @return The next number.
+**/
+static u64 ref_next(u64 *s)
+{
+    u64 result = prng_rotl(s[1] * 5, 7) * 9;
+    u64 t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = prng_rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Reference batch fill: steps each lane on its own and maps the 32-bit halves like prng_fill() does, redrawing rejected values from the scalar state.
+ * Blocks are 64 numbers (PRNG_BLOCK in prng.c) and whatever is left of the last block is dropped.
+ *
+ * @param p A pointer to a copy of the generator.
+ * @param out The output buffer.
+ * @param n The amount of numbers.
+ * @param min The minimum number.
+ * @param max The maximum number.
+ * @param size The size of each output element (1 or 2 bytes).
+ *
+ * @return Void
+**/
+static void ref_fill(prng_t *p, void *out, size_t n, u32 min, u32 max, int size)
+{
+    u32 range = max > min ? max - min + 1 : 1;
+    u32 t = -range % range;
+    u64 block[64];
+    size_t done = 0;
+
+    while (done < n)
+    {
+        for (int i = 0; i < 64; i += PRNG_LANES)
+        {
+            for (int j = 0; j < PRNG_LANES; j++)
+            {
+                u64 s[4] = { p->lanes[0][j], p->lanes[1][j], p->lanes[2][j], p->lanes[3][j] };
+
+                block[i + j] = ref_next(s);
+
+                for (int k = 0; k < 4; k++)
+                {
+                    p->lanes[k][j] = s[k];
+                }
+            }
+        }
+
+        const u32 *rnd = (const u32 *)block;
+
+        for (size_t i = 0; i < 128 && done < n; i++, done++)
+        {
+            u64 m = (u64)rnd[i] * range;
+
+            if ((u32)m < t)
+            {
+                m = (u64)prng_bounded(p, range) << 32;
+            }
+
+            u32 val = min + (u32)(m >> 32);
+
+            if (size == 1)
+            {
+                ((u8 *)out)[done] = (u8)val;
+            }
+            else
+            {
+                ((u16 *)out)[done] = (u16)val;
+            }
+        }
+    }
+}
+
+/**
+ * Checks the scalar generator against the reference and that seeding is deterministic.
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_scalar(void)
+{
+    prng_t a, b, c;
+
+    prng_seed(&a, 42);
+    prng_seed(&b, 42);
+    prng_seed(&c, 43);
+
+    u64 s[4];
+    memcpy(s, a.s, sizeof(s));
+
+    int same = 1;
+
+    for (int i = 0; i < 1000; i++)
+    {
+        u64 x = prng_next(&a);
+
+        if (x != ref_next(s) || x != prng_next(&b))
+        {
+            fprintf(stderr, "prng_next() diverged at step %d.\n", i);
+
+            return 1;
+        }
+
+        same &= x == prng_next(&c);
+    }
+
+    if (same)
+    {
+        fprintf(stderr, "Different seeds gave the same sequence.\n");
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Checks the batch fill functions against the reference fill.
+ *
+ * @param fc A pointer to the case.
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_fill(const fill_case_t *fc)
+{
+    static u16 out[FILL_CNT];
+    static u16 ref[FILL_CNT];
+
+    prng_t p, q;
+
+    prng_seed(&p, 0xfeed + fc->min);
+    q = p;
+
+    // Fill in uneven chunks so blocks straddle calls.
+    for (size_t off = 0, chunk = 1; off < FILL_CNT; off += chunk, chunk = chunk * 3 + 1)
+    {
+        size_t n = FILL_CNT - off < chunk ? FILL_CNT - off : chunk;
+
+        if (fc->size == 1)
+        {
+            prng_fill_u8(&p, (u8 *)out + off, n, fc->min, fc->max);
+            ref_fill(&q, (u8 *)ref + off, n, fc->min, fc->max, 1);
+        }
+        else
+        {
+            prng_fill_u16(&p, out + off, n, fc->min, fc->max);
+            ref_fill(&q, ref + off, n, fc->min, fc->max, 2);
+        }
+    }
+
+    if (memcmp(out, ref, FILL_CNT * fc->size) != 0)
+    {
+        fprintf(stderr, "prng_fill_u%d(%u, %u) differs from the reference.\n", fc->size * 8, fc->min, fc->max);
+
+        return 1;
+    }
+
+    u32 hi = fc->max > fc->min ? fc->max : fc->min;
+
+    for (size_t i = 0; i < FILL_CNT; i++)
+    {
+        u32 v = fc->size == 1 ? ((u8 *)out)[i] : out[i];
+
+        if (v < fc->min || v > hi)
+        {
+            fprintf(stderr, "prng_fill_u%d(%u, %u) gave %u.\n", fc->size * 8, fc->min, fc->max, v);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Checks prng_range() stays inside its bounds and every value of a small range is about equally likely.
+ *
+ * @param min The minimum number.
+ * @param max The maximum number (at most min + 15).
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_range(u32 min, u32 max)
+{
+    u32 counts[16] = {0};
+    u32 n = max - min + 1;
+
+    prng_t p;
+    prng_seed(&p, min ^ max);
+
+    for (int i = 0; i < DRAWS; i++)
+    {
+        u32 v = prng_range(&p, min, max);
+
+        if (v < min || v > max)
+        {
+            fprintf(stderr, "prng_range(%u, %u) gave %u.\n", min, max, v);
+
+            return 1;
+        }
+
+        counts[v - min]++;
+    }
+
+    // Far wider than the binomial spread at a million draws, but catches bias and stuck values.
+    for (u32 i = 0; i < n; i++)
+    {
+        double expect = (double)DRAWS / n;
+
+        if (counts[i] < expect * 0.97 || counts[i] > expect * 1.03)
+        {
+            fprintf(stderr, "prng_range(%u, %u) gave %u %u times (expected about %.0f).\n", min, max, min + i, counts[i], expect);
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int failed = check_scalar();
+
+    for (unsigned i = 0; i < FILL_CASE_CNT; i++)
+    {
+        failed |= check_fill(&fills[i]);
+    }
+
+    failed |= check_range(0, 1);
+    failed |= check_range(1, 6);
+    failed |= check_range(UINT32_MAX - 9, UINT32_MAX);
+
+    // Degenerate and full ranges.
+    prng_t p;
+    prng_seed(&p, 7);
+
+    if (prng_range(&p, 9, 9) != 9 || prng_range(&p, 9, 3) != 9)
+    {
+        fprintf(stderr, "prng_range() with max <= min didn't return min.\n");
+
+        failed = 1;
+    }
+
+    u32 ors = 0;
+
+    for (int i = 0; i < 64; i++)
+    {
+        ors |= prng_range(&p, 0, UINT32_MAX);
+    }
+
+    if (ors != UINT32_MAX)
+    {
+        fprintf(stderr, "prng_range(0, UINT32_MAX) never set some bits (%08x).\n", ors);
+
+        failed = 1;
+    }
+
+    // A thread keeps its generator across calls.
+    if (prng_thread() != prng_thread())
+    {
+        fprintf(stderr, "prng_thread() returned different generators for the same thread.\n");
+
+        failed = 1;
+    }
+
+    fprintf(stdout, "PRNG checked.\n");
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <arpa/inet.h>
+
+#include <ranges.h>
+#include <prng.h>
+
+// Draws for the sampling check.
+#define DRAWS 2000000
+
+typedef struct parse_case
+{
+    const char *range;
+    int ret;
+    u32 base;
+    u32 mask;
+} parse_case_t;
+
+static const parse_case_t parses[] =
+{
+    { "10.0.0.1", 0, 0x0a000001, 0 },
+    { "10.0.0.77/24", 0, 0x0a000000, 0xff },
+    { "192.168.1.0/32", 0, 0xc0a80100, 0 },
+    { "0.0.0.0/0", 0, 0, 0xffffffff },
+    { "172.16.5.4/12", 0, 0xac100000, 0xfffff },
+    { "10.0.0.0/33", -1, 0, 0 },
+    { "10.0.0.0/", -1, 0, 0 },
+    { "10.0.0.0/8x", -1, 0, 0 },
+    { "10.0.0/8", -1, 0, 0 },
+    { "2001:db8::/64", -1, 0, 0 },
+    { "", -1, 0, 0 },
+};
+
+typedef struct table_case
+{
+    const char *ranges[5];
+    u32 weights[5];
+} table_case_t;
+
+static const table_case_t tables[] =
+{
+    // Weighted by address count.
+    { { "10.0.0.0/24", "10.1.0.0/30", "10.2.0.1" } },
+    // Explicit weights (0 falls back to the address count).
+    { { "10.0.0.0/24", "10.1.0.0/16", "10.2.0.1" }, { 1, 3, 0 } },
+    { { "10.0.0.0/8", "192.168.0.1", "192.168.0.2", "172.16.0.0/28", "1.1.1.1" }, { 0, 1000000, 2, 0, 7 } },
+    { { "0.0.0.0/0" } },
+    { { "10.9.9.9" } },
+};
+
+#define PARSE_CNT (sizeof(parses) / sizeof(parses[0]))
+#define TABLE_CNT (sizeof(tables) / sizeof(tables[0]))
+
+/**
+ * Computes the weight compile_ranges() should give a range.
+ *
+ * @param tc A pointer to the case.
+ * @param i The range.
+ *
+ * @return The weight.
+**/
+static double expected_weight(const table_case_t *tc, int i)
+{
+    ip_range_t range;
+
+    parse_ip_range(tc->ranges[i], &range);
+
+    return tc->weights[i] > 0 ? (double)tc->weights[i] : (double)range.mask + 1.0;
+}
+
+/**
+ * Checks a compiled table's alias columns give every range exactly its share of the total weight and that sampled addresses stay inside their range
+ * (the ranges of a case must not overlap).
+ *
+ * @param tc A pointer to the case.
+ *
+ * @return 0 on success or 1 on failure.
+**/
+static int check_table(const table_case_t *tc)
+{
+    u16 cnt = 0;
+    double total = 0;
+
+    while (cnt < 5 && tc->ranges[cnt] != NULL)
+    {
+        total += expected_weight(tc, cnt);
+        cnt++;
+    }
+
+    range_table_t tbl = {0};
+
+    if (compile_ranges(&tbl, (char **)tc->ranges, tc->weights, cnt, NULL) != cnt || tbl.count != cnt)
+    {
+        fprintf(stderr, "Failed to compile '%s' (%u ranges).\n", tc->ranges[0], cnt);
+
+        free_ranges(&tbl);
+
+        return 1;
+    }
+
+    int failed = 0;
+
+    // A range's probability is what its own column keeps plus what other columns alias to it.
+    for (u16 i = 0; i < cnt; i++)
+    {
+        double p = 0;
+
+        for (u16 c = 0; c < cnt; c++)
+        {
+            const ip_range_t *col = &tbl.entries[c];
+            double keep = (col->prob == 0xffffffff) ? 1.0 : col->prob / 4294967296.0;
+
+            if (col->alias >= cnt)
+            {
+                fprintf(stderr, "Column %u of '%s' aliases to %u.\n", c, tc->ranges[0], col->alias);
+
+                failed = 1;
+            }
+
+            p += (c == i ? keep : 0) + (col->alias == i && c != i ? 1.0 - keep : 0);
+        }
+
+        p /= cnt;
+
+        double want = expected_weight(tc, i) / total;
+
+        if (fabs(p - want) > 1e-6)
+        {
+            fprintf(stderr, "Range '%s' is picked with probability %.9f instead of %.9f.\n", tc->ranges[i], p, want);
+
+            failed = 1;
+        }
+    }
+
+    // Sample the table and check each address lands in a range at about the right rate.
+    u32 *hits = calloc(cnt, sizeof(u32));
+    prng_t prng;
+
+    prng_seed(&prng, cnt);
+
+    for (int d = 0; d < DRAWS && hits != NULL; d++)
+    {
+        u32 addr = ntohl(range_table_rand(&tbl, prng_next(&prng)));
+        int found = 0;
+
+        for (u16 i = 0; i < cnt && !found; i++)
+        {
+            if ((addr & ~tbl.entries[i].mask) == tbl.entries[i].base)
+            {
+                hits[i]++;
+                found = 1;
+            }
+        }
+
+        if (!found)
+        {
+            fprintf(stderr, "Address %08x of '%s' isn't in any range.\n", addr, tc->ranges[0]);
+
+            failed = 1;
+
+            break;
+        }
+    }
+
+    for (u16 i = 0; i < cnt && hits != NULL; i++)
+    {
+        double want = expected_weight(tc, i) / total;
+
+        if (fabs((double)hits[i] / DRAWS - want) > 0.002 + want * 0.01)
+        {
+            fprintf(stderr, "Range '%s' got %.4f of the draws instead of %.4f.\n", tc->ranges[i], (double)hits[i] / DRAWS, want);
+
+            failed = 1;
+        }
+    }
+
+    free(hits);
+    free_ranges(&tbl);
+
+    return failed;
+}
+
+int main(int argc, char *argv[])
+{
+    int failed = 0;
+
+    for (unsigned i = 0; i < PARSE_CNT; i++)
+    {
+        const parse_case_t *pc = &parses[i];
+        ip_range_t range;
+
+        int ret = parse_ip_range(pc->range, &range);
+
+        if (ret != pc->ret || (ret == 0 && (range.base != pc->base || range.mask != pc->mask)))
+        {
+            fprintf(stderr, "parse_ip_range('%s') returned %d (base => %08x, mask => %08x).\n", pc->range, ret, ret == 0 ? range.base : 0, ret == 0 ? range.mask : 0);
+
+            failed = 1;
+        }
+    }
+
+    for (unsigned i = 0; i < TABLE_CNT; i++)
+    {
+        failed |= check_table(&tables[i]);
+    }
+
+    // Invalid ranges are skipped while the valid ones still compile.
+    const char *mixed[] = { "10.0.0.0/24", "bogus", "10.1.0.0/33", "10.2.0.0/16" };
+    range_table_t tbl = {0};
+
+    if (compile_ranges(&tbl, (char **)mixed, NULL, 4, NULL) != -1 || tbl.count != 2 || tbl.entries[1].base != 0x0a020000)
+    {
+        fprintf(stderr, "Invalid ranges weren't skipped (%u entries compiled).\n", tbl.count);
+
+        failed = 1;
+    }
+
+    free_ranges(&tbl);
+
+    // Without ranges the source IP is compiled on its own.
+    if (compile_ranges(&tbl, NULL, NULL, 0, "10.3.0.0/31") != 1 || tbl.count != 1 || tbl.entries[0].mask != 1)
+    {
+        fprintf(stderr, "The source IP wasn't compiled.\n");
+
+        failed = 1;
+    }
+
+    free_ranges(&tbl);
+
+    if (compile_ranges(&tbl, NULL, NULL, 0, NULL) != 0 || tbl.count != 0)
+    {
+        fprintf(stderr, "An empty table wasn't empty.\n");
+
+        failed = 1;
+    }
+
+    fprintf(stdout, "Ranges checked.\n");
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <reload.h>
+
+#define READERS 4
+#define RELOADS 300
+
+// Every snapshot's destination port is its generation plus this.
+#define PORT_BASE 1000
+
+typedef struct reader_ctx
+{
+    reload_t *rl;
+    int reader;
+    int stop;
+    u64 checked;
+    u64 failed;
+} reader_ctx_t;
+
+/**
+ * Writes the test config with a destination port for the next generation.
+ *
+ * @param path The config file.
+ * @param port The destination port.
+ *
+ * @return 0 on success or -1 on failure.
+**/
+static int write_config(const char *path, int port)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL)
+    {
+        return -1;
+    }
+
+    fprintf(fp, "{\"sequences\": [{\"interface\": \"lo\", \"eth\": {\"smac\": \"02:00:00:00:00:01\", \"dmac\": \"02:00:00:00:00:02\"}, "
+        "\"ip\": {\"sip\": \"10.0.0.1\", \"dip\": \"10.0.0.2\", \"protocol\": \"udp\"}, \"udp\": {\"dport\": %d}}]}\n", port);
+
+    fclose(fp);
+
+    return 0;
+}
+
+static void *reader_thread(void *arg)
+{
+    reader_ctx_t *ctx = arg;
+
+    while (!__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE))
+    {
+        const reload_snap_t *snap = reload_acquire(ctx->rl, ctx->reader);
+
+        // Hold the snapshot for a while like a sender batch would and check it stays intact.
+        for (int i = 0; i < 64; i++)
+        {
+            if (snap->plan.hot[0].dst_port != PORT_BASE + snap->generation)
+            {
+                ctx->failed++;
+
+                break;
+            }
+        }
+
+        ctx->checked++;
+
+        // Go offline now and then so readers also come back from RELOAD_OFFLINE.
+        if ((ctx->checked & 255) == 0)
+        {
+            reload_unregister(ctx->rl, ctx->reader);
+        }
+    }
+
+    reload_unregister(ctx->rl, ctx->reader);
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    char dir[] = "/tmp/reload_epoch.XXXXXX";
+
+    if (mkdtemp(dir) == NULL)
+    {
+        perror("mkdtemp");
+
+        return EXIT_FAILURE;
+    }
+
+    char path[256];
+    char cache[256];
+
+    snprintf(path, sizeof(path), "%s/conf.json", dir);
+    snprintf(cache, sizeof(cache), "%s/conf.json.pbc", dir);
+
+    reload_t rl;
+
+    if (write_config(path, PORT_BASE) != 0 || reload_init(&rl, path, cache, NULL, NULL, 0) != 0)
+    {
+        fprintf(stderr, "Failed to load initial config.\n");
+
+        return EXIT_FAILURE;
+    }
+
+    reader_ctx_t ctxs[READERS] = {0};
+    pthread_t threads[READERS];
+
+    for (int i = 0; i < READERS; i++)
+    {
+        ctxs[i].rl = &rl;
+        ctxs[i].reader = reload_register(&rl);
+
+        pthread_create(&threads[i], NULL, reader_thread, &ctxs[i]);
+    }
+
+    int failed = 0;
+
+    for (int i = 1; i <= RELOADS; i++)
+    {
+        if (write_config(path, PORT_BASE + i) != 0 || reload_config(&rl) != 0)
+        {
+            fprintf(stderr, "Reload #%d failed.\n", i);
+
+            failed = 1;
+
+            break;
+        }
+
+        reload_reclaim(&rl);
+    }
+
+    u64 checked = 0;
+
+    for (int i = 0; i < READERS; i++)
+    {
+        __atomic_store_n(&ctxs[i].stop, 1, __ATOMIC_RELEASE);
+
+        pthread_join(threads[i], NULL);
+
+        checked += ctxs[i].checked;
+
+        if (ctxs[i].failed > 0)
+        {
+            fprintf(stderr, "Reader #%d saw %llu inconsistent snapshots.\n", i, (unsigned long long)ctxs[i].failed);
+
+            failed = 1;
+        }
+    }
+
+    if (rl.cur->generation != RELOADS && !failed)
+    {
+        fprintf(stderr, "Expected generation %d, got %llu.\n", RELOADS, (unsigned long long)rl.cur->generation);
+
+        failed = 1;
+    }
+
+    reload_reclaim(&rl);
+    reload_free(&rl);
+
+    unlink(path);
+    unlink(cache);
+    rmdir(dir);
+
+    fprintf(stdout, "%d reloads, %llu snapshot reads checked.\n", RELOADS, (unsigned long long)checked);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}